@@ -10,7 +10,10 @@ namespace ag {
 
 
 void zero_grad(const Value& root);
-void backward (const Value& root, const Tensor* grad_seed=nullptr);
+// Frees the values, tapes and gradients of intermediate nodes no handle
+// refers to as soon as backward is done with them; retain_graph keeps
+// them, e.g. to call backward through the same graph again.
+void backward (const Value& root, const Tensor* grad_seed=nullptr, bool retain_graph=false);
 
 Tensor jvp (const Value& root, const std::unordered_map<Node*, Tensor>& seed);
 
@@ -4,6 +4,9 @@
 #pragma once
 #include "ad/graph.hpp"
 #include <unordered_set>
+#include <cstddef>
+#include <memory>
+#include <vector>
 
 namespace ag {
 namespace memory {
@@ -160,5 +163,50 @@ void sweep_safe_nodes(const Value& root, DeletePolicy policy = DeletePolicy::Alw
  */
 void debug_deletion_state();
 
+// ------------------------------------------------------------
+// Graph teardown / node reclaim
+// ------------------------------------------------------------
+
+/*
+ *  Graph teardown:
+ *  ----------------
+ *  Node::inputs holds parents by shared_ptr, so dropping the last Value of a
+ *  long chain used to run ~Node recursively, once per level. A million-step
+ *  unrolled graph would overflow the stack and stall the caller for the
+ *  whole teardown.
+ *
+ *  ~Node now hands its parents to reclaim_nodes(), which walks them with an
+ *  explicit worklist: a parent whose only owner is the worklist has its own
+ *  inputs moved onto the list before it is freed, so every ~Node runs with
+ *  empty inputs and the stack depth stays constant.
+ *
+ *  With background reclaim enabled the worklist is handed to a single
+ *  reclaim thread instead, which frees nodes in batches of
+ *  reclaim_batch_size() and releases its queue lock between batches. The
+ *  releasing thread only pays for one vector move.
+ *
+ *  Typical usage:
+ *      memory::set_background_reclaim(true);
+ *      { Value y = build_huge_graph(); backward(y); }   // returns immediately
+ *      memory::flush_reclaim();                           // optional: wait
+ */
+void set_background_reclaim(bool enabled);
+bool background_reclaim_enabled();
+
+// Nodes freed per batch (per lock hold on the background thread). Default 4096.
+void set_reclaim_batch_size(std::size_t n);
+std::size_t reclaim_batch_size();
+
+// Blocks until every node queued for background reclaim has been freed.
+void flush_reclaim();
+
+// Number of nodes freed by the reclaimer so far (both modes); for tests/profiling.
+std::size_t reclaimed_node_count();
+
+namespace detail {
+// Called from ~Node with the parents it was holding. Never recurses.
+void reclaim_nodes(std::vector<std::shared_ptr<Node>>&& pending);
+}
+
 } // namespace memory
 } // namespace ag
\ No newline at end of file
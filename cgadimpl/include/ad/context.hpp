@@ -0,0 +1,72 @@
+// =====================
+// file: cgadimpl/include/ad/context.hpp
+// =====================
+#pragma once
+#include <cstdint>
+#include "ad/kernels_api.hpp"
+#include "ad/runtime.hpp"
+#include "ad/inplace.hpp"
+
+namespace ag {
+
+/*
+ *  ExecutionContext:
+ *  ------------------
+ *  Everything the op path used to read from process globals, gathered in
+ *  one object that is bound to a thread:
+ *
+ *      - cpu       : this context's copy of the CPU kernel table. It is
+ *                    refreshed from the process registry only when a plugin
+ *                    is (re)loaded, so kernels::cpu() is a thread-local read.
+ *      - stream    : what current_stream() returns.
+ *      - inplace   : snapshot / version / alias tables (was g_lock-guarded).
+ *      - log_nodes : print every created node (debug::on_node_created).
+ *                    On by default for the historical behaviour; request
+ *                    threads usually switch it off since std::cout is shared.
+ *      - backward_threads : threads backward() may run VJPs on (the
+ *                    caller included). Above 1, independent VJPs of large
+ *                    graphs run concurrently on a shared work-stealing
+ *                    pool; the workers use this context meanwhile.
+ *      - cpu_pinned : while set, kernels::cpu() returns `cpu` as is and
+ *                    skips the registry refresh.
+ *
+ *  Every thread starts with its own default context, so N threads building
+ *  and running independent graphs share nothing on the op path. A context
+ *  can be bound explicitly with ContextScope, e.g. to hand a graph's state
+ *  from one worker to another; it must only be used by one thread at a time.
+ *  The one exception is a parallel backward(): its pool workers are bound to
+ *  the caller's context for the duration of the call, and only read it. The
+ *  kernel table is refreshed once up front and pinned until backward()
+ *  returns, so a plugin loaded meanwhile takes effect afterwards.
+ *
+ *  Typical usage:
+ *      ag::ExecutionContext ctx;
+ *      ctx.log_nodes = false;
+ *      ag::ContextScope scope(ctx);
+ *      Value y = relu(matmul(x, W));     // uses ctx's kernels/stream/state
+ */
+struct ExecutionContext {
+    kernels::Cpu cpu{};
+    uint64_t cpu_generation{0};    // registry generation `cpu` was copied from
+    ag_cuda_stream_t stream{nullptr};
+    inplace::State inplace;
+    bool log_nodes{true};
+    int backward_threads{1};
+    bool cpu_pinned{false};        // set by backward() while pool workers share this context
+};
+
+// The context bound to the calling thread (its default one if none is bound).
+ExecutionContext& current_context();
+
+// RAII: binds `ctx` to the calling thread, restores the previous on exit.
+class ContextScope {
+public:
+    explicit ContextScope(ExecutionContext& ctx);
+    ~ContextScope();
+    ContextScope(const ContextScope&) = delete;
+    ContextScope& operator=(const ContextScope&) = delete;
+private:
+    ExecutionContext* prev_;
+};
+
+} // namespace ag
@@ -26,7 +26,7 @@ JvpFn jvp_lookup(Op op);
 #ifdef AG_EXPOSE_AUTODIFF_RULES
 namespace ag::detail {
   // Declare all rule functions via the registry
-  #define OP(name, arity, str) \
+  #define OP(name, arity, str, ...) \
     void   vjp_##name(Node* n, const Tensor& gy); \
     Tensor jvp_##name(Node* n, const std::function<const Tensor&(Node*)>& tangent_of);
   #include "ad/detail/ops.def"
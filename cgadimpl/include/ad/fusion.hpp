@@ -0,0 +1,35 @@
+//============================================================
+// file: cgadimpl/include/ad/fusion.hpp
+//============================================================
+#pragma once
+#include "ad/graph.hpp"
+
+namespace ag {
+namespace fusion {
+
+/*
+ *  Pattern fusion on a built (eager) graph.
+ *
+ *  Layers written as act(matmul(x, W) + b) record three nodes: a GEMM
+ *  output, a broadcast add and the activation, each with its own buffer
+ *  and VJP. fuse_linear() rewrites those chains, in place, into the fused
+ *  ops from ops.hpp:
+ *
+ *      Add(MatMul(a, b), c)              ->  FMA(a, b, c)
+ *      Relu / GELU / SiLU(FMA(a, b, c))  ->  LinearRelu / LinearGELU / LinearSiLU
+ *
+ *  Values are left as computed; what changes is the backward (one fused
+ *  VJP per layer) and memory (the intermediates are released). Only
+ *  intermediates nothing else can observe are folded: no other node reads
+ *  them and no Value handle refers to them. jit::compile() runs the same
+ *  rewrite on its own plan (CompileOptions::fuse_linear).
+ */
+struct FusionStats {
+    int linear{0};       // MatMul + Add folded into FMA
+    int activation{0};   // FMA + activation folded into Linear*
+};
+
+FusionStats fuse_linear(const Value& root);
+
+} // namespace fusion
+} // namespace ag
@@ -2,7 +2,11 @@
 // file: cgadimpl/include/ag/graph.hpp (declarations only)
 // =====================
 #pragma once
+#include <cstddef>
+#include <functional>
+#include <list>
 #include <memory>
+#include <string>
 #include <vector>
 #include "tensor.hpp"
 #include "ad/schema.hpp"
@@ -20,6 +24,7 @@ Tensor value; // forward value
 Tensor grad; // same shape as value
 bool requires_grad{false};
 bool is_checkpoint{false};
+bool released{false}; // value/grad/tape freed by a backward() without retain_graph
 
 std::vector<Value> saved_inputs;
 std::vector<uint8_t> saved_rng_blob;
@@ -31,6 +36,9 @@ std::vector<std::shared_ptr<Tensor>> tape;// optional: for ops that need to save
 
 Node();
 Node(const Tensor& v, bool rg, Op op_, const char* nm="");
+// Non-recursive: parents are released through memory::detail::reclaim_nodes
+// so that dropping a very deep graph cannot overflow the stack.
+~Node();
 };
 
 
@@ -42,7 +50,7 @@ explicit Value(std::shared_ptr<Node> n);
 
 const Tensor& val() const;
 Tensor& grad();
-std::pair<int,int> shape() const;
+std::pair<int64_t,int64_t> shape() const;
 };
 
 // new factory function
@@ -56,12 +64,108 @@ Value param (const Tensor& v, const char* name="param");
 // Topological order from root (parents before child)
 std::vector<Node*> topo_from(Node* root);
 
+namespace trace { class Tracer; }
+
     
 // ---- Lightweight trace→compile→replay (CPU) ----
 namespace jit {
 
 struct CompileOptions {
     bool use_cuda_graph = false; // ignored for now (no CUDA)
+    // Liveness-based buffer planning: slots whose lifetimes do not overlap
+    // share one arena buffer, and elementwise steps overwrite an input that
+    // dies at that step. Off = one buffer per slot (debugging aid).
+    bool reuse_buffers = true;
+    // Chains of elementwise steps (optionally ending in a reduction) run as
+    // one row-tiled loop; their intermediates are never written to memory.
+    bool fuse_elementwise = true;
+    // Also compile the backward pass: run() with a grads list then returns
+    // d(sum of output)/d(param i) for every param (with several outputs,
+    // of the sum over all of them, e.g. a loss plus auxiliary losses), replaying the VJPs as
+    // planned steps instead of building and walking an autodiff graph.
+    bool with_grads = false;
+    // Graph passes, run before fusion (each can be turned off on its own):
+    //   fold_constants    steps reading only literals are evaluated once
+    //   eliminate_common  identical steps are computed once
+    //   eliminate_dead    steps no output depends on are dropped
+    //   pretranspose      Transpose of a literal is stored transposed (a
+    //                     subset of fold_constants, for when that is off)
+    bool fold_constants = true;
+    bool eliminate_common = true;
+    bool eliminate_dead = true;
+    bool pretranspose = true;
+    // Threads that execute steps (the caller counts as one). Above 1,
+    // independent steps run concurrently in dependency order; steps bound
+    // to OpenMP plugin kernels still run alone so cores are not
+    // oversubscribed. Only the first of several concurrent run() calls
+    // uses the pool; the others replay on their own thread.
+    int inter_op_threads = 1;
+    // MatMul + bias becomes one FMA step, and Relu/GELU/SiLU of it one
+    // LinearRelu/GELU/SiLU step, so the GEMM's output pass applies both
+    // (see fusion.hpp for the eager graph). With with_grads, GELU and
+    // SiLU stay separate steps, as their VJPs need the pre-activation.
+    bool fuse_linear = true;
+};
+
+// Compiled::quantize() settings.
+struct QuantOptions {
+    // One weight scale per output column (channel); false = one per
+    // weight tensor. Activations always get one scale per tensor.
+    bool per_channel = true;
+};
+
+// What compile() produced; cheap to query, useful in tests and logs.
+struct PlanStats {
+    int         steps{0};
+    int         slots{0};          // one per computed value
+    int         buffers{0};        // arena buffers after liveness planning
+    int         in_place{0};       // steps writing over a dying input
+    std::size_t arena_bytes{0};    // what run() keeps allocated
+    std::size_t naive_bytes{0};    // sum of all slot sizes (no reuse)
+    int         fused_groups{0};   // fused steps in the plan
+    int         fused_steps{0};    // original steps folded into them
+    std::size_t bytes_moved{0};    // estimated memory traffic per run()
+    int         plugin_kernels{0}; // steps/stages bound to CPU plugin kernels
+    int         folded{0};         // steps evaluated at compile time
+    int         merged{0};         // duplicate steps folded into an earlier one
+    int         removed{0};        // steps dropped as unreachable from the outputs
+    int         critical_path{0};  // steps on the longest dependency chain
+    int         threads{1};        // threads run() executes steps on
+    int         outputs{1};        // values run() returns
+    int         linear_fused{0};   // MatMul/activation steps folded into GEMM steps
+    int         quantized{0};      // GEMM steps running in int8 (quantize())
+    int         int8_links{0};     // of those, steps handing int8 to the next one
+    std::size_t literal_bytes{0};  // embedded literals (held in the weight store)
+};
+
+// Literal tensors embedded in plans (constant leaves, folded constants,
+// pretransposed weights) live in one process-wide, refcounted store: plans
+// whose literals have the same shape and value, such as replicas, batch
+// buckets or loaded copies of one model, reference a single read-only
+// copy, released with the last plan using it. weight_stats() reports it.
+struct WeightStats {
+    std::size_t weights{0};           // distinct values held
+    std::size_t resident_bytes{0};    // their storage, each counted once
+    std::size_t references{0};        // plan literals pointing at them
+    std::size_t referenced_bytes{0};  // what those would take as private copies
+};
+WeightStats weight_stats();
+
+// Run state for Compiled::run: the planned arena buffers and argument
+// tables. Keep one per thread (or per caller) to run a shared Compiled
+// concurrently with no locking, and with no allocation once it has grown
+// to the plan. One workspace may serve several plans, one run at a time.
+class Workspace {
+public:
+    Workspace();
+    ~Workspace();
+    Workspace(Workspace&&) noexcept;
+    Workspace& operator=(Workspace&&) noexcept;
+
+    struct State;   // opaque
+private:
+    friend struct Compiled;
+    std::unique_ptr<State> s_;
 };
 
 struct Compiled {
@@ -70,9 +174,85 @@ struct Compiled {
     std::shared_ptr<Impl> p;
 
     // Run with external inputs/params. Returns false if shape guard fails.
+    // Steps write straight into the planned arena; once `out` has the right
+    // shape it is filled in place, so steady-state calls do not allocate.
+    bool run(const std::vector<Tensor*>& inputs,
+             const std::vector<Tensor*>& params,
+             Tensor& out) const;
+
+    // Same, plus grads[i] = d(sum of out)/d(params[i]) (resized if needed).
+    // Needs CompileOptions::with_grads; throws otherwise.
     bool run(const std::vector<Tensor*>& inputs,
+             const std::vector<Tensor*>& params,
+             Tensor& out,
+             const std::vector<Tensor*>& grads) const;
+
+    // The overloads above use a workspace cached in the plan, or, when
+    // another thread holds it, a thread-local one. These use the caller's
+    // instead and never touch shared state, so any number of threads can
+    // run one plan at once. They execute steps on the calling thread only
+    // (inter_op_threads applies to the cached workspace).
+    bool run(Workspace& ws,
+             const std::vector<Tensor*>& inputs,
              const std::vector<Tensor*>& params,
              Tensor& out) const;
+    bool run(Workspace& ws,
+             const std::vector<Tensor*>& inputs,
+             const std::vector<Tensor*>& params,
+             Tensor& out,
+             const std::vector<Tensor*>& grads) const;
+
+    // Multi-output plans: outs[k] receives output k, in the order given to
+    // compile(); the overloads above return output 0 only. With an empty
+    // grads list a with_grads plan still executes its backward steps and
+    // only skips copying the gradients out; compile without with_grads for
+    // forward-only replay. Throws if outs has the wrong length.
+    bool run(const std::vector<Tensor*>& inputs,
+             const std::vector<Tensor*>& params,
+             const std::vector<Tensor*>& outs,
+             const std::vector<Tensor*>& grads = {}) const;
+    bool run(Workspace& ws,
+             const std::vector<Tensor*>& inputs,
+             const std::vector<Tensor*>& params,
+             const std::vector<Tensor*>& outs,
+             const std::vector<Tensor*>& grads = {}) const;
+
+    PlanStats stats() const;
+
+    // Post-training int8 quantisation for CPU serving. Between
+    // calibrate(true) and calibrate(false), run() also records the range
+    // of the activation operand of every GEMM step (MatMul, FMA, Linear*)
+    // whose weight is a param or literal; such runs go step by step on the
+    // calling thread. quantize() then returns a copy of the plan in which
+    // those steps run int8 x int8 -> int32 with a float epilogue (scale,
+    // bias, activation), and chained ones pass int8 between them. The
+    // weights are taken from `params` now: the quantised plan keeps the
+    // same signature but ignores later values of those params. Throws for
+    // plans with gradients or when nothing was calibrated.
+    void calibrate(bool on);
+    Compiled quantize(const std::vector<Tensor*>& params, const QuantOptions& opts = {}) const;
+
+    // Write the plan to a versioned binary file, and read one back. A
+    // loaded plan behaves like the compiled one (same signature, outputs,
+    // buffer plan and options) without tracing the graph again; the buffer
+    // plan is re-derived from the steps rather than read back. Kernels
+    // are bound against the CPU plugin loaded at load() time. Both throw
+    // std::runtime_error on I/O errors; load() also on a foreign, corrupt
+    // or other-version file.
+    void save(const std::string& path) const;
+    static Compiled load(const std::string& path);
+
+    // Ahead-of-time compilation. emit_cpp() writes the plan as a standalone
+    // C++ source file: shapes and arena offsets are constants, fused groups
+    // are single loops, matmul/unary steps call the CPU plugin, and steps
+    // it has no code for (the backward ones) call back into the
+    // interpreter. load_aot() opens such a file built as a shared object
+    // and returns a Compiled whose run() executes it; it throws if the
+    // object was generated from a different plan. build_aot() does all
+    // three with `cxx` (default: $CXX, else c++), writing stem.cpp/stem.so.
+    void emit_cpp(const std::string& path) const;
+    Compiled load_aot(const std::string& so_path) const;
+    Compiled build_aot(const std::string& stem, const std::string& cxx = "") const;
 };
 
 // Build a compiled plan from a finished forward Value (dynamic graph).
@@ -82,6 +262,87 @@ Compiled compile(const Value& output,
                  const std::vector<Value>& params,
                  const CompileOptions& opts = {});
 
+// One plan computing several outputs (e.g. a trunk with several heads, or
+// a loss with metrics): shared intermediates are computed once. Throws if
+// an output is a leaf.
+Compiled compile(const std::vector<Value>& outputs,
+                 const std::vector<Value>& inputs,
+                 const std::vector<Value>& params,
+                 const CompileOptions& opts = {});
+
+// Compile what a Tracer captured: its outputs() in capture order. Marked
+// outputs are compiled as given; detected ones (the captured values
+// nothing else in the capture consumes) drop leaves and values another
+// candidate depends on.
+Compiled compile(const trace::Tracer& capture,
+                 const std::vector<Value>& inputs,
+                 const std::vector<Value>& params,
+                 const CompileOptions& opts = {});
+
+// ---- Plan cache for inputs whose batch size varies ----
+//
+// A Compiled plan only replays the shapes it was traced with. PlanCache
+// keeps one plan per input signature, tracing and compiling on a miss, and
+// drops the least recently used plan beyond `capacity`.
+//
+// With pad_batch, forward runs round the batch (rows of input 0; every
+// input with that many rows is padded) up to a bucket, so nearby sizes
+// share a plan: the inputs are copied into zero-padded staging tensors and
+// the first `batch` rows of the output are returned. That is only correct
+// for graphs that are row-independent along the batch (no reductions over
+// it, e.g. per-sample logits). A forward run throws std::runtime_error when
+// the output does not have one row per sample; runs with gradients always
+// use exact shapes.
+struct CacheOptions {
+    std::size_t capacity = 8;        // plans kept; 0 = unbounded
+    bool pad_batch = false;
+    std::vector<int64_t> buckets;    // ascending; empty = powers of two
+    CompileOptions compile;          // used for every plan
+};
+
+struct CacheStats {
+    std::size_t hits{0};
+    std::size_t misses{0};           // traces + compiles
+    std::size_t evictions{0};
+    std::size_t plans{0};            // currently cached
+};
+
+class PlanCache {
+public:
+    // Traces the graph for a signature: called with leaf Values holding
+    // the (possibly padded) inputs and the params, returns the output.
+    using Builder = std::function<Value(const std::vector<Value>& inputs,
+                                        const std::vector<Value>& params)>;
+
+    explicit PlanCache(Builder build, CacheOptions opts = {});
+    ~PlanCache();
+
+    // Same contract as Compiled::run, except that a new signature compiles
+    // a plan instead of failing. Not thread-safe: use one cache per thread.
+    bool run(const std::vector<Tensor*>& inputs,
+             const std::vector<Tensor*>& params,
+             Tensor& out);
+    bool run(const std::vector<Tensor*>& inputs,
+             const std::vector<Tensor*>& params,
+             Tensor& out,
+             const std::vector<Tensor*>& grads);
+
+    // Rows a batch of `n` runs with (n itself without pad_batch).
+    int64_t bucket(int64_t n) const;
+    CacheStats stats() const;
+    void clear();
+
+private:
+    struct Entry;
+    Entry& lookup(const std::vector<Tensor*>& inputs, const std::vector<Tensor*>& params,
+                  int64_t rows, bool pad);
+
+    Builder build_;
+    CacheOptions opts_;
+    std::list<Entry> lru_;           // most recently used first
+    CacheStats stats_;
+};
+
 } // namespace jit
 
 } // namespace ag
@@ -121,6 +121,19 @@ struct SnapshotEntry {
     size_t version_at_save = 0;  // Version when snapshot was created.
 };
 
+/*
+ *  State:
+ *  -------
+ *  All in-place bookkeeping (snapshots, version counters, alias groups).
+ *  One instance lives in each ag::ExecutionContext, so graphs built on
+ *  different threads never touch the same maps and need no lock.
+ */
+struct State {
+    std::unordered_map<Node*, SnapshotEntry> snapshots;
+    std::unordered_map<Node*, TensorMeta>    meta;
+    std::unordered_map<void*, std::unordered_set<Node*>> alias;
+};
+
 // -----------------------------------------------------------------------------
 // Inplace Checkpoint API
 // -----------------------------------------------------------------------------
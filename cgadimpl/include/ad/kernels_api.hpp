@@ -17,11 +17,16 @@ extern "C" {
 
 // Keep existing:
 static const uint32_t AG_KERNELS_ABI_V1 = 1;
+// V2: identical table layout, but every dimension argument (M/K/N, B/In/Out)
+// is int64_t so that matrices with more than 2^31 elements can be indexed.
+static const uint32_t AG_KERNELS_ABI_V2 = 2;
+// V3: the V2 table followed by `gemm`.
+static const uint32_t AG_KERNELS_ABI_V3 = 3;
 
 // Plain C function-pointer types (no Tensor types here)
 typedef void (*ag_relu_fn)(const float* x, float* y, int64_t n);
 typedef void (*ag_matmul_fn)(const float* A, const float* B, float* C,
-                             int M, int K, int N);                             
+                             int64_t M, int64_t K, int64_t N);
 typedef void (*ag_gelu_fn)(const float* x, float* y, int64_t n);
 typedef void (*ag_leakyrelu_fn)(const float* x, float* y, int64_t n, float alpha);
 typedef void (*ag_sigmoid_fn)(const float* x, float* y, int64_t n);
@@ -31,13 +36,29 @@ typedef void (*ag_exp_fn)(const float* x, float* y, int64_t n);
 typedef void (*ag_log_fn)(const float* x, float* y, int64_t n);
 typedef void (*ag_sqrt_fn) (const float* x, float* y, int64_t n);
 typedef void (*ag_pow_fn) (const float* x, float* y, int64_t n, float exponent);
-typedef void (*ag_linear_fn)(const float* X,const float* W,const float* b,float* Y,int B,int In,int Out);
+typedef void (*ag_linear_fn)(const float* X,const float* W,const float* b,float* Y,int64_t B,int64_t In,int64_t Out);
 // CPU function table (can be partially filled; nulls mean "not provided")
 typedef void (*elem_bwd_fn)(const float*, const float*, float*, int64_t);
 typedef void (*elem_bwd_alpha_fn)(const float*, const float*, float*, int64_t, float);
-typedef void (*ag_linear_dW_fn)(const float* X, const float* dY, float* dW, int B, int In, int Out);
-typedef void (*ag_linear_dX_fn)(const float* dY, const float* W, float* dX, int B, int In, int Out);
-typedef void (*ag_linear_db_fn)(const float* dY, float* db, int B, int Out);
+typedef void (*ag_matmul_bwd_fn)(const float*, const float*, float*, int64_t M, int64_t K, int64_t N);
+typedef void (*ag_linear_dW_fn)(const float* X, const float* dY, float* dW, int64_t B, int64_t In, int64_t Out);
+typedef void (*ag_linear_dX_fn)(const float* dY, const float* W, float* dX, int64_t B, int64_t In, int64_t Out);
+typedef void (*ag_linear_db_fn)(const float* dY, float* db, int64_t B, int64_t Out);
+// C = alpha * op(A) @ op(B) + beta * C, row-major, BLAS argument order.
+// op(A) is [M,K] (A itself is [K,M] when trans_a), op(B) is [K,N]; lda,
+// ldb and ldc are the row strides of A, B and C as stored. beta == 0
+// overwrites C without reading it (it may hold garbage or NaNs).
+typedef void (*ag_gemm_fn)(int trans_a, int trans_b, int64_t M, int64_t N, int64_t K,
+                           float alpha, const float* A, int64_t lda,
+                           const float* B, int64_t ldb,
+                           float beta, float* C, int64_t ldc);
+
+// Legacy 32-bit dimension signatures, only used by the ag_cpu_v1 table.
+typedef void (*ag_matmul_v1_fn)(const float* A, const float* B, float* C, int M, int K, int N);
+typedef void (*ag_linear_v1_fn)(const float* X,const float* W,const float* b,float* Y,int B,int In,int Out);
+typedef void (*ag_linear_dW_v1_fn)(const float* X, const float* dY, float* dW, int B, int In, int Out);
+typedef void (*ag_linear_dX_v1_fn)(const float* dY, const float* W, float* dX, int B, int In, int Out);
+typedef void (*ag_linear_db_v1_fn)(const float* dY, float* db, int B, int Out);
 
 void leakyrelu_bwd_impl_optimized(const float* x, const float* dY, float* dX, int64_t n, float alpha);
 void sigmoid_bwd_impl_optimized_from_s(const float* s, const float* dY, float* dX, int64_t n);
@@ -47,18 +68,22 @@ void softplus_bwd_impl_optimized(const float* x, const float* dY, float* dX, int
 void exp_bwd_impl_optimized_from_y(const float* y, const float* dY, float* dX, int64_t n);
 void log_bwd_impl_optimized(const float* x, const float* dY, float* dX, int64_t n);
 void sqrt_bwd_impl_optimized_from_y(const float* y, const float* dY, float* dX, int64_t n);
-void matmul_bwd_dA_impl_optimized(const float* dC, const float* B, float* dA, int M, int K, int N);
-void matmul_bwd_dB_impl_optimized(const float* A, const float* dC, float* dB, int M, int K, int N);
-void linear_dW_impl_optimized(const float* X, const float* dY, float* dW, int B, int In, int Out);
-void linear_dX_impl_optimized(const float* dY, const float* W, float* dX, int B, int In, int Out);
-void linear_db_impl_optimized(const float* dY, float* db, int B, int Out);
+void matmul_bwd_dA_impl_optimized(const float* dC, const float* B, float* dA, int64_t M, int64_t K, int64_t N);
+void matmul_bwd_dB_impl_optimized(const float* A, const float* dC, float* dB, int64_t M, int64_t K, int64_t N);
+void linear_dW_impl_optimized(const float* X, const float* dY, float* dW, int64_t B, int64_t In, int64_t Out);
+void linear_dX_impl_optimized(const float* dY, const float* W, float* dX, int64_t B, int64_t In, int64_t Out);
+void linear_db_impl_optimized(const float* dY, float* db, int64_t B, int64_t Out);
 void relu_bwd_impl_optimized(const float* x, const float* dY, float* dX, int64_t n);
+void gemm_impl_optimized(int trans_a, int trans_b, int64_t M, int64_t N, int64_t K,
+                         float alpha, const float* A, int64_t lda, const float* B, int64_t ldb,
+                         float beta, float* C, int64_t ldc);
 
 // CPU function table (can be partially filled; nulls mean "not provided")
+// V1 is kept so that plugins built against the old header still load.
 struct ag_cpu_v1 {
   uint32_t abi_version;   // must be AG_KERNELS_ABI_V1
   ag_relu_fn   relu; //done
-  ag_matmul_fn matmul; //done
+  ag_matmul_v1_fn matmul; //done
   ag_gelu_fn gelu;   //done
   ag_leakyrelu_fn leakyrelu;   //done
   ag_sigmoid_fn sigmoid; //done
@@ -68,7 +93,7 @@ struct ag_cpu_v1 {
   ag_log_fn log; //done
   ag_sqrt_fn sqrt; //done
   ag_pow_fn pow;
-  ag_linear_fn linear;
+  ag_linear_v1_fn linear;
   //backwards
   elem_bwd_fn relu_bwd;  //done
   elem_bwd_alpha_fn leakyrelu_bwd; // takes alpha  //done
@@ -82,15 +107,84 @@ struct ag_cpu_v1 {
   // matmul backward wrappers
   void (*matmul_bwd_dA)(const float*, const float*, float*, int M, int K, int N); 
   void (*matmul_bwd_dB)(const float*, const float*, float*, int M, int K, int N);
-  ag_linear_dW_fn linear_dW;
-  ag_linear_dX_fn linear_dX;  
-  ag_linear_db_fn linear_db;
+  ag_linear_dW_v1_fn linear_dW;
+  ag_linear_dX_v1_fn linear_dX;  
+  ag_linear_db_v1_fn linear_db;
 
 };
 
 
 AG_EXPORT int ag_get_cpu_kernels_v1(struct ag_cpu_v1* out);
 
+// CPU function table, 64-bit dimensions. The loader prefers this one.
+struct ag_cpu_v2 {
+  uint32_t abi_version;   // must be AG_KERNELS_ABI_V2
+  ag_relu_fn   relu;
+  ag_matmul_fn matmul;
+  ag_gelu_fn gelu;
+  ag_leakyrelu_fn leakyrelu;
+  ag_sigmoid_fn sigmoid;
+  ag_tanh_fn tanh;
+  ag_softplus_fn softplus;
+  ag_exp_fn exp;
+  ag_log_fn log;
+  ag_sqrt_fn sqrt;
+  ag_pow_fn pow;
+  ag_linear_fn linear;
+  //backwards
+  elem_bwd_fn relu_bwd;
+  elem_bwd_alpha_fn leakyrelu_bwd;
+  elem_bwd_fn sigmoid_bwd_from_s;
+  elem_bwd_fn tanh_bwd_from_t;
+  elem_bwd_fn gelu_bwd;
+  elem_bwd_fn softplus_bwd;
+  elem_bwd_fn exp_bwd_from_y;
+  elem_bwd_fn log_bwd;
+  elem_bwd_fn sqrt_bwd_from_y;
+  ag_matmul_bwd_fn matmul_bwd_dA;
+  ag_matmul_bwd_fn matmul_bwd_dB;
+  ag_linear_dW_fn linear_dW;
+  ag_linear_dX_fn linear_dX;
+  ag_linear_db_fn linear_db;
+};
+
+AG_EXPORT int ag_get_cpu_kernels_v2(struct ag_cpu_v2* out);
+
+// V2 plus the general GEMM. The loader prefers this one, then v2, then v1.
+struct ag_cpu_v3 {
+  uint32_t abi_version;   // must be AG_KERNELS_ABI_V3
+  ag_relu_fn   relu;
+  ag_matmul_fn matmul;
+  ag_gelu_fn gelu;
+  ag_leakyrelu_fn leakyrelu;
+  ag_sigmoid_fn sigmoid;
+  ag_tanh_fn tanh;
+  ag_softplus_fn softplus;
+  ag_exp_fn exp;
+  ag_log_fn log;
+  ag_sqrt_fn sqrt;
+  ag_pow_fn pow;
+  ag_linear_fn linear;
+  //backwards
+  elem_bwd_fn relu_bwd;
+  elem_bwd_alpha_fn leakyrelu_bwd;
+  elem_bwd_fn sigmoid_bwd_from_s;
+  elem_bwd_fn tanh_bwd_from_t;
+  elem_bwd_fn gelu_bwd;
+  elem_bwd_fn softplus_bwd;
+  elem_bwd_fn exp_bwd_from_y;
+  elem_bwd_fn log_bwd;
+  elem_bwd_fn sqrt_bwd_from_y;
+  ag_matmul_bwd_fn matmul_bwd_dA;
+  ag_matmul_bwd_fn matmul_bwd_dB;
+  ag_linear_dW_fn linear_dW;
+  ag_linear_dX_fn linear_dX;
+  ag_linear_db_fn linear_db;
+  ag_gemm_fn gemm;
+};
+
+AG_EXPORT int ag_get_cpu_kernels_v3(struct ag_cpu_v3* out);
+
 // ---- NEW: CUDA function pointer types (accept a stream) ----
 // Avoid pulling in CUDA headers here: just forward-declare the opaque type.
 typedef struct CUstream_st* ag_cuda_stream_t;
@@ -162,19 +256,38 @@ struct Cpu {
   elem_bwd_fn log_bwd = nullptr;
   elem_bwd_fn sqrt_bwd_from_y = nullptr;
   // linear backward wrappers
-  void (*matmul_bwd_dA)(const float*, const float*, float*, int M, int K, int N);
-  void (*matmul_bwd_dB)(const float*, const float*, float*, int M, int K, int N);
+  ag_matmul_bwd_fn matmul_bwd_dA = nullptr;
+  ag_matmul_bwd_fn matmul_bwd_dB = nullptr;
   ag_linear_dW_fn linear_dW = nullptr;
   ag_linear_dX_fn linear_dX = nullptr;
   ag_linear_db_fn linear_db = nullptr;
+  ag_gemm_fn gemm = nullptr;
 };
 
 // Global registry accessor
 Cpu& cpu();
 
-// Load a plugin and populate the registry
+// C = alpha * op(A) @ op(B) + beta * C with ag_gemm_fn's conventions,
+// through the plugin's gemm when one is loaded and a portable loop
+// otherwise. VJPs use it to accumulate (beta = 1) straight into grads.
+void gemm(bool trans_a, bool trans_b, int64_t M, int64_t N, int64_t K,
+          float alpha, const float* A, int64_t lda,
+          const float* B, int64_t ldb,
+          float beta, float* C, int64_t ldc);
+
+// Load a plugin and populate the registry. Plugins exporting
+// ag_get_cpu_kernels_v3 or _v2 are used directly (a v2 table has no
+// gemm); v1-only plugins are wrapped in shims that reject dimensions
+// which do not fit in 32 bits.
 void load_cpu_plugin(const char* path);
 
+// The dlopen/dlsym wrappers the plugin loaders use, for other shared
+// objects the runtime loads (jit ahead-of-time models). open_library()
+// throws std::runtime_error on failure; library_symbol() returns nullptr
+// for a missing symbol. Handles are never closed, like plugin handles.
+void* open_library(const char* path);
+void* library_symbol(void* handle, const char* name);
+
 // ---- NEW: CUDA registry ----
 struct Cuda {
   // Forward
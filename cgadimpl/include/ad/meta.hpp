@@ -0,0 +1,58 @@
+// =====================
+// file: cgadimpl/include/ad/meta.hpp
+// =====================
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "ad/graph.hpp"
+
+namespace ag {
+namespace meta {
+
+/*
+ *  Meta mode:
+ *  -----------
+ *  Build the graph from leaves whose tensors live on Device::Meta
+ *  (Tensor::meta(r, c)) and every op runs shape inference only: the
+ *  result nodes carry a meta tensor of the inferred shape, no kernel is
+ *  launched and nothing is allocated. Shape mismatches surface as the
+ *  same std::runtime_error infer_shape() throws, before any real work.
+ *
+ *  Typical usage:
+ *      Value x  = constant(Tensor::meta(B, 784), "x");
+ *      Value W1 = param(Tensor::meta(784, 4096), "W1");
+ *      Value y  = sum(relu(matmul(x, W1)));
+ *      auto fp  = meta::footprint(y);   // nodes, activation/grad bytes
+ */
+
+/*
+ *  Footprint:
+ *  -----------
+ *  What materialising the graph under `root` would cost, in float32.
+ *      nodes            : nodes reachable from root (leaves included)
+ *      leaves           : Op::Leaf nodes
+ *      param_bytes      : values of leaves that require grad
+ *      activation_bytes : values of every non-leaf node
+ *      grad_bytes       : one grad buffer per node that requires grad
+ *      flops, bytes_moved : forward op_cost() summed over non-leaf nodes
+ */
+struct Footprint {
+    std::size_t nodes{0};
+    std::size_t leaves{0};
+    std::size_t param_bytes{0};
+    std::size_t activation_bytes{0};
+    std::size_t grad_bytes{0};
+    int64_t     flops{0};
+    int64_t     bytes_moved{0};
+
+    std::size_t total_bytes() const { return param_bytes + activation_bytes + grad_bytes; }
+};
+
+// Walks the graph under root; works on meta and materialised graphs alike.
+Footprint footprint(const Value& root);
+
+// True if any node reachable from root carries a meta tensor.
+bool is_meta_graph(const Value& root);
+
+} // namespace meta
+} // namespace ag
@@ -76,7 +76,13 @@ Value alibiatt(const Value& a, const Value& b, const Value& c, const Value& d, f
 Value cross_entropy_with_logits(const Value& logits, const Value& onehot);
 Value kldivergence(const Value& logits, const Value& onehot);
 Value fmab(const Value& a, const Value& b, const Value& c); // fused multiply-add a@b + c
-Value linear(const Value& a, const Value& b, const Value& c); // fused multiply-add a@b + c
+// act(a@b + c) as one node: one GEMM with the bias and activation applied
+// in its output pass, and one fused VJP. c broadcasts onto a@b (usually a
+// [1,N] bias row). fuse_linear() in fusion.hpp rewrites existing graphs.
+Value linear_relu(const Value& a, const Value& b, const Value& c);
+Value linear_gelu(const Value& a, const Value& b, const Value& c);
+Value linear_silu(const Value& a, const Value& b, const Value& c);
+Value linear(const Value& a, const Value& b, const Value& c); // a @ b^T + c, b stored [Out, In]
 
 Value attention(const Value& a, const Value& b, const Value& c, const Value& d);
 Value mse_loss(const Value& pred, const Value& target);
@@ -12,6 +12,7 @@ namespace ag {
   ag_cuda_stream_t current_stream();
 
   // Set the current stream (you’ll use this later for CUDA Graph capture/replay).
+  // Both are per ExecutionContext (see ad/context.hpp), not process-wide.
   void set_current_stream(ag_cuda_stream_t s);
 }
 
@@ -3,11 +3,15 @@
 // =====================
 #pragma once
 #include <cstdint>
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
 
 namespace ag {
 
 enum class Op : uint8_t {
-#define OP(name, arity, str) name,
+#define OP(name, arity, str, ...) name,
 #include "ad/detail/ops.def"
 #undef OP
     Count
@@ -15,7 +19,137 @@ enum class Op : uint8_t {
 
 inline constexpr std::size_t OpCount = static_cast<std::size_t>(Op::Count);
 
+// How an op's output shape follows from its input shapes (4th ops.def column).
+//   Leaf       no inputs; shape comes from the tensor itself
+//   Same       shape of input 0 (other inputs must broadcast onto it)
+//   Broadcast  numpy-style broadcast of inputs 0 and 1
+//   MatMul     (in0.rows, in1.cols), needs in0.cols == in1.rows
+//   MatMulNT   (in0.rows, in1.rows), needs in0.cols == in1.cols  (x * W^T)
+//   Transpose  (in0.cols, in0.rows)
+//   RowReduce  (in0.rows, 1)
+//   Scalar     (1, 1); all inputs must broadcast together
+//   Attention  (in0.rows, last.cols): softmax(xWq (xWk)^T) x Wv
+enum class ShapeRule : uint8_t {
+    Leaf, Same, Broadcast, MatMul, MatMulNT, Transpose, RowReduce, Scalar, Attention
+};
+
+using Shape2 = std::pair<int64_t,int64_t>;
+
+// Coarse class of an op, for schedulers and fusion passes.
+enum class OpKind : uint8_t {
+    Leaf,
+    Elementwise,   // out[i] depends on in[i] only (modulo broadcast)
+    Reduction,     // reads whole rows / the whole tensor (sums, norms, softmax, losses)
+    Contraction,   // GEMM-shaped: MatMul, FMA, Linear
+    Movement,      // pure data layout change (Transpose)
+    Composite      // several GEMMs + glue in one node (attention, SwiGLU, MoE)
+};
+
+// Which forward values the VJP reads. Anything not listed only needs
+// shapes, so a checkpoint/release policy may drop it after the forward.
+enum class BwdNeeds : uint8_t { None, Input, Output, Both };
+
+/*
+ *  OpTraits:
+ *  ----------
+ *  Compile-time per-op facts, generated from the columns of ops.def.
+ *      shape   : ShapeRule used by infer_shape()
+ *      kind    : OpKind
+ *      flops   : approx. FLOPs per element (per MAC for contractions)
+ *      saves   : what the backward needs kept alive
+ *      fusible : may join a fused elementwise loop
+ */
+struct OpTraits {
+    ShapeRule shape;
+    OpKind    kind;
+    uint8_t   flops;
+    BwdNeeds  saves;
+    bool      fusible;
+};
+
+inline constexpr std::array<OpTraits, OpCount> kOpTraits = {{
+#define OP(name, arity, str, shape, kind, flops, saves, fusible) \
+    OpTraits{ShapeRule::shape, OpKind::kind, flops, BwdNeeds::saves, fusible},
+#include "ad/detail/ops.def"
+#undef OP
+}};
+
+constexpr const OpTraits& op_traits(Op o) { return kOpTraits[static_cast<std::size_t>(o)]; }
+constexpr ShapeRule op_shape_rule(Op o) { return op_traits(o).shape; }
+constexpr OpKind    op_kind(Op o)       { return op_traits(o).kind; }
+constexpr bool      op_fusible(Op o)    { return op_traits(o).fusible; }
+constexpr bool      bwd_needs_input(Op o)  { return op_traits(o).saves == BwdNeeds::Input  || op_traits(o).saves == BwdNeeds::Both; }
+constexpr bool      bwd_needs_output(Op o) { return op_traits(o).saves == BwdNeeds::Output || op_traits(o).saves == BwdNeeds::Both; }
+
+/*
+ *  op_cost():
+ *  -----------
+ *  Roofline-style estimate for one op given its input and output shapes.
+ *      flops : arithmetic work, from the flops column and the op kind
+ *      bytes : float32 traffic, every input read once + the output written
+ *  Good enough to rank ops and spot memory-bound chains; not a timing model.
+ */
+struct OpCost {
+    int64_t flops{0};
+    int64_t bytes{0};
+};
+
+constexpr int64_t numel_of(const Shape2& s) { return s.first * s.second; }
+
+constexpr OpCost op_cost(Op op, const Shape2* in, std::size_t n_in, Shape2 out) {
+    const OpTraits& t = op_traits(op);
+    OpCost c{};
+    c.bytes = numel_of(out) * int64_t(sizeof(float));
+    for (std::size_t i = 0; i < n_in; ++i) c.bytes += numel_of(in[i]) * int64_t(sizeof(float));
+    const int64_t k = t.flops;
+
+    switch (t.kind) {
+        case OpKind::Leaf:
+            c.bytes = 0;
+            break;
+        case OpKind::Movement:
+            break;
+        case OpKind::Elementwise:
+            c.flops = k * numel_of(out);
+            break;
+        case OpKind::Reduction:
+            c.flops = n_in ? k * numel_of(in[0]) : 0;
+            break;
+        case OpKind::Contraction: {
+            // (M x K) . (K x N) [+ bias]; K is in0's column count for all three.
+            const int64_t M = out.first, N = out.second, K = n_in ? in[0].second : 0;
+            c.flops = k * M * K * N + (n_in > 2 ? M * N : 0);
+            break;
+        }
+        case OpKind::Composite:
+            if (t.shape == ShapeRule::Attention && n_in >= 4) {
+                // x:[n,d]  Wq,Wk:[d,dk]  Wv:[d,dv]
+                const int64_t n = in[0].first, d = in[0].second;
+                const int64_t dk = in[1].second, dv = in[3].second;
+                c.flops = 2 * n * d * (2 * dk + dv)   // projections
+                        + 2 * n * n * dk              // q k^T
+                        + 2 * n * n * dv              // s v
+                        + k * n * n;                  // score activation
+            } else if (n_in >= 1) {
+                // x W^T style: SwiGLU runs two GEMMs, MoE one.
+                const int64_t gemms = (op == Op::SWIGLU) ? 2 : 1;
+                const int64_t M = out.first, N = out.second, K = in[0].second;
+                c.flops = gemms * 2 * M * K * N + k * M * N;
+            }
+            break;
+    }
+    return c;
+}
+
+inline OpCost op_cost(Op op, const std::vector<Shape2>& in, Shape2 out) {
+    return op_cost(op, in.data(), in.size(), out);
+}
+
 const char* op_name(Op);
 int         op_arity(Op);
 
-} // namespace ag
\ No newline at end of file
+// Output shape of `op` applied to inputs of the given shapes, without
+// touching any data. Throws std::runtime_error on incompatible shapes.
+Shape2 infer_shape(Op op, const std::vector<Shape2>& in);
+
+} // namespace ag
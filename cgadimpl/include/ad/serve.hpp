@@ -0,0 +1,112 @@
+//============================================================
+// file: cgadimpl/include/ad/serve.hpp
+//============================================================
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include "ad/graph.hpp"
+
+namespace ag {
+namespace jit {
+
+/*
+ *  In-process serving with dynamic batching.
+ *
+ *  Many small concurrent requests against one model each leave the GEMM
+ *  kernels mostly idle. A Server queues them and lets worker threads
+ *  coalesce queued requests along the batch (row) dimension: a worker
+ *  takes the oldest request and waits until max_batch rows are queued or
+ *  that request has waited max_delay, whichever comes first. It then
+ *  copies the requests' rows into one zero-padded batch and runs the plan
+ *  compiled for the smallest bucket that holds it. Finally it scatters the
+ *  output rows back to each request's future.
+ *
+ *  Plans for every bucket are compiled up front in the constructor, on
+ *  the calling thread and its ExecutionContext (the bucket list is the
+ *  one PlanCache uses with pad_batch, capped at max_batch). Each worker
+ *  runs them with its own Workspace. As with pad_batch, the model must be
+ *  row-independent along the batch: row i of the output may only read row
+ *  i of the inputs. The constructor throws if the output is not batch-shaped.
+ *
+ *      jit::Server srv(model, {W1, b1, W2, b2}, {In});
+ *      std::future<Tensor> y = srv.submit(x);   // x: [n, In], n <= max_batch
+ *      Tensor logits = y.get();                 // [n, Out]
+ */
+struct ServerOptions {
+    int64_t max_batch = 32;                    // rows per executed batch
+    std::chrono::microseconds max_delay{500};  // longest a request waits for company
+    int workers = 1;                           // threads running batches
+    std::vector<int64_t> buckets;              // ascending; empty = powers of two
+    CompileOptions compile;                    // used for every bucket's plan
+};
+
+struct ServerStats {
+    std::size_t requests{0};   // completed (or failed) requests
+    std::size_t batches{0};    // plan runs
+    std::size_t rows{0};       // request rows run
+    std::size_t padded{0};     // rows run in total, padding included
+    std::size_t full{0};       // batches closed by max_batch rather than max_delay
+};
+
+class Server {
+public:
+    using Builder = PlanCache::Builder;
+
+    // `input_cols` gives the width of each input; a request passes one
+    // tensor per input, all with the same (batch) number of rows.
+    Server(Builder build, std::vector<Tensor> params,
+           std::vector<int64_t> input_cols, ServerOptions opts = {});
+    ~Server();   // shutdown()
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    // Queues a request; the future yields its output rows, or rethrows
+    // what the run threw. Throws std::runtime_error at once for a request
+    // of the wrong shape, more than max_batch rows, or after shutdown().
+    std::future<Tensor> submit(std::vector<Tensor> inputs);
+    std::future<Tensor> submit(const Tensor& x) { return submit(std::vector<Tensor>{x}); }
+
+    // Rows a batch of `n` request rows runs with.
+    int64_t bucket(int64_t n) const;
+    ServerStats stats() const;
+
+    // Stops accepting requests, runs the ones already queued, then joins
+    // the workers. Idempotent.
+    void shutdown();
+
+private:
+    struct Request {
+        std::vector<Tensor> inputs;
+        std::promise<Tensor> done;
+        std::chrono::steady_clock::time_point arrived;
+    };
+    struct Bucket {
+        int64_t rows;
+        Compiled plan;
+    };
+
+    void work();
+    void run_batch(std::vector<Request>& batch, bool full, Workspace& ws,
+                   std::vector<Tensor>& staged, Tensor& out);
+
+    std::vector<Tensor> params_;
+    std::vector<Tensor*> param_ptrs_;
+    std::vector<int64_t> cols_;
+    ServerOptions opts_;
+    std::vector<Bucket> buckets_;     // ascending rows; the last holds max_batch
+
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<Request> queue_;
+    int64_t queued_rows_{0};
+    bool stopping_{false};
+    ServerStats stats_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace jit
+} // namespace ag
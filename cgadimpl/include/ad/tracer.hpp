@@ -42,23 +42,27 @@ public:
     // Return captured nodes in capture insertion order (shared_ptrs).
     std::vector<NodePtr> captured_nodes() const;
 
-    // Mark a node as an explicit output of the capture (optional).
+    // Mark a node as an explicit output of the capture (optional). It is
+    // added to the captured nodes if its op did not report it.
     void mark_output(const NodePtr& n);
 
     // Return outputs explicitly marked; if none marked, detect outputs automatically:
     // nodes in captured set that are not used as inputs of any captured node.
     std::vector<NodePtr> outputs() const;
 
+    // True when mark_output() was called, i.e. outputs() is the marked set.
+    bool has_marked_outputs() const;
+
     // Topologically sort the subgraph consisting of captured nodes.
     // Returns nodes in parent-before-child order suitable for lowering/export.
     std::vector<NodePtr> topo_sort() const;
 
 private:
-    // Helper: add node only if not seen. Thread-safe.
+    // Helper: add node only if not seen. Called only on the capturing thread.
     void add_if_new(const NodePtr& n);
 
     // Internal storage (protected by mutex).
-    mutable std::mutex mu_;
+    mutable std::mutex mu_;                      // queries/clear only; capture is single-threaded
     std::vector<NodePtr> order_;                 // insertion order
     std::unordered_set<Node*> seen_raw_;         // dedupe by raw pointer
     std::unordered_set<Node*> outputs_raw_;      // marked outputs
@@ -3,6 +3,7 @@
 // ====================================================================
 #pragma once
 #include <cstddef>
+#include <cstdint>
 #include <utility>
 #include <vector>
 #include <iosfwd>
@@ -10,34 +11,39 @@
 
 namespace ag {
 
-// The new Device enum, replacing the old 'bool on_cuda'
-enum class Device { CPU, CUDA };
+// The new Device enum, replacing the old 'bool on_cuda'.
+// Meta tensors carry a shape but no storage; ops on them only infer shapes.
+enum class Device { CPU, CUDA, Meta };
 
 class Tensor {
 private:
     // CRITICAL CHANGE: The storage is now a shared_ptr.
     std::shared_ptr<float> data_ptr_;
-    int r_{0}, c_{0};
+    // Shapes are 64-bit so that rows*cols (and every flat index derived
+    // from it) can exceed 2^31 without overflowing.
+    int64_t r_{0}, c_{0};
     Device dev_{Device::CPU};
 
 public:
     // --- Constructors & Destructor ---
     Tensor();
-    Tensor(int rows, int cols, Device dev = Device::CPU);
+    Tensor(int64_t rows, int64_t cols, Device dev = Device::CPU);
 
     // --- Device Info & Control ---
     Device device() const noexcept { return dev_; }
     bool is_cpu()   const noexcept { return dev_ == Device::CPU; }
     bool is_cuda()  const noexcept { return dev_ == Device::CUDA; }
+    bool is_meta()  const noexcept { return dev_ == Device::Meta; }
     Tensor to(Device target_dev) const;
 
     // --- Inline helper from your original file ---
     inline Tensor rt(const Tensor& g, const Tensor& like){ return Tensor::reduce_to(g, like); }
 
     // --- Factories (now take a Device enum) ---
-    static Tensor zeros(int r, int c, Device dev = Device::CPU);
-    static Tensor ones (int r, int c, Device dev = Device::CPU);
-    static Tensor randn(int r, int c, unsigned seed=42, Device dev = Device::CPU);
+    static Tensor zeros(int64_t r, int64_t c, Device dev = Device::CPU);
+    static Tensor ones (int64_t r, int64_t c, Device dev = Device::CPU);
+    static Tensor randn(int64_t r, int64_t c, unsigned seed=42, Device dev = Device::CPU);
+    static Tensor meta (int64_t r, int64_t c) { return Tensor(r, c, Device::Meta); }
     static Tensor zeros_like(const Tensor& x);
     static Tensor ones_like (const Tensor& x);
 
@@ -46,15 +52,15 @@ public:
     const float* data() const { return data_ptr_.get(); }
 
     // --- Shape/Info ---
-    int rows() const;
-    int cols() const;
-    std::pair<int,int> shape() const;
+    int64_t rows() const;
+    int64_t cols() const;
+    std::pair<int64_t,int64_t> shape() const;
     std::size_t numel() const;
     std::size_t size() const;
 
     // --- CPU-only element access (throws error if on CUDA) ---
-    float& operator()(int i, int j);
-    const float& operator()(int i, int j) const;
+    float& operator()(int64_t i, int64_t j);
+    const float& operator()(int64_t i, int64_t j) const;
 
     // --- Grad accumulation ---
     Tensor& add_(const Tensor& g);
@@ -75,11 +81,14 @@ public:
     static Tensor transpose(const Tensor& x);
     static Tensor reciprocal(const Tensor &x);
     static Tensor matmul(const Tensor &A, const Tensor &B);
+    // alpha * op(A) @ op(B), op = transpose where the flag is set, without
+    // materialising the transpose (kernels::gemm reads it in place).
+    static Tensor matmul(const Tensor &A, const Tensor &B, bool trans_a, bool trans_b, float alpha = 1.f);
     static Tensor abs (const Tensor& x);
     static Tensor sign (const Tensor& x);
     static Tensor reduce_to(const Tensor& G, const Tensor& like);
     static Tensor floten(float q);
-    static Tensor alibi(int rows, int cols, float m);
+    static Tensor alibi(int64_t rows, int64_t cols, float m);
     static Tensor sinh(const Tensor &x);
     static Tensor exp(const Tensor& x);
     static Tensor log(const Tensor& x);
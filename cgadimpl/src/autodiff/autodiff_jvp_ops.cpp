@@ -392,7 +392,7 @@ Tensor jvp_LeakyRelu(Node* n, const std::function<const Tensor&(Node*)>& t){
     if (n->value.is_cpu()) {
         Node* X=n->inputs[0].get(); Node* A=n->inputs[1].get(); float a=A->value(0,0);
         Tensor out = Tensor::zeros_like(X->value);
-        for(int i=0;i<X->value.rows();++i) for(int j=0;j<X->value.cols();++j){
+        for(int64_t i=0;i<X->value.rows();++i) for(int64_t j=0;j<X->value.cols();++j){
             out(i,j) = T(t,X)(i,j) * (X->value(i,j)>0.f ? 1.f : a);
         }
         return out;
@@ -410,15 +410,59 @@ Tensor jvp_MatMul(Node* n, const std::function<const Tensor&(Node*)>& t){
         throw std::runtime_error("JVP for MatMul on CUDA not implemented yet!");
     }
 }
+// Tangent of a@b + c, shared by FMA and the fused Linear* ops.
+static Tensor gemm_bias_tangent(Node* n, const std::function<const Tensor&(Node*)>& t){
+    Node* A=n->inputs[0].get(); Node* B=n->inputs[1].get(); Node* C=n->inputs[2].get();
+    return Tensor::matmul(T(t,A), B->value) + Tensor::matmul(A->value, T(t,B)) + T(t,C);
+}
+
 Tensor jvp_FMA(Node* n, const std::function<const Tensor&(Node*)>& t){
     if (n->value.is_cpu()) {
-        Node* A=n->inputs[0].get(); Node* B=n->inputs[1].get(); Node* C=n->inputs[2].get();
-        return Tensor::matmul(T(t,A), Tensor::transpose(B->value)) + Tensor::matmul(A->value, T(t,B)) + T(t,C);
+        return gemm_bias_tangent(n, t);
     } else {
         throw std::runtime_error("JVP for FMA on CUDA not implemented yet!");
     }
 }
 
+// a@b + c for LinearGELU / LinearSiLU: kept on the tape by the forward,
+// recomputed if something (a checkpoint policy) dropped it.
+static Tensor pre_activation(Node* n){
+    if (!n->tape.empty()) return *n->tape[0];
+    return Tensor::matmul(n->inputs[0]->value, n->inputs[1]->value) + n->inputs[2]->value;
+}
+
+Tensor jvp_LinearRelu(Node* n, const std::function<const Tensor&(Node*)>& t){
+    if (n->value.is_cpu()) {
+        return gemm_bias_tangent(n, t) * Tensor::relu_mask(n->value);
+    } else {
+        throw std::runtime_error("JVP for LinearRelu on CUDA not implemented yet!");
+    }
+}
+
+Tensor jvp_LinearGELU(Node* n, const std::function<const Tensor&(Node*)>& t){
+    if (n->value.is_cpu()) {
+        const Tensor z = pre_activation(n);
+        constexpr float c = 0.79788456080286535588f;
+        Tensor u=c*(z+0.044715f*z*z*z);
+        Tensor dudx=c*(1.f+0.134145f*z*z);
+        Tensor th=Tensor::tanh(u);
+        Tensor one=Tensor::ones_like(th);
+        return gemm_bias_tangent(n, t) * ((one+th)*0.5f + (z * ((one - th*th) * dudx))*0.5f);
+    } else {
+        throw std::runtime_error("JVP for LinearGELU on CUDA not implemented yet!");
+    }
+}
+
+Tensor jvp_LinearSiLU(Node* n, const std::function<const Tensor&(Node*)>& t){
+    if (n->value.is_cpu()) {
+        const Tensor z = pre_activation(n);
+        Tensor s=Tensor::sigmoid(z);
+        return gemm_bias_tangent(n, t) * ( s + z * ( s * (Tensor::ones_like(s)-s) ) );
+    } else {
+        throw std::runtime_error("JVP for LinearSiLU on CUDA not implemented yet!");
+    }
+}
+
 Tensor jvp_Linear(Node* n, const std::function<const Tensor&(Node*)>& t){
     if (n->value.is_cpu()) {
         Node* A=n->inputs[0].get(); Node* B=n->inputs[1].get(); Node* C=n->inputs[2].get();
@@ -512,7 +556,7 @@ Tensor jvp_MOE(Node* n, const std::function<const Tensor&(Node*)>& t){
 Tensor jvp_MSELoss(Node* n, const std::function<const Tensor&(Node*)>& t){
     if (n->value.is_cpu()) {
         Node* Z = n->inputs[0].get(); Node* Y = n->inputs[1].get();
-        int N = Z->value.numel();
+        int64_t N = Z->value.numel();
         Tensor diff = Z->value - Y->value;
         Tensor gZ = diff * (2.0f / float(N));
         Tensor gY = -diff * (2.0f / float(N));
@@ -526,7 +570,7 @@ Tensor jvp_MSELoss(Node* n, const std::function<const Tensor&(Node*)>& t){
 Tensor jvp_MAELoss(Node* n, const std::function<const Tensor&(Node*)>& t){
     if (n->value.is_cpu()) {
         Node* Z = n->inputs[0].get(); Node* Y = n->inputs[1].get();
-        int N = Z->value.numel();
+        int64_t N = Z->value.numel();
         Tensor diff = Tensor::sign(Z->value - Y->value);
         Tensor gZ = diff * (1.0f / float(N));
         Tensor gY = -diff * (1.0f / float(N));
@@ -641,7 +685,7 @@ Tensor jvp_RowMax(Node* n, const std::function<const Tensor&(Node*)>& t){
         Node* X=n->inputs[0].get();
         Tensor m = Tensor::row_max(X->value);
         Tensor M = Tensor::zeros_like(X->value);
-        for(int i=0;i<X->value.rows();++i) for(int j=0;j<X->value.cols();++j)
+        for(int64_t i=0;i<X->value.rows();++i) for(int64_t j=0;j<X->value.cols();++j)
             M(i,j)=(X->value(i,j)==m(i,0))?1.f:0.f;
         return Tensor::row_sum( t(X) * M );
     } else {
@@ -676,7 +720,7 @@ Tensor jvp_LogSumExpRow(Node* n, const std::function<const Tensor&(Node*)>& t){
 }
 Tensor jvp_CeWithLogits(Node* n, const std::function<const Tensor&(Node*)>& t){
     if (n->value.is_cpu()) {
-        Node* Z=n->inputs[0].get(); Node* Y=n->inputs[1].get(); int B=Z->value.rows();
+        Node* Z=n->inputs[0].get(); Node* Y=n->inputs[1].get(); int64_t B=Z->value.rows();
         Tensor sm = Tensor::softmax_row(Z->value);
         Tensor gZ = (sm - Y->value) * (1.0f/float(B));
         Tensor lse = Tensor::logsumexp_row(Z->value);
@@ -703,7 +747,7 @@ Tensor jvp_Leaf(Node*, const std::function<const Tensor&(Node*)>&){
 // -------- dispatch table --------
 JvpFn jvp_lookup(Op op){
     switch(op){
-#define OP(name, arity, str) case Op::name: return &detail::jvp_##name;
+#define OP(name, arity, str, ...) case Op::name: return &detail::jvp_##name;
 #include "ad/detail/ops.def"
 #undef OP
         default: return nullptr;
@@ -1010,6 +1010,20 @@ namespace detail{
 // helper: reduce a gradient to a parent's shape (broadcast-aware)
 inline Tensor rt(const Tensor& g, const Tensor& like){ return Tensor::reduce_to(g, like); }
 
+// P->grad += alpha * op(X) @ op(Y), accumulated in place by the GEMM (no
+// product temporary, no transposed copy of X or Y).
+static void gemm_into_grad(Node* P, bool trans_x, bool trans_y, const Tensor& X, const Tensor& Y,
+                           float alpha = 1.f){
+    const int64_t M = trans_x ? X.cols() : X.rows();
+    const int64_t K = trans_x ? X.rows() : X.cols();
+    const int64_t N = trans_y ? Y.rows() : Y.cols();
+    if ((trans_y ? Y.cols() : Y.rows()) != K || P->grad.rows() != M || P->grad.cols() != N)
+        throw std::runtime_error("gemm_into_grad: shape mismatch");
+    if (P->grad.is_meta()) return;
+    ag::kernels::gemm(trans_x, trans_y, M, N, K, alpha, X.data(), X.cols(), Y.data(), Y.cols(),
+                      1.f, P->grad.data(), N);
+}
+
 // ----- elementwise binary -----
 void vjp_Add(Node* n, const Tensor& gy){
     Node* A = n->inputs[0].get();
@@ -1043,24 +1057,76 @@ void vjp_Mul(Node* n, const Tensor& gy){
 }
 
 // ----- elementwise trinary & matmul -----
+// Gradients of z = a@b + c given gz = dL/dz, shared by FMA and the fused
+// Linear* ops (which first turn gy into gz through their activation).
+static void gemm_bias_bwd(Node* n, const Tensor& gz){
+    Node* A = n->inputs[0].get();
+    Node* B = n->inputs[1].get();
+    Node* C = n->inputs[2].get();
+    if (A->requires_grad) gemm_into_grad(A, false, true, gz, B->value);   // gz @ b^T
+    if (B->requires_grad) gemm_into_grad(B, true, false, A->value, gz);   // a^T @ gz
+    if (C->requires_grad) C->grad.add_( rt(gz, C->value) );
+}
+
 void vjp_FMA(Node* n, const Tensor& gy){
     if (n->value.is_cpu()) {
-        Node* A = n->inputs[0].get();
-        Node* B = n->inputs[1].get();
-        Node* C = n->inputs[2].get();
-        
-        const Tensor& At = A->value;
-        const Tensor& Bt = B->value;
+        gemm_bias_bwd(n, gy);
+    } else {
+        throw std::runtime_error("VJP for FMA on CUDA not implemented yet!");
+    }
+}
 
-        if (A->requires_grad){
-            A->grad.add_(Tensor::matmul(gy, Tensor::transpose(Bt)));
+// a@b + c for LinearGELU / LinearSiLU: kept on the tape by the forward,
+// recomputed if something (a checkpoint policy) dropped it.
+static Tensor pre_activation(Node* n){
+    if (!n->tape.empty()) return *n->tape[0];
+    return Tensor::matmul(n->inputs[0]->value, n->inputs[1]->value) + n->inputs[2]->value;
+}
+
+void vjp_LinearRelu(Node* n, const Tensor& gy){
+    if (n->value.is_cpu()) {
+        // y > 0 exactly where a@b + c > 0, so the output is the mask.
+        auto fn = ag::kernels::cpu().relu_bwd;
+        if (fn) {
+            Tensor gz(gy.rows(), gy.cols());
+            fn(n->value.data(), gy.data(), gz.data(), gy.numel());
+            gemm_bias_bwd(n, gz);
+        } else {
+            gemm_bias_bwd(n, gy * Tensor::relu_mask(n->value));
         }
-        if (B->requires_grad){
-            B->grad.add_(Tensor::matmul(Tensor::transpose(At), gy));
+    } else {
+        throw std::runtime_error("VJP for LinearRelu on CUDA not implemented yet!");
+    }
+}
+
+void vjp_LinearGELU(Node* n, const Tensor& gy){
+    if (n->value.is_cpu()) {
+        const Tensor z = pre_activation(n);
+        auto fn = ag::kernels::cpu().gelu_bwd;
+        if (fn) {
+            Tensor gz(gy.rows(), gy.cols());
+            fn(z.data(), gy.data(), gz.data(), gy.numel());
+            gemm_bias_bwd(n, gz);
+        } else {
+            constexpr float c = 0.79788456080286535588f; // sqrt(2/pi)
+            Tensor u = c * (z + 0.044715f * z*z*z);
+            Tensor dudx = c * (1.f + 0.134145f * z*z);
+            Tensor th = Tensor::tanh(u);
+            Tensor one = Tensor::ones_like(th);
+            gemm_bias_bwd(n, gy * ((one+th)*0.5f + (z * ((one - th*th) * dudx))*0.5f));
         }
-        if (C->requires_grad) C->grad.add_( rt(gy, C->value) );
     } else {
-        throw std::runtime_error("VJP for FMA on CUDA not implemented yet!");
+        throw std::runtime_error("VJP for LinearGELU on CUDA not implemented yet!");
+    }
+}
+
+void vjp_LinearSiLU(Node* n, const Tensor& gy){
+    if (n->value.is_cpu()) {
+        const Tensor z = pre_activation(n);
+        Tensor s = Tensor::sigmoid(z);
+        gemm_bias_bwd(n, gy * ( s + z * ( s * (Tensor::ones_like(s)-s) ) ));
+    } else {
+        throw std::runtime_error("VJP for LinearSiLU on CUDA not implemented yet!");
     }
 }
 
@@ -1068,7 +1134,7 @@ void vjp_FMA(Node* n, const Tensor& gy){
 void vjp_LayerNorm(Node* n, const Tensor& gy){
     if (n->value.is_cpu()) {
         Node* x = n->inputs[0].get();
-        int N = x->value.cols();
+        int64_t N = x->value.cols();
         Tensor std_dev = Tensor::sqrt(*(n->tape[0]) + 0.01);
         Tensor xmu = x->value - *(n->tape[1]);
         Tensor grad_sum = Tensor::row_sum(gy);
@@ -1088,7 +1154,7 @@ void vjp_RealLayerNorm(Node* n, const Tensor& gy){
         Node* x = n->inputs[0].get();
         Node* b = n->inputs[1].get();
         Node* g = n->inputs[2].get();
-        int N = x->value.cols();
+        int64_t N = x->value.cols();
         Tensor std_dev = Tensor::sqrt(*(n->tape[0]) + 0.01);
         Tensor xmu = x->value - *(n->tape[1]);
         Tensor grad_sum = Tensor::row_sum(gy);
@@ -1142,22 +1208,20 @@ void vjp_Attention(Node* n, const Tensor& gy){
         Node* D = n->inputs[3].get();
         Tensor q = *n->tape[0], k = *n->tape[1], v = *n->tape[2], s = *n->tape[3];
         float scale = 1.0f / std::sqrt(float(k.cols()));
-        Tensor dL_ds = Tensor::matmul(gy, Tensor::transpose(v));
-        Tensor dL_dv = Tensor::matmul(Tensor::transpose(s), gy);
+        Tensor dL_ds = Tensor::matmul(gy, v, false, true);
+        Tensor dL_dv = Tensor::matmul(s, gy, true, false);
         Tensor dot = Tensor::row_sum(s * dL_ds);
         Tensor dL_dg = s * (dL_ds - dot);
         Tensor dL_dq = Tensor::matmul(dL_dg, k);
-        Tensor dL_dk = Tensor::matmul(Tensor::transpose(dL_dg), q);
-        Tensor dL_dA_q = Tensor::matmul(dL_dq, Tensor::transpose(B->value));
-        Tensor dL_dB   = Tensor::matmul(Tensor::transpose(A->value), dL_dq) * scale;
-        Tensor dL_dA_k = Tensor::matmul(dL_dk, Tensor::transpose(C->value));
-        Tensor dL_dC   = Tensor::matmul(Tensor::transpose(A->value), dL_dk) * scale;
-        Tensor dL_dA_v = Tensor::matmul(dL_dv, Tensor::transpose(D->value));
-        Tensor dL_dD   = Tensor::matmul(Tensor::transpose(A->value), dL_dv);
-        if (A->requires_grad) A->grad.add_(dL_dA_q + dL_dA_k + dL_dA_v);
-        if (B->requires_grad) B->grad.add_(dL_dB);
-        if (C->requires_grad) C->grad.add_(dL_dC);
-        if (D->requires_grad) D->grad.add_(dL_dD);
+        Tensor dL_dk = Tensor::matmul(dL_dg, q, true, false);
+        if (A->requires_grad) {
+            gemm_into_grad(A, false, true, dL_dq, B->value);
+            gemm_into_grad(A, false, true, dL_dk, C->value);
+            gemm_into_grad(A, false, true, dL_dv, D->value);
+        }
+        if (B->requires_grad) gemm_into_grad(B, true, false, A->value, dL_dq, scale);
+        if (C->requires_grad) gemm_into_grad(C, true, false, A->value, dL_dk, scale);
+        if (D->requires_grad) gemm_into_grad(D, true, false, A->value, dL_dv);
     } else {
         throw std::runtime_error("VJP for Attention on CUDA not implemented yet!");
     }
@@ -1175,19 +1239,19 @@ void vjp_SWIGLU(Node* n, const Tensor& gy){
         Node* B = n->inputs[2].get();
         Node* C = n->inputs[3].get();
         Node* D = n->inputs[4].get();
-        Tensor y = Tensor::matmul(X->value, Tensor::transpose(A->value)) + B->value;
+        Tensor y = Tensor::matmul(X->value, A->value, false, true) + B->value;
         Tensor q = y * Tensor::sigmoid(y);
-        Tensor h = Tensor::matmul(X->value, Tensor::transpose(C->value)) + D->value;
+        Tensor h = Tensor::matmul(X->value, C->value, false, true) + D->value;
         Tensor Swishdif = Tensor::sigmoid(y) + y * (Tensor::sigmoid(y) * (Tensor::ones_like(y) - Tensor::sigmoid(y)));
         Tensor dL_dB = Swishdif * h * gy;
-        Tensor dL_dA = Tensor::matmul(Tensor::transpose(dL_dB), X->value);
         Tensor dL_dD = q * gy;
-        Tensor dL_dC = Tensor::matmul(Tensor::transpose(dL_dD), X->value);
-        Tensor dL_dX = Tensor::matmul(dL_dB, A->value) + Tensor::matmul(dL_dD, C->value);
-        if (X->requires_grad) X->grad.add_(dL_dX);
-        if (A->requires_grad) A->grad.add_(dL_dA);
+        if (X->requires_grad) {
+            gemm_into_grad(X, false, false, dL_dB, A->value);
+            gemm_into_grad(X, false, false, dL_dD, C->value);
+        }
+        if (A->requires_grad) gemm_into_grad(A, true, false, dL_dB, X->value);
         if (B->requires_grad) B->grad.add_(dL_dB);
-        if (C->requires_grad) C->grad.add_(dL_dC);
+        if (C->requires_grad) gemm_into_grad(C, true, false, dL_dD, X->value);
         if (D->requires_grad) D->grad.add_(dL_dD);
     } else {
         throw std::runtime_error("VJP for SWIGLU on CUDA not implemented yet!");
@@ -1543,9 +1607,9 @@ void vjp_LeakyRelu(Node* n, const Tensor& gy){
             X->grad.add_(dX_temp);
         } else {
             // --- OLD: Fallback to the slow loop ---
-            int R=X->value.rows(), C=X->value.cols();
+            int64_t R=X->value.rows(), C=X->value.cols();
             Tensor g(R,C);
-            for(int i=0;i<R;++i) for(int j=0;j<C;++j){
+            for(int64_t i=0;i<R;++i) for(int64_t j=0;j<C;++j){
                 float z=X->value(i,j);
                 g(i,j) = gy(i,j) * (z>0.f ? 1.f : alpha);
             }
@@ -1565,12 +1629,8 @@ void vjp_MatMul(Node* n, const Tensor& gy){
     const Tensor& Bt = B->value;
 
     if (At.is_cpu()) {
-        if (A->requires_grad){
-            A->grad.add_(Tensor::matmul(gy, Tensor::transpose(Bt)));
-        }
-        if (B->requires_grad){
-            B->grad.add_(Tensor::matmul(Tensor::transpose(At), gy));
-        }
+        if (A->requires_grad) gemm_into_grad(A, false, true, gy, Bt);   // gy @ B^T
+        if (B->requires_grad) gemm_into_grad(B, true, false, At, gy);   // A^T @ gy
     } else {
         auto [M, K]  = At.shape();
         auto [K2, N] = Bt.shape();
@@ -1677,7 +1737,7 @@ void vjp_RowMax(Node* n, const Tensor& gy){
     if (n->value.is_cpu()) {
         Tensor m = Tensor::row_max(X->value);
         Tensor g = Tensor::zeros_like(X->value);
-        for(int i=0; i<X->value.rows(); ++i) for(int j=0; j<X->value.cols(); ++j)
+        for(int64_t i=0; i<X->value.rows(); ++i) for(int64_t j=0; j<X->value.cols(); ++j)
             g(i,j) = (X->value(i,j)==m(i,0)) ? gy(i,0) : 0.f;
         X->grad.add_( g );
     } else {
@@ -1721,7 +1781,7 @@ void vjp_CeWithLogits(Node* n, const Tensor& gy){
     Node* Z = n->inputs[0].get();
     Node* Y = n->inputs[1].get();
     if (n->value.is_cpu()) {
-        int B = Z->value.rows();
+        int64_t B = Z->value.rows();
         Tensor sm = Tensor::softmax_row(Z->value);
         Tensor gZ = (sm - Y->value) * (1.0f / float(B));
         if (Z->requires_grad) Z->grad.add_( gZ );
@@ -1740,7 +1800,7 @@ void vjp_KLDivergence(Node* n, const Tensor& gy){
     Node* Z = n->inputs[0].get();
     Node* Y = n->inputs[1].get();
     if (n->value.is_cpu()) {
-        int B = Z->value.rows();
+        int64_t B = Z->value.rows();
         Tensor sm = Tensor::softmax_row(Z->value);
         Tensor gZ = (sm - Y->value) * (1.0f / float(B));
         if (Z->requires_grad) Z->grad.add_( gZ );
@@ -1776,10 +1836,18 @@ void vjp_Reciprocal(Node* n, const Tensor& gy){
     }
 }
 
+// y = a @ w^T + c with w stored [Out, In] (ShapeRule::MatMulNT).
 void vjp_Linear(Node* n, const Tensor& gy){
-    // Assuming vjp_Linear is a composite and can be handled by its constituents (MatMul, Add)
-    // For a truly fused kernel, this would need a device-aware implementation.
-    vjp_FMA(n, gy);
+    if (n->value.is_cpu()) {
+        Node* A = n->inputs[0].get();
+        Node* W = n->inputs[1].get();
+        Node* C = n->inputs[2].get();
+        if (A->requires_grad) gemm_into_grad(A, false, false, gy, W->value);   // gy @ w
+        if (W->requires_grad) gemm_into_grad(W, true, false, gy, A->value);    // gy^T @ a
+        if (C->requires_grad) C->grad.add_( rt(gy, C->value) );
+    } else {
+        throw std::runtime_error("VJP for Linear on CUDA not implemented yet!");
+    }
 }
 
 void vjp_Cosh(Node* n, const Tensor& gy){
@@ -1880,21 +1948,19 @@ void vjp_RELUAtt(Node* n, const Tensor& gy){
         Node* A = n->inputs[0].get(), *B = n->inputs[1].get(), *C = n->inputs[2].get(), *D = n->inputs[3].get();
         Tensor q = *n->tape[0], k = *n->tape[1], v = *n->tape[2], s = *n->tape[3];
         float scale = 1.0f / std::sqrt(float(k.cols()));
-        Tensor dL_ds = Tensor::matmul(gy, Tensor::transpose(v));
-        Tensor dL_dv = Tensor::matmul(Tensor::transpose(s), gy);
+        Tensor dL_ds = Tensor::matmul(gy, v, false, true);
+        Tensor dL_dv = Tensor::matmul(s, gy, true, false);
         Tensor dL_dg = Tensor::relu_mask(s) * dL_ds;
         Tensor dL_dq = Tensor::matmul(dL_dg, k);
-        Tensor dL_dk = Tensor::matmul(Tensor::transpose(dL_dg), q);
-        Tensor dL_dA_q = Tensor::matmul(dL_dq, B->value) * scale;
-        Tensor dL_dB   = Tensor::matmul(Tensor::transpose(dL_dq), A->value) * scale;
-        Tensor dL_dA_k = Tensor::matmul(dL_dk, C->value) * scale;
-        Tensor dL_dC   = Tensor::matmul(Tensor::transpose(dL_dk), A->value) * scale;
-        Tensor dL_dA_v = Tensor::matmul(dL_dv, D->value);
-        Tensor dL_dD   = Tensor::matmul(Tensor::transpose(dL_dv), A->value);
-        if (A->requires_grad) A->grad.add_(dL_dA_q + dL_dA_k + dL_dA_v);
-        if (B->requires_grad) B->grad.add_(dL_dB);
-        if (C->requires_grad) C->grad.add_(dL_dC);
-        if (D->requires_grad) D->grad.add_(dL_dD);
+        Tensor dL_dk = Tensor::matmul(dL_dg, q, true, false);
+        if (A->requires_grad) {
+            gemm_into_grad(A, false, false, dL_dq, B->value, scale);
+            gemm_into_grad(A, false, false, dL_dk, C->value, scale);
+            gemm_into_grad(A, false, false, dL_dv, D->value);
+        }
+        if (B->requires_grad) gemm_into_grad(B, true, false, dL_dq, A->value, scale);
+        if (C->requires_grad) gemm_into_grad(C, true, false, dL_dk, A->value, scale);
+        if (D->requires_grad) gemm_into_grad(D, true, false, dL_dv, A->value);
     } else {
         throw std::runtime_error("VJP for RELUAtt on CUDA not implemented yet!");
     }
@@ -1905,12 +1971,9 @@ void vjp_MOE(Node* n, const Tensor& gy){
         Node* X = n->inputs[0].get();
         Node* W = n->inputs[1].get();
         Node* B = n->inputs[2].get();
-        Tensor dL_dB = gy;
-        Tensor dL_dW = Tensor::matmul(Tensor::transpose(gy), X->value);
-        Tensor dL_dX = Tensor::matmul(gy, W->value);
-        if (X->requires_grad) X->grad.add_(dL_dX);
-        if (W->requires_grad) W->grad.add_(dL_dW);
-        if (B->requires_grad) B->grad.add_(dL_dB);
+        if (X->requires_grad) gemm_into_grad(X, false, false, gy, W->value);
+        if (W->requires_grad) gemm_into_grad(W, true, false, gy, X->value);
+        if (B->requires_grad) B->grad.add_(gy);
     } else {
         throw std::runtime_error("VJP for MOE on CUDA not implemented yet!");
     }
@@ -1921,21 +1984,19 @@ void vjp_SigAtt(Node* n, const Tensor& gy){
         Node* A = n->inputs[0].get(), *B = n->inputs[1].get(), *C = n->inputs[2].get(), *D = n->inputs[3].get();
         Tensor q = *n->tape[0], k = *n->tape[1], v = *n->tape[2], s = *n->tape[3];
         float scale = 1.0f / std::sqrt(float(k.cols()));
-        Tensor dL_ds = Tensor::matmul(gy, Tensor::transpose(v));
-        Tensor dL_dv = Tensor::matmul(Tensor::transpose(s), gy);
+        Tensor dL_ds = Tensor::matmul(gy, v, false, true);
+        Tensor dL_dv = Tensor::matmul(s, gy, true, false);
         Tensor dL_dg = (s * (Tensor::ones_like(s) - s)) * dL_ds;
         Tensor dL_dq = Tensor::matmul(dL_dg, k);
-        Tensor dL_dk = Tensor::matmul(Tensor::transpose(dL_dg), q);
-        Tensor dL_dA_q = Tensor::matmul(dL_dq, B->value) * scale;
-        Tensor dL_dB   = Tensor::matmul(Tensor::transpose(dL_dq), A->value) * scale;
-        Tensor dL_dA_k = Tensor::matmul(dL_dk, C->value) * scale;
-        Tensor dL_dC   = Tensor::matmul(Tensor::transpose(dL_dk), A->value) * scale;
-        Tensor dL_dA_v = Tensor::matmul(dL_dv, D->value);
-        Tensor dL_dD   = Tensor::matmul(Tensor::transpose(dL_dv), A->value);
-        if (A->requires_grad) A->grad.add_(dL_dA_q + dL_dA_k + dL_dA_v);
-        if (B->requires_grad) B->grad.add_(dL_dB);
-        if (C->requires_grad) C->grad.add_(dL_dC);
-        if (D->requires_grad) D->grad.add_(dL_dD);
+        Tensor dL_dk = Tensor::matmul(dL_dg, q, true, false);
+        if (A->requires_grad) {
+            gemm_into_grad(A, false, false, dL_dq, B->value, scale);
+            gemm_into_grad(A, false, false, dL_dk, C->value, scale);
+            gemm_into_grad(A, false, false, dL_dv, D->value);
+        }
+        if (B->requires_grad) gemm_into_grad(B, true, false, dL_dq, A->value, scale);
+        if (C->requires_grad) gemm_into_grad(C, true, false, dL_dk, A->value, scale);
+        if (D->requires_grad) gemm_into_grad(D, true, false, dL_dv, A->value);
     } else {
         throw std::runtime_error("VJP for SigAtt on CUDA not implemented yet!");
     }
@@ -1946,7 +2007,7 @@ void vjp_MSELoss(Node* n, const Tensor& gy){
     Node* Z = n->inputs[0].get();
     Node* Y = n->inputs[1].get();
     if (n->value.is_cpu()) {
-        int N = Z->value.numel();
+        int64_t N = Z->value.numel();
         Tensor diff = Z->value - Y->value;
         Tensor gZ = diff * (2.0f / float(N));
         Tensor gY = -diff * (2.0f / float(N));
@@ -1961,7 +2022,7 @@ void vjp_MAELoss(Node* n, const Tensor& gy){
     Node* Z = n->inputs[0].get();
     Node* Y = n->inputs[1].get();
     if (n->value.is_cpu()) {
-        int N = Z->value.numel();
+        int64_t N = Z->value.numel();
         Tensor diff = Tensor::sign(Z->value - Y->value);
         Tensor gZ = diff * (1.0f / float(N));
         Tensor gY = -diff * (1.0f / float(N));
@@ -1980,7 +2041,7 @@ void vjp_Leaf(Node*, const Tensor&){ /* no-op */ }
 // -------- dispatch table --------
 VjpFn vjp_lookup(Op op){
     switch(op){
-#define OP(name, arity, str) case Op::name: return &detail::vjp_##name;
+#define OP(name, arity, str, ...) case Op::name: return &detail::vjp_##name;
 #include "ad/detail/ops.def"
 #undef OP
         default: return nullptr;
@@ -1,13 +1,26 @@
 // =============================================
 // cgadimpl/src/core/autodiff.cpp
 // =============================================
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <sstream>
 #include <stdexcept>
 #include "ad/autodiff.hpp"
+#include "ad/context.hpp"
 #include "ad/detail/autodiff_ops.hpp"
 #include "ad/debug.hpp"
 #include <ad/checkpoint.hpp>
+#include "ad/inplace.hpp"
 namespace ag {
 
 void zero_grad(const Value& root){
@@ -44,11 +57,296 @@ void zero_grad(const Value& root){
 //     }
 // }
 
-void backward(const Value& root, const Tensor* grad_seed) {
+// ---- Parallel backward -------------------------------------------------
+//
+// backward() with ExecutionContext::backward_threads > 1. A node becomes
+// ready once every consumer's VJP has run: pending[i] counts the consumer
+// edges still outstanding, and whichever lane drops a count to zero queues
+// that node on its own deque. Lanes pop their own deque from the back
+// (depth first, so a chain stays on one thread with warm caches) and steal
+// from the front of the others'. VJPs add into their parents' grads, so
+// each runs holding its parents' locks (striped by address, taken in
+// stripe order); siblings sharing a parent accumulate one at a time in
+// whichever order they finish, so sums may differ from the serial walk in
+// the last bits.
+
+namespace {
+
+constexpr size_t kParallelMinNodes = 16;   // smaller graphs stay serial
+constexpr size_t kGradStripes = 64;
+
+class StealPool {
+public:
+    explicit StealPool(int lanes) {
+        for (int l = 0; l < lanes; ++l) lanes_.push_back(std::make_unique<Lane>());
+        for (int l = 1; l < lanes; ++l) threads_.emplace_back([this, l] { worker(l); });
+    }
+    ~StealPool() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+    int lanes() const { return int(lanes_.size()); }
+
+    // Runs tasks until `total` have completed, starting from `first` on
+    // lane 0 (the caller). fn(task, lane) runs one task and queues those
+    // it makes ready with push(). Rethrows the first exception a task
+    // threw, once the tasks still queued have been dropped.
+    void run(size_t total, int first, const std::function<void(int, int)>& fn) {
+        remaining_ = total;
+        failed_ = false;
+        push(0, first);
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            fn_ = &fn;
+            ctx_ = &current_context();
+            open_ = true;
+            ++job_;
+        }
+        cv_.notify_all();
+        drain(0);
+
+        std::exception_ptr err;
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            open_ = false;
+            done_cv_.wait(lk, [&] { return active_ == 0; });
+            fn_ = nullptr;
+            std::swap(err, error_);
+        }
+        for (auto& l : lanes_) l->q.clear();
+        queued_ = 0;
+        if (err) std::rethrow_exception(err);
+    }
+
+    void push(int lane, int task) {
+        {
+            std::lock_guard<std::mutex> lk(lanes_[lane]->mu);
+            lanes_[lane]->q.push_back(task);
+        }
+        queued_.fetch_add(1);
+        if (sleepers_.load() > 0) {
+            std::lock_guard<std::mutex> lk(mu_);
+            cv_.notify_all();
+        }
+    }
+
+private:
+    struct Lane {
+        std::mutex mu;
+        std::deque<int> q;
+    };
+
+    bool pop(int lane, int& task) {
+        const int L = lanes();
+        for (int k = 0; k < L; ++k) {
+            Lane& v = *lanes_[(lane + k) % L];
+            std::lock_guard<std::mutex> lk(v.mu);
+            if (v.q.empty()) continue;
+            if (k == 0) { task = v.q.back(); v.q.pop_back(); }     // own: newest
+            else        { task = v.q.front(); v.q.pop_front(); }   // steal: oldest
+            queued_.fetch_sub(1);
+            return true;
+        }
+        return false;
+    }
+
+    // Runs tasks until the job is done or failed, sleeping while every
+    // deque is empty but other lanes are still busy.
+    void drain(int lane) {
+        while (remaining_.load() > 0 && !failed_.load()) {
+            int t;
+            if (pop(lane, t)) {
+                try {
+                    (*fn_)(t, lane);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lk(mu_);
+                    if (!error_) error_ = std::current_exception();
+                    failed_ = true;
+                }
+                if (remaining_.fetch_sub(1) == 1 || failed_.load()) {
+                    std::lock_guard<std::mutex> lk(mu_);
+                    cv_.notify_all();
+                }
+                continue;
+            }
+            std::unique_lock<std::mutex> lk(mu_);
+            sleepers_.fetch_add(1);
+            cv_.wait_for(lk, std::chrono::milliseconds(1), [&] {
+                return queued_.load() > 0 || remaining_.load() == 0 || failed_.load();
+            });
+            sleepers_.fetch_sub(1);
+        }
+    }
+
+    void worker(int lane) {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lk(mu_);
+        for (;;) {
+            cv_.wait(lk, [&] { return stop_ || (open_ && job_ != seen); });
+            if (stop_) return;
+            seen = job_;
+            ++active_;
+            ExecutionContext* ctx = ctx_;
+            lk.unlock();
+            {
+                ContextScope scope(*ctx);
+                drain(lane);
+            }
+            lk.lock();
+            if (--active_ == 0) done_cv_.notify_all();
+        }
+    }
+
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    std::vector<std::thread> threads_;
+    std::mutex mu_;
+    std::condition_variable cv_, done_cv_;
+    const std::function<void(int, int)>* fn_{nullptr};
+    ExecutionContext* ctx_{nullptr};   // the caller's, bound read-only on every lane
+    uint64_t job_{0};
+    bool open_{false}, stop_{false};
+    int active_{0};                    // workers inside the open job
+    std::atomic<size_t> remaining_{0};
+    std::atomic<int> queued_{0}, sleepers_{0};
+    std::atomic<bool> failed_{false};
+    std::exception_ptr error_;
+};
+
+// One pool per process, held by one backward() at a time; a concurrent
+// backward on another thread runs serially instead of waiting.
+std::mutex g_pool_mu;
+std::unique_ptr<StealPool> g_pool;
+
+/*
+ *  parallel_backward():
+ *  --------------------
+ *  Runs backward()'s `step` and `release` for every node of `order` on the
+ *  pool, or returns false (having done nothing) when the serial walk should
+ *  be used: small graphs, graphs with checkpoints (recomputation rewrites
+ *  nodes while other lanes read them), or a pool busy on another thread.
+ */
+template <class Step, class Release>
+bool parallel_backward(const std::vector<Node*>& order, int threads, Step& step, Release& release) {
+    if (order.size() < kParallelMinNodes) return false;
+    for (Node* n : order) if (n->is_checkpoint) return false;
+    std::unique_lock<std::mutex> busy(g_pool_mu, std::try_to_lock);
+    if (!busy) return false;
+    if (!g_pool || g_pool->lanes() != threads) {
+        g_pool.reset();
+        g_pool = std::make_unique<StealPool>(threads);
+    }
+    // Every lane is bound to the caller's context: refresh its kernel table
+    // here, then pin it so no lane writes the context while others read it.
+    ExecutionContext& ctx = current_context();
+    kernels::cpu();
+    struct Pin {
+        ExecutionContext& c;
+        bool prev;
+        ~Pin() { c.cpu_pinned = prev; }
+    } pin{ctx, ctx.cpu_pinned};
+    ctx.cpu_pinned = true;
+
+    const size_t N = order.size();
+    std::unordered_map<Node*, int> pos;
+    pos.reserve(N);
+    for (size_t i = 0; i < N; ++i) pos.emplace(order[i], int(i));
+    std::vector<std::vector<int>> parents(N);
+    std::unique_ptr<std::atomic<int>[]> pending(new std::atomic<int>[N]);
+    for (size_t i = 0; i < N; ++i) pending[i].store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < N; ++i)
+        for (auto& p : order[i]->inputs)
+            if (p) {
+                const int j = pos.at(p.get());
+                parents[i].push_back(j);
+                pending[j].fetch_add(1, std::memory_order_relaxed);
+            }
+    int first = -1;
+    for (size_t i = 0; i < N && first < 0; ++i)
+        if (pending[i].load(std::memory_order_relaxed) == 0) first = int(i);   // the root
+
+    static std::mutex stripes[kGradStripes];
+    auto locked = [](VjpFn fn, Node* n, const Tensor& gy) {
+        std::vector<size_t> ids;
+        ids.reserve(n->inputs.size());
+        for (auto& p : n->inputs)
+            if (p && p->requires_grad) ids.push_back((reinterpret_cast<uintptr_t>(p.get()) >> 4) % kGradStripes);
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        for (size_t id : ids) stripes[id].lock();
+        try {
+            fn(n, gy);
+        } catch (...) {
+            for (size_t i = ids.size(); i-- > 0;) stripes[ids[i]].unlock();
+            throw;
+        }
+        for (size_t i = ids.size(); i-- > 0;) stripes[ids[i]].unlock();
+    };
+
+    std::function<void(int, int)> task = [&](int t, int lane) {
+        Node* n = order[size_t(t)];
+        step(n, locked);
+        release(n);
+        for (int j : parents[size_t(t)])
+            if (pending[j].fetch_sub(1, std::memory_order_acq_rel) == 1) g_pool->push(lane, j);
+    };
+    g_pool->run(N, first, task);
+    return true;
+}
+
+} // namespace
+
+/*
+ *  backward():
+ *  -----------
+ *  Reverse topological walk applying each node's VJP. Every consumer of a
+ *  node comes before it in that order, so once the node's own step is done
+ *  nothing in this pass reads its value, tape or gradient again. Unless
+ *  retain_graph is set, those are then freed for non-leaf nodes nobody
+ *  else can reach: a node is released only when its owners are exactly
+ *  the graph edges counted below. A Value handle, a consumer outside this
+ *  graph or an in-place alias all keep it, as does being an input of a
+ *  checkpointed node: recomputing the checkpoint reads those values.
+ *  Memory held by the graph thus shrinks with the frontier as the pass
+ *  runs, and a second backward (or a jit::compile) through released nodes
+ *  needs retain_graph on the first.
+ *
+ *  With ExecutionContext::backward_threads above 1, large graphs run on
+ *  the work-stealing pool instead (see parallel_backward()); the serial
+ *  walk below is otherwise unchanged.
+ */
+void backward(const Value& root, const Tensor* grad_seed, bool retain_graph) {
     if (!root.node) return;
 
     auto order = topo_from(root.node.get());  // topological order (parents before child)
 
+    std::unordered_map<Node*, long> graph_refs;
+    std::unordered_set<Node*> feeds_checkpoint;
+    if (!retain_graph) {
+        graph_refs.reserve(order.size());
+        for (Node* n : order) graph_refs.emplace(n, 0);
+        for (Node* n : order)
+            for (auto& p : n->inputs) {
+                if (!p) continue;
+                ++graph_refs[p.get()];
+                if (n->is_checkpoint) feeds_checkpoint.insert(p.get());
+            }
+    }
+    // Read-only once the walk starts, so workers may call it concurrently.
+    auto release = [&](Node* n) {
+        if (retain_graph || n->op == Op::Leaf || n->is_checkpoint) return;
+        if (feeds_checkpoint.count(n)) return;
+        if (n->weak_from_this().use_count() != graph_refs.at(n)) return;
+        if (inplace::detail::has_alias(n)) return;   // storage shared with another node
+        n->value = Tensor();
+        n->grad = Tensor();
+        n->tape.clear();
+        n->released = true;
+    };
+
     // 1️⃣ Seed gradient at the root node
     if (root.node->requires_grad) {
         root.node->grad = grad_seed ? *grad_seed
@@ -57,10 +355,10 @@ void backward(const Value& root, const Tensor* grad_seed) {
                                            : Tensor::ones_like(root.node->value));
     }
 
-    // 2️⃣ Iterate in reverse topological order (child → parent)
-    for (auto it = order.rbegin(); it != order.rend(); ++it) {
-        Node* n = *it;
-        if (!n || !n->requires_grad) continue;
+    // One node's backward step; `vjp` wraps the call of its VJP (the
+    // parallel path takes the parents' locks around it).
+    auto step = [&](Node* n, auto&& vjp) {
+        if (!n->requires_grad) return;
 
         const Tensor& gy = n->grad;
 
@@ -96,8 +394,12 @@ void backward(const Value& root, const Tensor* grad_seed) {
                 } else {
                     // Parent isn't checkpointed → this is a real error
                     std::ostringstream ss;
-                    ss << "[backward] ERROR: parent value empty but not checkpointed: "
-                       << (p_sp->debug_name ? p_sp->debug_name : "(null)")
+                    if (p_sp->released)
+                        ss << "[backward] ERROR: parent value was released by an earlier backward(); "
+                              "pass retain_graph = true to backpropagate through a graph again: ";
+                    else
+                        ss << "[backward] ERROR: parent value empty but not checkpointed: ";
+                    ss << (p_sp->debug_name ? p_sp->debug_name : "(null)")
                        << " (node=" << p_sp.get() << ")"
                        << " required by " << (n->debug_name ? n->debug_name : "(null)")
                        << " (node=" << n << ")";
@@ -113,12 +415,12 @@ void backward(const Value& root, const Tensor* grad_seed) {
             std::cerr << "[backward] WARNING: no VJP registered for op="
                       << static_cast<int>(n->op)
                       << " (" << (n->debug_name ? n->debug_name : "(null)") << ")\n";
-            continue;
+            return;
         }
 
         // 5️⃣ Apply vector-Jacobian product (accumulates grads into parents)
         try {
-            fn(n, gy);
+            vjp(fn, n, gy);
         } catch (const std::exception& e) {
             std::ostringstream ss;
             ss << "[backward] Exception in VJP for node "
@@ -126,10 +428,21 @@ void backward(const Value& root, const Tensor* grad_seed) {
                << e.what();
             throw std::runtime_error(ss.str());
         }
+    };
+    auto call = [](VjpFn fn, Node* n, const Tensor& gy) { fn(n, gy); };
+
+    const int threads = current_context().backward_threads;
+    if (threads > 1 && parallel_backward(order, threads, step, release)) return;
+
+    // 2️⃣ Iterate in reverse topological order (child → parent)
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        Node* n = *it;
+        if (!n) continue;
+        step(n, call);
+        release(n);
     }
 }
 
-
 Tensor jvp(const Value& root, const std::unordered_map<Node*, Tensor>& seed){
     if (!root.node) return Tensor{};
     auto order = topo_from(root.node.get());
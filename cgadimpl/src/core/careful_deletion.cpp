@@ -18,6 +18,9 @@
 #include "ad/debug.hpp"
 #include <iostream>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
 
 namespace ag {
 namespace memory {
@@ -255,5 +258,164 @@ void debug_deletion_state() {
     // Future work: add statistics on remaining nodes or allocated bytes
 }
 
+// -----------------------------------------------------------------------------
+// Graph teardown / node reclaim
+// -----------------------------------------------------------------------------
+
+/*
+ *  reclaim_nodes():
+ *  -----------------
+ *  Iterative replacement for the recursive ~Node -> ~shared_ptr -> ~Node
+ *  chain. The worklist holds parents that were just released by a dying
+ *  node. For each entry:
+ *      - if someone else still owns it, dropping our reference is enough;
+ *      - if the worklist is the last owner, its inputs/saved_inputs are
+ *        moved onto the worklist first, so its ~Node has nothing left to
+ *        recurse into.
+ *
+ *  Stack depth is therefore O(1) regardless of graph depth, and the work
+ *  can be chopped into batches (drain() with a budget) so the background
+ *  thread never holds its queue lock for an unbounded time.
+ */
+namespace {
+
+std::atomic<std::size_t> g_reclaim_batch{4096};
+std::atomic<std::size_t> g_reclaimed{0};
+std::atomic<bool>        g_bg_enabled{false};
+thread_local bool        t_in_reclaim = false;
+
+using NodeList = std::vector<std::shared_ptr<Node>>;
+
+void steal_parents(Node* n, NodeList& out) {
+    for (auto& p : n->inputs) if (p) out.push_back(std::move(p));
+    n->inputs.clear();
+    for (auto& v : n->saved_inputs) if (v.node) out.push_back(std::move(v.node));
+    n->saved_inputs.clear();
+}
+
+// Frees up to `budget` nodes from the back of `work`; returns how many.
+std::size_t drain(NodeList& work, std::size_t budget) {
+    const bool prev = t_in_reclaim;
+    t_in_reclaim = true;
+    std::size_t freed = 0;
+    while (!work.empty() && freed < budget) {
+        std::shared_ptr<Node> n = std::move(work.back());
+        work.pop_back();
+        if (n && n.use_count() == 1) {
+            steal_parents(n.get(), work);
+            ++freed;
+        }
+        n.reset(); // ~Node (if last owner) sees empty inputs -> no recursion
+    }
+    t_in_reclaim = prev;
+    g_reclaimed.fetch_add(freed, std::memory_order_relaxed);
+    return freed;
+}
+
+void append(NodeList& dst, NodeList& src) {
+    if (dst.empty()) { dst.swap(src); return; }
+    dst.reserve(dst.size() + src.size());
+    for (auto& p : src) dst.push_back(std::move(p));
+    src.clear();
+}
+
+// Single background thread that frees queued subgraphs in batches.
+class Reclaimer {
+public:
+    Reclaimer() : th_([this]{ loop(); }) {}
+    ~Reclaimer() {
+        { std::lock_guard<std::mutex> lk(mu_); stop_ = true; }
+        cv_.notify_all();
+        th_.join();
+    }
+
+    void push(NodeList&& v) {
+        { std::lock_guard<std::mutex> lk(mu_); append(queue_, v); }
+        cv_.notify_one();
+    }
+
+    void flush() {
+        std::unique_lock<std::mutex> lk(mu_);
+        idle_cv_.wait(lk, [&]{ return queue_.empty() && !busy_; });
+    }
+
+private:
+    void loop() {
+        t_in_reclaim = true;
+        NodeList work;
+        std::unique_lock<std::mutex> lk(mu_);
+        for (;;) {
+            cv_.wait(lk, [&]{ return stop_ || !queue_.empty(); });
+            if (queue_.empty() && stop_) break;
+            append(work, queue_);
+            busy_ = true;
+            while (!work.empty()) {
+                lk.unlock();
+                drain(work, g_reclaim_batch.load(std::memory_order_relaxed));
+                lk.lock();
+                append(work, queue_); // pick up anything released meanwhile
+            }
+            busy_ = false;
+            idle_cv_.notify_all();
+        }
+    }
+
+    std::mutex mu_;
+    std::condition_variable cv_, idle_cv_;
+    NodeList queue_;
+    bool stop_{false};
+    bool busy_{false};
+    std::thread th_;
+};
+
+// Owns the reclaim thread. Destroyed at static teardown: it disables the
+// background path first, so nodes released later are freed inline.
+struct ReclaimState {
+    std::mutex mu;
+    std::unique_ptr<Reclaimer> r;
+    ~ReclaimState() {
+        g_bg_enabled.store(false);
+        std::lock_guard<std::mutex> lk(mu);
+        r.reset();
+    }
+} g_reclaim_state;
+
+} // namespace
+
+void set_background_reclaim(bool enabled) {
+    std::unique_ptr<Reclaimer> old;
+    {
+        std::lock_guard<std::mutex> lk(g_reclaim_state.mu);
+        if (enabled && !g_reclaim_state.r) g_reclaim_state.r = std::make_unique<Reclaimer>();
+        g_bg_enabled.store(enabled);
+        if (!enabled) old = std::move(g_reclaim_state.r);
+    }
+    old.reset(); // joins after draining whatever was queued
+}
+
+bool background_reclaim_enabled() { return g_bg_enabled.load(); }
+
+void set_reclaim_batch_size(std::size_t n) { g_reclaim_batch.store(n ? n : 1); }
+std::size_t reclaim_batch_size() { return g_reclaim_batch.load(); }
+
+void flush_reclaim() {
+    std::lock_guard<std::mutex> lk(g_reclaim_state.mu);
+    if (g_reclaim_state.r) g_reclaim_state.r->flush();
+}
+
+std::size_t reclaimed_node_count() { return g_reclaimed.load(); }
+
+namespace detail {
+void reclaim_nodes(std::vector<std::shared_ptr<Node>>&& pending) {
+    if (pending.empty()) return;
+    if (g_bg_enabled.load(std::memory_order_relaxed) && !t_in_reclaim) {
+        std::lock_guard<std::mutex> lk(g_reclaim_state.mu);
+        if (g_reclaim_state.r) { g_reclaim_state.r->push(std::move(pending)); return; }
+    }
+    NodeList work(std::move(pending));
+    while (!work.empty()) drain(work, g_reclaim_batch.load(std::memory_order_relaxed));
+}
+} // namespace detail
+
 } // namespace memory
 } // namespace ag
@@ -0,0 +1,25 @@
+// =====================
+// file: cgadimpl/src/core/context.cpp
+// =====================
+#include "ad/context.hpp"
+
+namespace ag {
+
+namespace {
+thread_local ExecutionContext  t_default_ctx;
+thread_local ExecutionContext* t_bound_ctx = nullptr;
+}
+
+ExecutionContext& current_context() {
+    return t_bound_ctx ? *t_bound_ctx : t_default_ctx;
+}
+
+ContextScope::ContextScope(ExecutionContext& ctx) : prev_(t_bound_ctx) {
+    t_bound_ctx = &ctx;
+}
+
+ContextScope::~ContextScope() {
+    t_bound_ctx = prev_;
+}
+
+} // namespace ag
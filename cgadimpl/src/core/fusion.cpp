@@ -0,0 +1,68 @@
+//============================================================
+// file: cgadimpl/src/core/fusion.cpp
+//============================================================
+#include "ad/fusion.hpp"
+#include <memory>
+
+namespace ag {
+namespace fusion {
+
+namespace {
+
+// True when `p` is computed by `op` and only the input slot we hold
+// refers to it, so folding it away is invisible.
+bool exclusive(const std::shared_ptr<Node>& p, Op op) {
+    return p && p->op == op && p.use_count() == 1;
+}
+
+Op fused_activation(Op act) {
+    switch (act) {
+        case Op::Relu: return Op::LinearRelu;
+        case Op::GELU: return Op::LinearGELU;
+        case Op::SiLU: return Op::LinearSiLU;
+        default:       return Op::Leaf;
+    }
+}
+
+} // namespace
+
+/*
+ *  fuse_linear():
+ *  ---------------
+ *  One pass in topological order, so an Add rewritten into FMA is seen
+ *  as such by the activation that reads it. A node keeps its identity
+ *  (and its value); only op, inputs and tape change. The folded node is
+ *  released when it leaves the inputs list.
+ */
+FusionStats fuse_linear(const Value& root) {
+    FusionStats st;
+    for (Node* n : topo_from(root.node.get())) {
+        if (n->op == Op::Add && n->inputs.size() == 2) {
+            // Either operand may be the GEMM; the other becomes the bias,
+            // which must broadcast onto it (not the other way round).
+            for (int k = 0; k < 2; ++k) {
+                if (!exclusive(n->inputs[k], Op::MatMul) || n->inputs[k]->value.shape() != n->value.shape())
+                    continue;
+                std::shared_ptr<Node> mm = n->inputs[k];
+                std::shared_ptr<Node> bias = n->inputs[1 - k];
+                n->op = Op::FMA;
+                n->inputs = {mm->inputs[0], mm->inputs[1], bias};
+                ++st.linear;
+                break;
+            }
+            continue;
+        }
+        const Op fused = fused_activation(n->op);
+        if (fused == Op::Leaf || n->inputs.size() != 1 || !exclusive(n->inputs[0], Op::FMA)) continue;
+        std::shared_ptr<Node> z = n->inputs[0];
+        n->op = fused;
+        n->inputs = z->inputs;
+        // The fused GELU/SiLU VJPs read the pre-activation from the tape.
+        if (fused != Op::LinearRelu) n->tape = {std::make_shared<Tensor>(z->value)};
+        ++st.activation;
+    }
+    return st;
+}
+
+} // namespace fusion
+} // namespace ag
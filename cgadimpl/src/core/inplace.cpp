@@ -23,8 +23,8 @@
 #include "ad/inplace.hpp"
 #include "ad/checkpoint.hpp"
 #include "ad/debug.hpp"
+#include "ad/context.hpp"
 #include <iostream>
-#include <mutex>
 
 namespace ag {
 namespace inplace {
@@ -36,18 +36,16 @@ using NodePtr = std::shared_ptr<Node>; // alias for shared Node references
 // -----------------------------------------------------------------------------
 
 /*
- * These global data structures maintain state about in-place operations.
- * They are shared across all nodes and guarded by a global mutex (g_lock)
- * to ensure thread safety.
+ * These data structures maintain state about in-place operations.
+ * They live in the calling thread's ExecutionContext (see ad/context.hpp),
+ * so there is no global mutex: a graph and its in-place state belong to
+ * one context, and a context is used by one thread at a time.
  *
- * - g_snapshots : maps Node* → snapshot entry (Tensor + version at save)
- * - g_meta      : maps Node* → TensorMeta (current version + alias roots)
- * - g_alias     : maps storage pointer → set of all Nodes sharing that data
+ * - snapshots : maps Node* → snapshot entry (Tensor + version at save)
+ * - meta      : maps Node* → TensorMeta (current version + alias roots)
+ * - alias     : maps storage pointer → set of all Nodes sharing that data
  */
-static std::unordered_map<Node*, SnapshotEntry> g_snapshots;         
-static std::unordered_map<Node*, TensorMeta>    g_meta;              
-static std::unordered_map<void*, std::unordered_set<Node*>> g_alias; 
-static std::mutex g_lock; // protects all global maps from concurrent access
+static State& st() { return current_context().inplace; }
 
 // -----------------------------------------------------------------------------
 // Internal Helper Functions
@@ -65,9 +63,8 @@ static std::mutex g_lock; // protects all global maps from concurrent access
  */
 void register_tensor_alias(void* data_ptr, Node* node) {
     if (!node || !data_ptr) return;
-    std::lock_guard<std::mutex> guard(g_lock);
-    g_alias[data_ptr].insert(node);
-    g_meta[node].alias_roots.insert(data_ptr);
+    st().alias[data_ptr].insert(node);
+    st().meta[node].alias_roots.insert(data_ptr);
 }
 
 /*
@@ -78,7 +75,7 @@ void register_tensor_alias(void* data_ptr, Node* node) {
  */
 void bump_tensor_version(Node* node) {
     if (!node) return;
-    g_meta[node].version++;
+    st().meta[node].version++;
 }
 
 /*
@@ -89,8 +86,8 @@ void bump_tensor_version(Node* node) {
  */
 size_t get_tensor_version(Node* node) {
     if (!node) return 0;
-    auto it = g_meta.find(node);
-    return (it == g_meta.end()) ? 0 : it->second.version;
+    auto it = st().meta.find(node);
+    return (it == st().meta.end()) ? 0 : it->second.version;
 }
 
 /*
@@ -105,12 +102,11 @@ size_t get_tensor_version(Node* node) {
 static void propagate_to_aliases(Node* node, const Tensor& new_value) {
     if (!node) return;
     void* data_ptr = (void*)new_value.data();
-    std::lock_guard<std::mutex> guard(g_lock);
-    auto it = g_alias.find(data_ptr);
-    if (it != g_alias.end()) {
+    auto it = st().alias.find(data_ptr);
+    if (it != st().alias.end()) {
         for (Node* alias_node : it->second) {
             alias_node->value = new_value; // shallow copy (shared buffer)
-            g_meta[alias_node].version = g_meta[node].version;
+            st().meta[alias_node].version = st().meta[node].version;
         }
     }
 }
@@ -149,7 +145,7 @@ void mark_inplace_checkpoint(const NodePtr& node, const InplaceOptions& opts) {
     SnapshotEntry entry;
     entry.snapshot = node->value;                    // store tensor copy
     entry.version_at_save = get_tensor_version(node.get());
-    g_snapshots[node.get()] = entry;
+    st().snapshots[node.get()] = entry;
 
     // Link alias tracking
     register_tensor_alias((void*)node->value.data(), node.get());
@@ -210,13 +206,12 @@ bool recompute_inplace(const NodePtr& node) {
         return false;
     }
 
-    // Update version and snapshot atomically
+    // Update version and snapshot
     {
-        std::lock_guard<std::mutex> guard(g_lock);
-        size_t current_ver = g_meta[raw].version;
+        size_t current_ver = st().meta[raw].version;
         size_t new_ver = current_ver + 1;
-        g_meta[raw].version = new_ver;
-        g_snapshots[raw] = { node->value, new_ver };
+        st().meta[raw].version = new_ver;
+        st().snapshots[raw] = { node->value, new_ver };
     }
 
     // Update any aliased nodes
@@ -256,12 +251,11 @@ bool ensure_inplace_value(const NodePtr& node) {
         return true;
     }
 
-    // Retrieve snapshot safely (without holding lock during recompute)
+    // Copy the snapshot out: recompute below may rehash the map
     SnapshotEntry snap;
     {
-        std::lock_guard<std::mutex> guard(g_lock);
-        auto sit = g_snapshots.find(raw);
-        if (sit != g_snapshots.end()) snap = sit->second;
+        auto sit = st().snapshots.find(raw);
+        if (sit != st().snapshots.end()) snap = sit->second;
     }
     bool has_snapshot = (snap.snapshot.size() != 0);
 
@@ -278,9 +272,8 @@ bool ensure_inplace_value(const NodePtr& node) {
             propagate_to_aliases(raw, node->value);
             std::cerr << "[inplace] restored snapshot for node@" << raw << "\n";
             {
-                std::lock_guard<std::mutex> guard(g_lock);
-                if (g_meta.find(raw) == g_meta.end())
-                    g_meta[raw].version = snap.version_at_save;
+                if (st().meta.find(raw) == st().meta.end())
+                    st().meta[raw].version = snap.version_at_save;
             }
             return true;
         }
@@ -330,10 +323,9 @@ bool ensure_inplace_value(const NodePtr& node) {
 void on_recomputed(Node* raw) {
     if (!raw) return;
     {
-        std::lock_guard<std::mutex> guard(g_lock);
-        size_t new_ver = g_meta[raw].version + 1;
-        g_meta[raw].version = new_ver;
-        g_snapshots[raw] = { raw->value, new_ver };
+        size_t new_ver = st().meta[raw].version + 1;
+        st().meta[raw].version = new_ver;
+        st().snapshots[raw] = { raw->value, new_ver };
     }
     propagate_to_aliases(raw, raw->value);
 }
@@ -345,10 +337,9 @@ void on_recomputed(Node* raw) {
  *  Frees all snapshots, metadata, and alias records.
  */
 void clear_inplace_checkpoints() {
-    std::lock_guard<std::mutex> guard(g_lock);
-    g_snapshots.clear();
-    g_meta.clear();
-    g_alias.clear();
+    st().snapshots.clear();
+    st().meta.clear();
+    st().alias.clear();
 }
 
 // -----------------------------------------------------------------------------
@@ -362,9 +353,8 @@ void clear_inplace_checkpoints() {
  *  Shows which storage addresses are shared and each node’s version.
  */
 void debug_alias_table() {
-    std::lock_guard<std::mutex> guard(g_lock);
     std::cout << "=== Inplace alias table ===\n";
-    for (auto& [ptr, nodes] : g_alias) {
+    for (auto& [ptr, nodes] : st().alias) {
         std::cout << "Storage@" << ptr << " shared by " << nodes.size() << " nodes\n";
         for (Node* n : nodes)
             std::cout << "   node@" << n << " version=" << get_tensor_version(n) << "\n";
@@ -385,8 +375,7 @@ namespace detail {
  */
 bool has_alias(Node* node) {
     if (!node) return false;
-    std::lock_guard<std::mutex> guard(g_lock);
-    for (auto& [ptr, nodes] : g_alias) {
+    for (auto& [ptr, nodes] : st().alias) {
         if (nodes.find(node) != nodes.end())
             return true;
     }
@@ -396,15 +385,14 @@ bool has_alias(Node* node) {
 /*
  * erase_snapshot():
  * ------------------
- *  Deletes a node’s snapshot entry from g_snapshots if it exists.
+ *  Deletes a node’s snapshot entry from st().snapshots if it exists.
  *  Used by aggressive deletion policies to reclaim memory quickly.
  */
 bool erase_snapshot(Node* node) {
     if (!node) return false;
-    std::lock_guard<std::mutex> guard(g_lock);
-    auto it = g_snapshots.find(node);
-    if (it != g_snapshots.end()) {
-        g_snapshots.erase(it);
+    auto it = st().snapshots.find(node);
+    if (it != st().snapshots.end()) {
+        st().snapshots.erase(it);
         return true;
     }
     return false;
@@ -427,9 +415,8 @@ namespace debug {
  *  after in-place operations or recomputation events.
  */
 void print_version_table() {
-    std::lock_guard<std::mutex> guard(g_lock);
     std::cout << "\n=== Inplace Version Table Dump ===\n";
-    for (auto& [node_ptr, meta] : g_meta) {
+    for (auto& [node_ptr, meta] : st().meta) {
         std::cout << " Node@" << node_ptr
                   << " op=" << op_name(node_ptr->op)
                   << " version=" << meta.version << "\n";
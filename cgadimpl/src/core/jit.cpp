@@ -0,0 +1,3088 @@
+// =====================
+// file: cgadimpl/src/core/jit.cpp
+// =====================
+// Lightweight trace -> compile -> replay for CPU graphs.
+//
+// compile() walks a finished forward graph once and lowers it to a Plan:
+// a flat list of Steps reading external inputs/params, embedded literals
+// or earlier slots. With CompileOptions::with_grads the backward pass is
+// appended as more Steps (emit_backward), so parameter gradients are plan
+// outputs too; fuse_linear() first folds MatMul + bias (+ activation)
+// into single GEMM steps. These passes then shape the plan:
+//
+//   fold_constants()    steps reading only literals run once at compile
+//                       time (pretranspose: just Transpose steps).
+//   eliminate_common()  structurally identical steps collapse to the first.
+//   eliminate_dead()    steps no output depends on are dropped.
+//   fuse_elementwise()  chains of elementwise steps (optionally ending in
+//                       a row/whole reduction) become one fused Step that
+//                       streams over the data once, row tile by row tile.
+//   plan_buffers()      maps the remaining slots onto a few reusable arena
+//                       buffers using slot lifetimes.
+//   bind_kernels()      resolves each step to a kernel function pointer,
+//                       preferring the CPU plugin registry.
+//   share_literals()    points every literal at the process-wide copy of
+//                       its value, so plans holding the same weights
+//                       (replicas, batch buckets, loaded copies) keep one.
+//
+// run() then calls those kernels in order (or, with inter_op_threads > 1,
+// in dependency order across a small worker pool; see plan_schedule()),
+// writing straight into preallocated memory; it never touches the heap in
+// steady state. save()/load() store everything before plan_buffers() in a
+// versioned file; a loaded plan repeats plan_buffers() onwards, so the
+// arena layout is always derived, never read from disk.
+// emit_cpp()/load_aot() turn a plan into generated C++ built as a shared
+// object, which then replaces the step loop in run().
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <variant>
+#if defined(_WIN32)
+  #include <process.h>
+#else
+  #include <sys/wait.h>
+  #include <unistd.h>
+#endif
+#include "ad/graph.hpp"
+#include "ad/kernels_api.hpp"
+#include "ad/tracer.hpp"
+
+namespace ag::jit {
+
+using Shape = std::pair<int64_t,int64_t>;
+
+struct Signature {
+    std::vector<Shape> in_shapes;
+    std::vector<Shape> param_shapes;
+    bool matches(const std::vector<Tensor*>& inputs,
+                 const std::vector<Tensor*>& params) const {
+        if (inputs.size() != in_shapes.size() || params.size() != param_shapes.size())
+            return false;
+        for (size_t i=0;i<inputs.size();++i){
+            auto s = inputs[i]->shape();
+            if (s != in_shapes[i]) return false;
+        }
+        for (size_t i=0;i<params.size();++i){
+            auto s = params[i]->shape();
+            if (s != param_shapes[i]) return false;
+        }
+        return true;
+    }
+};
+
+// Arg sources for a Step
+struct ArgInput  { int idx; };   // external input[i]
+struct ArgParam  { int idx; };   // external param[i]
+struct ArgSlot   { int slot; };  // prior computed slot
+struct SharedWeight;
+struct ArgLit {                  // embedded literal
+    Tensor t;
+    std::shared_ptr<const SharedWeight> shared{};   // set by share_literals()
+};
+
+using Arg = std::variant<ArgInput,ArgParam,ArgSlot,ArgLit>;
+
+struct Step;
+
+// A tile of a fused group: rows [i0, i1) x columns [j0, j1). Element (i, j)
+// lives at tile[(i - i0) * ld + (j - j0)].
+struct Block { int64_t i0, i1, j0, j1, ld; };
+
+// How a binary operand maps onto its [R,C] output. Row = [1,C] (stride-0
+// rows), Col = [R,1] (stride-0 columns), Scalar = [1,1]. Fixed by the
+// signature, so bind_kernels() picks a kernel specialised for the pair
+// and nothing is ever expanded to the full shape.
+enum class Bcast : uint8_t { Full, Row, Col, Scalar };
+
+// Bound once per step by bind_kernels(); run() calls these directly.
+//   Kernel: computes a whole step (plain or fused) into y.
+//   Stage:  one fused member over one Block into tile.
+using Kernel  = void (*)(const Step&, const float* const* a, const Shape* as, float* y, float* scratch);
+using Stage   = void (*)(const Step&, const float* const* a, const Shape* as,
+                         const Block& b, float* tile);
+using UnaryFn = void (*)(const float* x, float* y, int64_t n);
+
+// Int8 form of a GEMM step (MatMul, FMA, Linear*), set by
+// Compiled::quantize(). Symmetric scales, real = scale * q: one for the
+// activation operand, one per output column (or one in all) for the
+// weight, which is stored transposed, [N,K], so each dot product reads
+// two contiguous int8 rows. col_scale[j] = a_scale * weight scale.
+struct QuantGemm {
+    float               a_scale{1.f};
+    std::vector<int8_t> w;            // [N,K]
+    std::vector<float>  col_scale;    // N entries, or 1
+    bool                in_int8{false};   // operand 0 is already int8
+    float               out_scale{0.f};   // > 0: output written as int8
+};
+
+struct Step {
+    Op op;
+    std::vector<Arg> args;
+    int out_slot{};                 // where to write result
+    Shape out_shape{};              // rows,cols
+    // >= 0 for a backward step: the VJP of `op` w.r.t. its input grad_of.
+    // args = [upstream grad] + what ops.def says the VJP saves (the
+    // forward inputs, then the forward output); out_shape is that input's.
+    int8_t grad_of{-1};
+
+    // Non-empty for a fused group: the original steps, in order. Member k
+    // reads member k-1's slot (the "chain"), which is never materialised.
+    // The group writes the last member's slot; `op`/`args` are unused.
+    std::vector<Step> members;
+
+    Kernel kernel{nullptr};
+    Stage  stage{nullptr};
+    Bcast  bcast[2]{Bcast::Full, Bcast::Full};   // binary ops only
+    // Plugin entry points captured from kernels::cpu() at compile time;
+    // null when the op has none or the plugin does not provide it.
+    UnaryFn         unary_fn{nullptr};
+    ag_leakyrelu_fn leaky_fn{nullptr};
+    ag_matmul_fn    matmul_fn{nullptr};
+    elem_bwd_fn       grad_fn{nullptr};
+    elem_bwd_alpha_fn grad_alpha_fn{nullptr};
+
+    std::shared_ptr<const QuantGemm> q;   // non-null: runs in int8
+};
+
+struct Plan {
+    Signature sig;
+    std::vector<Step> steps;
+    int num_slots{0};
+    std::vector<int> out_slots;      // one per compiled output, in order
+    std::vector<Shape> slot_shape;   // slot -> shape of the value it holds
+    // Filled by emit_backward(): where d(sum of outputs)/d(param i) is found.
+    std::vector<Arg>   grad_src;
+
+    // Filled by plan_buffers(): slot -> arena buffer, and where each
+    // buffer starts in the single arena allocation (in floats).
+    std::vector<int>    slot_buf;
+    std::vector<size_t> buf_offset;
+    size_t              arena_floats{0};
+    size_t              scratch_offset{0};  // one block for fused reductions
+    size_t              scratch_floats{0};  // its size; each extra run() thread gets another
+    int                 in_place_steps{0};
+    size_t              naive_floats{0};
+    size_t              max_args{0};
+
+    // Filled by the graph passes (see optimize()).
+    int                 folded_steps{0};
+    int                 merged_steps{0};
+    int                 removed_steps{0};
+
+    // Filled by fuse_linear().
+    int                 linear_fused{0};
+
+    // Filled by Compiled::quantize().
+    int                 quantized_steps{0};
+    int                 int8_links{0};
+
+    // Filled by fuse_elementwise().
+    int                 fused_groups{0};
+    int                 fused_members{0};
+
+    // Filled by bind_kernels().
+    int                 plugin_kernels{0};
+
+    int                 threads{1};          // CompileOptions::inter_op_threads
+    bool                reuse_buffers{true}; // CompileOptions::reuse_buffers
+
+    // Filled by plan_schedule(): the step DAG for inter-op parallel runs.
+    std::vector<int>              dep_count;      // unmet predecessors per step
+    std::vector<std::vector<int>> succ;           // steps that wait on step i
+    std::vector<double>           rank;           // flops on the longest path from i to the end
+    std::vector<char>             exclusive;      // runs alone (OpenMP plugin kernel)
+    int                           critical_path{0};
+};
+
+static size_t numel(const Shape& s) { return size_t(s.first) * size_t(s.second); }
+
+static Shape arg_shape(const Plan& plan, const Arg& a) {
+    if (auto* in = std::get_if<ArgInput>(&a)) return plan.sig.in_shapes[in->idx];
+    if (auto* pa = std::get_if<ArgParam>(&a)) return plan.sig.param_shapes[pa->idx];
+    if (auto* sl = std::get_if<ArgSlot>(&a))  return plan.slot_shape[sl->slot];
+    return std::get<ArgLit>(a).t.shape();
+}
+
+static bool is_chain(const Step& group, size_t member, const Arg& a) {
+    auto* s = std::get_if<ArgSlot>(&a);
+    return s && member > 0 && s->slot == group.members[member - 1].out_slot;
+}
+
+// Visit the args a step reads from outside itself (chain links skipped).
+template <class F>
+static void for_each_arg(const Step& st, F f) {
+    if (st.members.empty()) { for (const Arg& a : st.args) f(a); return; }
+    for (size_t k = 0; k < st.members.size(); ++k)
+        for (const Arg& a : st.members[k].args)
+            if (!is_chain(st, k, a)) f(a);
+}
+
+// A fused elementwise group may write its output over a slot read by its
+// first member only: each member finishes element j before the next one
+// reads it, so a later reader would see the overwritten value.
+static bool read_by_later_member(const Step& st, int slot) {
+    for (size_t k = 1; k < st.members.size(); ++k)
+        for (const Arg& a : st.members[k].args)
+            if (auto* s = std::get_if<ArgSlot>(&a); s && s->slot == slot) return true;
+    return false;
+}
+
+static size_t flat_arg_count(const Step& st) {
+    if (st.members.empty()) return st.args.size();
+    size_t n = 0;
+    for (const Step& m : st.members) n += m.args.size();
+    return n;
+}
+
+// ---------------------------------------------------------------------
+// Step kernels: raw-pointer loops that write into a caller-provided
+// output. bind_kernels() picks one per step at compile time, preferring
+// the loaded CPU plugin (the same kernels the eager nodeops call) and
+// falling back to the scalar loops below when the plugin lacks one.
+// ---------------------------------------------------------------------
+namespace {
+
+template <Op> constexpr bool kNever = false;
+
+// Scalar formulas, one per elementwise op, shared by the plain and fused
+// kernels. Numerics follow the eager Tensor / nn implementations.
+template <Op O>
+inline float unary_f(float v, float alpha) {
+    if constexpr (O == Op::Relu)          return v > 0.f ? v : 0.f;
+    else if constexpr (O == Op::Exp)      return std::exp(v);
+    else if constexpr (O == Op::Log)      return std::log(v);
+    else if constexpr (O == Op::Tanh)     return std::tanh(v);
+    else if constexpr (O == Op::Sigmoid)  return 1.f / (1.f + std::exp(-v));
+    else if constexpr (O == Op::Softplus) return std::log1p(std::exp(v));
+    else if constexpr (O == Op::SiLU)     return v * (1.f / (1.f + std::exp(-v)));
+    else if constexpr (O == Op::GELU) {
+        constexpr float c = 0.7978845608028654f; // sqrt(2/pi)
+        return 0.5f * v * (1.f + std::tanh(c * (v + 0.044715f * v * v * v)));
+    }
+    else if constexpr (O == Op::LeakyRelu) return v > 0.f ? v : alpha * v;
+    else static_assert(kNever<O>, "not a unary elementwise op");
+}
+
+template <Op O>
+inline float binary_f(float u, float v) {
+    if constexpr (O == Op::Add)      return u + v;
+    else if constexpr (O == Op::Sub) return u - v;
+    else if constexpr (O == Op::Mul) return u * v;
+    else static_assert(kNever<O>, "not a binary elementwise op");
+}
+
+// LeakyRelu carries its slope as a [1,1] second argument.
+template <Op O>
+inline float alpha_of(const float* const* a) {
+    if constexpr (O == Op::LeakyRelu) return a[1][0];
+    else return 0.f;
+}
+
+float row_max(const float* x, int64_t C) {
+    float m = -INFINITY;
+    for (int64_t j = 0; j < C; ++j) m = std::max(m, x[j]);
+    return m;
+}
+
+float row_lse(const float* x, int64_t C) {
+    float m = row_max(x, C), s = 0.f;
+    for (int64_t j = 0; j < C; ++j) s += std::exp(x[j] - m);
+    return std::log(s) + m;
+}
+
+template <Op O>
+inline float row_reduce(const float* x, int64_t C) {
+    if constexpr (O == Op::RowMax)            return row_max(x, C);
+    else if constexpr (O == Op::LogSumExpRow) return row_lse(x, C);
+    else { float s = 0.f; for (int64_t j = 0; j < C; ++j) s += x[j]; return s; }
+}
+
+void softmax_row(const float* x, float* y, int64_t C) {
+    const float m = row_max(x, C);
+    float s = 0.f;
+    for (int64_t j = 0; j < C; ++j) { y[j] = std::exp(x[j] - m); s += y[j]; }
+    for (int64_t j = 0; j < C; ++j) y[j] /= s;
+}
+
+// Sum of t[j] * (z[j] - lse(z)) over one row (the CE inner term).
+float ce_row(const float* z, const float* t, int64_t C) {
+    const float lse = row_lse(z, C);
+    float s = 0.f;
+    for (int64_t j = 0; j < C; ++j) s += t[j] * (z[j] - lse);
+    return s;
+}
+
+// ---- broadcasting ---------------------------------------------------
+
+Bcast bcast_of(Shape s, Shape out) {
+    const bool rows = s.first == 1 && out.first != 1;
+    const bool cols = s.second == 1 && out.second != 1;
+    return rows && cols ? Bcast::Scalar : rows ? Bcast::Row : cols ? Bcast::Col : Bcast::Full;
+}
+
+// Start of row i of an operand whose output rows are ld wide.
+template <Bcast K>
+inline const float* bc_row(const float* p, int64_t i, int64_t ld) {
+    if constexpr (K == Bcast::Full)     return p + i * ld;
+    else if constexpr (K == Bcast::Col) return p + i;
+    else return p;
+}
+
+// Element j of a row returned by bc_row<K>.
+template <Bcast K>
+inline float bc_at(const float* r, int64_t j) {
+    if constexpr (K == Bcast::Full || K == Bcast::Row) return r[j];
+    else return r[0];
+}
+
+// ---- plain steps ----------------------------------------------------
+// Elementwise kernels may run in place (y == a[0]): every loop reads
+// element i of its inputs before writing element i of y.
+
+template <Op O, Bcast A, Bcast B>
+void k_binary(const Step& st, const float* const* a, const Shape*, float* Y, float*) {
+    const int64_t R = st.out_shape.first, C = st.out_shape.second;
+    if constexpr (A == Bcast::Full && B == Bcast::Full) {
+        const int64_t n = R * C;
+        for (int64_t k = 0; k < n; ++k) Y[k] = binary_f<O>(a[0][k], a[1][k]);
+    } else {
+        for (int64_t i = 0; i < R; ++i) {
+            const float* u = bc_row<A>(a[0], i, C);
+            const float* v = bc_row<B>(a[1], i, C);
+            float* y = Y + i * C;
+            for (int64_t j = 0; j < C; ++j) y[j] = binary_f<O>(bc_at<A>(u, j), bc_at<B>(v, j));
+        }
+    }
+}
+
+template <Op O>
+void k_unary(const Step& st, const float* const* a, const Shape*, float* y, float*) {
+    const float alpha = alpha_of<O>(a);
+    const size_t n = numel(st.out_shape);
+    for (size_t i = 0; i < n; ++i) y[i] = unary_f<O>(a[0][i], alpha);
+}
+
+void k_unary_plugin(const Step& st, const float* const* a, const Shape*, float* y, float*) {
+    st.unary_fn(a[0], y, int64_t(numel(st.out_shape)));
+}
+
+void k_leaky_plugin(const Step& st, const float* const* a, const Shape*, float* y, float*) {
+    st.leaky_fn(a[0], y, int64_t(numel(st.out_shape)), a[1][0]);
+}
+
+void k_transpose(const Step&, const float* const* a, const Shape* as, float* y, float*) {
+    const int64_t R = as[0].first, C = as[0].second;
+    for (int64_t i = 0; i < R; ++i)
+        for (int64_t j = 0; j < C; ++j) y[j * R + i] = a[0][i * C + j];
+}
+
+// y += A @ B, A [M,K], B [K,N].
+void gemm_acc(const float* A, const float* B, float* y, int64_t M, int64_t K, int64_t N) {
+    for (int64_t i = 0; i < M; ++i)
+        for (int64_t k = 0; k < K; ++k) {
+            const float aik = A[i * K + k];
+            const float* b = B + k * N;
+            float* yr = y + i * N;
+            for (int64_t j = 0; j < N; ++j) yr[j] += aik * b[j];
+        }
+}
+
+void k_matmul(const Step& st, const float* const* a, const Shape* as, float* y, float*) {
+    std::fill(y, y + numel(st.out_shape), 0.f);
+    gemm_acc(a[0], a[1], y, as[0].first, as[0].second, as[1].second);
+}
+
+void k_matmul_plugin(const Step& st, const float* const* a, const Shape* as, float* y, float*) {
+    // The plugin accumulates into C, like the eager path's zeroed output.
+    std::fill(y, y + numel(st.out_shape), 0.f);
+    st.matmul_fn(a[0], a[1], y, as[0].first, as[0].second, as[1].second);
+}
+
+// FMA and the fused Linear ops: y = act(a @ b + c). y starts as the
+// broadcast bias and the GEMM accumulates onto it (the plugin's matmul
+// adds into its output); the activation then runs over the finished
+// output in place, while it is still in cache.
+template <Op Act>
+void k_linear(const Step& st, const float* const* a, const Shape* as, float* y, float*) {
+    const int64_t M = as[0].first, K = as[0].second, N = as[1].second;
+    const int64_t rs = as[2].first == 1 ? 0 : as[2].second, cs = as[2].second == 1 ? 0 : 1;
+    for (int64_t i = 0; i < M; ++i)
+        for (int64_t j = 0; j < N; ++j) y[i * N + j] = a[2][i * rs + j * cs];
+    if (st.matmul_fn) st.matmul_fn(a[0], a[1], y, M, K, N);
+    else gemm_acc(a[0], a[1], y, M, K, N);
+    if constexpr (Act != Op::Leaf) {
+        const int64_t n = M * N;
+        if (st.unary_fn) st.unary_fn(y, y, n);
+        else for (int64_t t = 0; t < n; ++t) y[t] = unary_f<Act>(y[t], 0.f);
+    }
+}
+
+// ---- int8 GEMM (Compiled::quantize) ----------------------------------
+
+inline int8_t to_int8(float v, float inv_scale) {
+    const float r = v * inv_scale;
+    return int8_t(std::max(-127.f, std::min(127.f, r + (r >= 0.f ? 0.5f : -0.5f))));
+}
+
+// Integer dots of two rows of x against four rows of w ([N,K]), held in
+// registers so each loaded weight byte feeds two rows.
+inline void dot_int8_2x4(const int8_t* x0, const int8_t* x1, const int8_t* w, int64_t K,
+                         int32_t s[2][4]) {
+    const int8_t *w0 = w, *w1 = w + K, *w2 = w + 2 * K, *w3 = w + 3 * K;
+    int32_t s00 = 0, s01 = 0, s02 = 0, s03 = 0, s10 = 0, s11 = 0, s12 = 0, s13 = 0;
+    for (int64_t k = 0; k < K; ++k) {
+        const int32_t a0 = x0[k], a1 = x1[k];
+        const int32_t b0 = w0[k], b1 = w1[k], b2 = w2[k], b3 = w3[k];
+        s00 += a0 * b0; s01 += a0 * b1; s02 += a0 * b2; s03 += a0 * b3;
+        s10 += a1 * b0; s11 += a1 * b1; s12 += a1 * b2; s13 += a1 * b3;
+    }
+    s[0][0] = s00; s[0][1] = s01; s[0][2] = s02; s[0][3] = s03;
+    s[1][0] = s10; s[1][1] = s11; s[1][2] = s12; s[1][3] = s13;
+}
+
+inline int32_t dot_int8(const int8_t* x, const int8_t* w, int64_t K) {
+    int32_t s = 0;
+    for (int64_t k = 0; k < K; ++k) s += int32_t(x[k]) * int32_t(w[k]);
+    return s;
+}
+
+// y = act(a @ b + c) with a quantised into scratch (unless its producer
+// already wrote int8), int32 dot products against the int8 weight, then
+// one epilogue per element: rescale, bias, activation, and either the
+// float result or its requantisation for the next int8 step.
+template <Op Act>
+void k_qgemm(const Step& st, const float* const* a, const Shape* as, float* y, float* scratch) {
+    const QuantGemm& q = *st.q;
+    const int64_t M = as[0].first, K = as[0].second, N = st.out_shape.second;
+    const int8_t* xa = reinterpret_cast<const int8_t*>(a[0]);
+    if (!q.in_int8) {
+        int8_t* t = reinterpret_cast<int8_t*>(scratch);
+        const float inv = 1.f / q.a_scale;
+        for (int64_t i = 0; i < M * K; ++i) t[i] = to_int8(a[0][i], inv);
+        xa = t;
+    }
+    const bool bias = st.op != Op::MatMul;
+    const int64_t rs = bias && as[2].first != 1 ? as[2].second : 0, cs = bias && as[2].second != 1 ? 1 : 0;
+    const bool per_col = q.col_scale.size() > 1;
+    const float out_inv = q.out_scale > 0.f ? 1.f / q.out_scale : 0.f;
+    int8_t* yq = reinterpret_cast<int8_t*>(y);
+    const int8_t* w = q.w.data();
+    auto store = [&](int64_t i, int64_t j, int32_t acc) {
+        float v = float(acc) * q.col_scale[per_col ? j : 0];
+        if (bias) v += a[2][i * rs + j * cs];
+        if constexpr (Act != Op::Leaf) v = unary_f<Act>(v, 0.f);
+        if (out_inv > 0.f) yq[i * N + j] = to_int8(v, out_inv);
+        else               y[i * N + j] = v;
+    };
+    int64_t i = 0;
+    for (; i + 2 <= M; i += 2) {
+        const int8_t *x0 = xa + i * K, *x1 = x0 + K;
+        int64_t j = 0;
+        for (; j + 4 <= N; j += 4) {
+            int32_t s[2][4];
+            dot_int8_2x4(x0, x1, w + j * K, K, s);
+            for (int c = 0; c < 4; ++c) { store(i, j + c, s[0][c]); store(i + 1, j + c, s[1][c]); }
+        }
+        for (; j < N; ++j) {
+            store(i, j, dot_int8(x0, w + j * K, K));
+            store(i + 1, j, dot_int8(x1, w + j * K, K));
+        }
+    }
+    for (; i < M; ++i)
+        for (int64_t j = 0; j < N; ++j) store(i, j, dot_int8(xa + i * K, w + j * K, K));
+}
+
+template <Op O>
+void k_total(const Step&, const float* const* a, const Shape* as, float* y, float*) {
+    const size_t m = numel(as[0]);
+    float s = 0.f;
+    for (size_t i = 0; i < m; ++i) s += a[0][i];
+    y[0] = (O == Op::MeanAll) ? s / float(m) : s;
+}
+
+template <Op O>
+void k_rows(const Step&, const float* const* a, const Shape* as, float* y, float*) {
+    const int64_t R = as[0].first, C = as[0].second;
+    for (int64_t i = 0; i < R; ++i) y[i] = row_reduce<O>(a[0] + i * C, C);
+}
+
+void k_softmax(const Step&, const float* const* a, const Shape* as, float* y, float*) {
+    const int64_t R = as[0].first, C = as[0].second;
+    for (int64_t i = 0; i < R; ++i) softmax_row(a[0] + i * C, y + i * C, C);
+}
+
+void k_ce(const Step&, const float* const* a, const Shape* as, float* y, float*) {
+    // CE = -mean( sum( Y * (Z - lse(Z)), axis=1 ) )
+    const int64_t R = as[0].first, C = as[0].second;
+    float s = 0.f;
+    for (int64_t i = 0; i < R; ++i) s += ce_row(a[0] + i * C, a[1] + i * C, C);
+    y[0] = -s / float(R);
+}
+
+// ---- backward steps -------------------------------------------------
+// a[0] is the upstream gradient g; the saved forward values follow in
+// the order Step::grad_of documents. Every kernel overwrites y.
+
+// VJP of an elementwise op, one per op: g * d op / d x, where v is the
+// saved input x, or the output y for ops whose ops.def row saves Output.
+template <Op O>
+inline float dunary_f(float g, float v, float alpha) {
+    if constexpr (O == Op::Relu)          return v > 0.f ? g : 0.f;
+    else if constexpr (O == Op::Exp)      return g * v;
+    else if constexpr (O == Op::Log)      return g / v;
+    else if constexpr (O == Op::Tanh)     return g * (1.f - v * v);
+    else if constexpr (O == Op::Sigmoid)  return g * v * (1.f - v);
+    else if constexpr (O == Op::Softplus) return g / (1.f + std::exp(-v));
+    else if constexpr (O == Op::SiLU) {
+        const float s = 1.f / (1.f + std::exp(-v));
+        return g * (s + v * s * (1.f - s));
+    }
+    else if constexpr (O == Op::GELU) {
+        constexpr float c = 0.7978845608028654f; // sqrt(2/pi)
+        const float th = std::tanh(c * (v + 0.044715f * v * v * v));
+        const float dudx = c * (1.f + 0.134145f * v * v);
+        return g * (0.5f * (1.f + th) + 0.5f * v * (1.f - th * th) * dudx);
+    }
+    else if constexpr (O == Op::LeakyRelu) return v > 0.f ? g : alpha * g;
+    else static_assert(kNever<O>, "not a unary elementwise op");
+}
+
+// y = sign * g * other, summed over the axes y was broadcast along to
+// reach g's shape. `other` (may be null) broadcasts onto g. When nothing
+// is summed each element is read before it is written, so y may be g.
+void reduce_into(float* y, Shape ys, const float* g, Shape gs, float sign,
+                 const float* other, Shape os) {
+    const int64_t R = gs.first, C = gs.second;
+    if (ys == gs && (!other || os == gs)) {
+        const int64_t n = R * C;
+        if (other) for (int64_t k = 0; k < n; ++k) y[k] = sign * g[k] * other[k];
+        else       for (int64_t k = 0; k < n; ++k) y[k] = sign * g[k];
+        return;
+    }
+    const bool sum = ys != gs;
+    if (sum) std::fill(y, y + numel(ys), 0.f);
+    for (int64_t i = 0; i < R; ++i) {
+        float* yr = y + (ys.first == 1 ? 0 : i) * ys.second;
+        const float* o = other ? other + (os.first == 1 ? 0 : i) * os.second : nullptr;
+        for (int64_t j = 0; j < C; ++j) {
+            float v = sign * g[i * C + j];
+            if (o) v *= o[os.second == 1 ? 0 : j];
+            float& d = yr[ys.second == 1 ? 0 : j];
+            d = sum ? d + v : v;
+        }
+    }
+}
+
+template <int Sign>
+void k_grad_add(const Step& st, const float* const* a, const Shape* as, float* y, float*) {
+    reduce_into(y, st.out_shape, a[0], as[0], float(Sign), nullptr, Shape{});
+}
+
+void k_grad_mul(const Step& st, const float* const* a, const Shape* as, float* y, float*) {
+    const int other = 2 - st.grad_of;   // args = [g, u, v]
+    reduce_into(y, st.out_shape, a[0], as[0], 1.f, a[other], as[other]);
+}
+
+template <Op O>
+void k_grad_unary(const Step& st, const float* const* a, const Shape*, float* y, float*) {
+    const float alpha = O == Op::LeakyRelu ? a[2][0] : 0.f;
+    const size_t n = numel(st.out_shape);
+    for (size_t i = 0; i < n; ++i) y[i] = dunary_f<O>(a[0][i], a[1][i], alpha);
+}
+
+void k_grad_unary_plugin(const Step& st, const float* const* a, const Shape*, float* y, float*) {
+    st.grad_fn(a[1], a[0], y, int64_t(numel(st.out_shape)));
+}
+
+void k_grad_leaky_plugin(const Step& st, const float* const* a, const Shape*, float* y, float*) {
+    st.grad_alpha_fn(a[1], a[0], y, int64_t(numel(st.out_shape)), a[2][0]);
+}
+
+template <Op O>
+void k_grad_total(const Step& st, const float* const* a, const Shape*, float* y, float*) {
+    const size_t n = numel(st.out_shape);
+    const float g = (O == Op::MeanAll) ? a[0][0] / float(n) : a[0][0];
+    std::fill(y, y + n, g);
+}
+
+// RowMax / LogSumExpRow save both ends: args = [g (R,1), x, y (R,1)].
+template <Op O>
+void k_grad_rows(const Step&, const float* const* a, const Shape* as, float* y, float*) {
+    const int64_t R = as[1].first, C = as[1].second;
+    for (int64_t i = 0; i < R; ++i) {
+        const float g = a[0][i];
+        const float* x = a[1] + i * C;
+        float* d = y + i * C;
+        if constexpr (O == Op::RowMax)
+            for (int64_t j = 0; j < C; ++j) d[j] = x[j] == a[2][i] ? g : 0.f;
+        else
+            for (int64_t j = 0; j < C; ++j) d[j] = std::exp(x[j] - a[2][i]) * g;
+    }
+}
+
+// RowSum saves nothing: args = [g], and the input shape is the step's.
+void k_grad_rowsum(const Step& st, const float* const* a, const Shape*, float* y, float*) {
+    const int64_t R = st.out_shape.first, C = st.out_shape.second;
+    for (int64_t i = 0; i < R; ++i) std::fill(y + i * C, y + (i + 1) * C, a[0][i]);
+}
+
+void k_grad_softmax(const Step&, const float* const* a, const Shape* as, float* y, float*) {
+    // args = [g, s]: dz = s * (g - rowsum(s * g))
+    const int64_t R = as[1].first, C = as[1].second;
+    for (int64_t i = 0; i < R; ++i) {
+        const float* g = a[0] + i * C;
+        const float* s = a[1] + i * C;
+        float dot = 0.f;
+        for (int64_t j = 0; j < C; ++j) dot += s[j] * g[j];
+        for (int64_t j = 0; j < C; ++j) y[i * C + j] = s[j] * (g[j] - dot);
+    }
+}
+
+void k_grad_ce(const Step& st, const float* const* a, const Shape* as, float* y, float*) {
+    // args = [g, z, t]: dz = (softmax(z) - t) * g / R, dt = (z - lse(z)) * -g / R
+    const int64_t R = as[1].first, C = as[1].second;
+    const float scale = a[0][0] / float(R);
+    for (int64_t i = 0; i < R; ++i) {
+        const float* z = a[1] + i * C;
+        const float* t = a[2] + i * C;
+        float* d = y + i * C;
+        if (st.grad_of == 0) {
+            softmax_row(z, d, C);
+            for (int64_t j = 0; j < C; ++j) d[j] = (d[j] - t[j]) * scale;
+        } else {
+            const float lse = row_lse(z, C);
+            for (int64_t j = 0; j < C; ++j) d[j] = (z[j] - lse) * -scale;
+        }
+    }
+}
+
+bool supported(Op op) {
+    switch (op) {
+        case Op::Add: case Op::Sub: case Op::Mul: case Op::Relu: case Op::Exp: case Op::Log:
+        case Op::Tanh: case Op::Sigmoid: case Op::Softplus: case Op::SiLU: case Op::GELU:
+        case Op::LeakyRelu: case Op::Transpose: case Op::MatMul: case Op::Sum: case Op::MeanAll:
+        case Op::RowSum: case Op::RowMax: case Op::LogSumExpRow: case Op::SoftmaxRow:
+        case Op::CeWithLogits: case Op::FMA: case Op::LinearRelu: case Op::LinearGELU:
+        case Op::LinearSiLU:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// ---------------------------------------------------------------------
+// Fused groups: evaluated block by block, each block holding at most
+// kTile floats, so chain intermediates stay in cache and only the group's
+// external inputs and final output touch memory. A block is a run of
+// whole rows, or (for rows wider than kTile) a column chunk of one row.
+// ---------------------------------------------------------------------
+constexpr int64_t kTile = 4096;
+
+inline int64_t block_rows(Shape s) {
+    return s.second >= kTile ? 1 : std::max<int64_t>(1, std::min(s.first, kTile / s.second));
+}
+
+bool fusible_elementwise(Op op) { return op_fusible(op) && supported(op); }
+
+// Reductions a chain may end in. All read the chain value as arg 0.
+bool fusible_tail(Op op) {
+    switch (op) {
+        case Op::Sum: case Op::MeanAll: case Op::RowSum: case Op::RowMax:
+        case Op::LogSumExpRow: case Op::SoftmaxRow: case Op::CeWithLogits:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Row i of a stage operand, indexed by absolute column j. A null pointer
+// is the chain value, which lives in the tile (and is always Full).
+template <Bcast K>
+inline const float* stage_row(const float* p, int64_t i, const Block& b, float* tile) {
+    return p ? bc_row<K>(p, i, b.ld) : tile + (i - b.i0) * b.ld - b.j0;
+}
+
+template <Op O, Bcast A, Bcast B>
+void s_binary(const Step&, const float* const* a, const Shape*, const Block& b, float* tile) {
+    for (int64_t i = b.i0; i < b.i1; ++i) {
+        const float* u = stage_row<A>(a[0], i, b, tile);
+        const float* v = stage_row<B>(a[1], i, b, tile);
+        float* t = tile + (i - b.i0) * b.ld - b.j0;
+        for (int64_t j = b.j0; j < b.j1; ++j) t[j] = binary_f<O>(bc_at<A>(u, j), bc_at<B>(v, j));
+    }
+}
+
+template <Op O>
+void s_unary(const Step&, const float* const* a, const Shape*, const Block& b, float* tile) {
+    const float alpha = alpha_of<O>(a);
+    for (int64_t i = b.i0; i < b.i1; ++i) {
+        const float* x = stage_row<Bcast::Full>(a[0], i, b, tile);
+        float* t = tile + (i - b.i0) * b.ld - b.j0;
+        for (int64_t j = b.j0; j < b.j1; ++j) t[j] = unary_f<O>(x[j], alpha);
+    }
+}
+
+// A unary arg has the output's shape, so both it and the tile are one
+// contiguous run and the plugin kernel covers the block in a single call.
+inline const float* unary_src(const float* const* a, const Shape* as, const Block& b, float* tile) {
+    return a[0] ? a[0] + b.i0 * as[0].second + b.j0 : tile;
+}
+
+void s_unary_plugin(const Step& m, const float* const* a, const Shape* as, const Block& b, float* tile) {
+    m.unary_fn(unary_src(a, as, b, tile), tile, (b.i1 - b.i0) * (b.j1 - b.j0));
+}
+
+void s_leaky_plugin(const Step& m, const float* const* a, const Shape* as, const Block& b, float* tile) {
+    m.leaky_fn(unary_src(a, as, b, tile), tile, (b.i1 - b.i0) * (b.j1 - b.j0), a[1][0]);
+}
+
+// Op::Leaf as Tail means "no reduction": the chain itself is the output.
+// Reducing groups build each block in scratch, then fold its rows.
+template <Op Tail>
+void k_fused(const Step& g, const float* const* a, const Shape* as, float* y, float* scratch) {
+    constexpr bool reduce = Tail != Op::Leaf;
+    const size_t n_elem = g.members.size() - (reduce ? 1 : 0);
+    const Shape e = g.members.front().out_shape;
+    const int64_t R = e.first, C = e.second, rb = block_rows(e), cb = std::min(C, kTile);
+
+    size_t tail_off = 0;
+    for (size_t k = 0; k < n_elem; ++k) tail_off += g.members[k].args.size();
+
+    float acc = 0.f;
+    for (int64_t i0 = 0; i0 < R; i0 += rb) {
+        const int64_t i1 = std::min(R, i0 + rb);
+        float* base = reduce ? scratch : y + i0 * C;
+        for (int64_t j0 = 0; j0 < C; j0 += cb) {
+            const Block b{i0, i1, j0, std::min(C, j0 + cb), C};
+            size_t off = 0;
+            for (size_t k = 0; k < n_elem; ++k) {
+                const Step& m = g.members[k];
+                m.stage(m, a + off, as + off, b, base + j0);
+                off += m.args.size();
+            }
+        }
+        if constexpr (reduce) {
+            for (int64_t i = i0; i < i1; ++i) {
+                const float* row = base + (i - i0) * C;
+                if constexpr (Tail == Op::Sum || Tail == Op::MeanAll) {
+                    for (int64_t j = 0; j < C; ++j) acc += row[j];
+                } else if constexpr (Tail == Op::SoftmaxRow) {
+                    softmax_row(row, y + i * C, C);
+                } else if constexpr (Tail == Op::CeWithLogits) {
+                    acc += ce_row(row, a[tail_off + 1] + i * C, C);
+                } else {
+                    y[i] = row_reduce<Tail>(row, C);
+                }
+            }
+        }
+    }
+    if constexpr (Tail == Op::Sum)          y[0] = acc;
+    if constexpr (Tail == Op::MeanAll)      y[0] = acc / float(R * C);
+    if constexpr (Tail == Op::CeWithLogits) y[0] = -acc / float(R);
+}
+
+// ---- binding --------------------------------------------------------
+
+struct BinaryFns { Kernel kernel; Stage stage; };
+
+template <Op O, Bcast A>
+BinaryFns binary_fns(Bcast b) {
+    switch (b) {
+        case Bcast::Full:   return {&k_binary<O, A, Bcast::Full>,   &s_binary<O, A, Bcast::Full>};
+        case Bcast::Row:    return {&k_binary<O, A, Bcast::Row>,    &s_binary<O, A, Bcast::Row>};
+        case Bcast::Col:    return {&k_binary<O, A, Bcast::Col>,    &s_binary<O, A, Bcast::Col>};
+        case Bcast::Scalar: return {&k_binary<O, A, Bcast::Scalar>, &s_binary<O, A, Bcast::Scalar>};
+    }
+    return {};
+}
+
+template <Op O>
+BinaryFns binary_fns(const Step& st) {
+    switch (st.bcast[0]) {
+        case Bcast::Full:   return binary_fns<O, Bcast::Full>(st.bcast[1]);
+        case Bcast::Row:    return binary_fns<O, Bcast::Row>(st.bcast[1]);
+        case Bcast::Col:    return binary_fns<O, Bcast::Col>(st.bcast[1]);
+        case Bcast::Scalar: return binary_fns<O, Bcast::Scalar>(st.bcast[1]);
+    }
+    return {};
+}
+
+UnaryFn plugin_unary(Op op, const kernels::Cpu& cpu) {
+    switch (op) {
+        case Op::Relu:     return cpu.relu;
+        case Op::Exp:      return cpu.exp;
+        case Op::Log:      return cpu.log;
+        case Op::Tanh:     return cpu.tanh;
+        case Op::Sigmoid:  return cpu.sigmoid;
+        case Op::Softplus: return cpu.softplus;
+        case Op::GELU:     return cpu.gelu;
+        default:           return nullptr;   // eager has no plugin path either
+    }
+}
+
+// Captures the plugin kernel for a unary op in `st` and returns which of
+// the two variants (plugin or scalar) to call.
+template <Op O, class Fn>
+Fn bind_unary(Step& st, const kernels::Cpu& cpu, Fn plugin, Fn scalar) {
+    if constexpr (O == Op::LeakyRelu) {
+        st.leaky_fn = cpu.leakyrelu;
+        return st.leaky_fn ? plugin : scalar;
+    } else {
+        st.unary_fn = plugin_unary(O, cpu);
+        return st.unary_fn ? plugin : scalar;
+    }
+}
+
+template <Op O>
+Kernel unary_kernel(Step& st, const kernels::Cpu& cpu) {
+    return bind_unary<O, Kernel>(st, cpu, O == Op::LeakyRelu ? &k_leaky_plugin : &k_unary_plugin, &k_unary<O>);
+}
+
+template <Op O>
+Stage unary_stage(Step& m, const kernels::Cpu& cpu) {
+    return bind_unary<O, Stage>(m, cpu, O == Op::LeakyRelu ? &s_leaky_plugin : &s_unary_plugin, &s_unary<O>);
+}
+
+Stage member_stage(Step& m, const kernels::Cpu& cpu) {
+    switch (m.op) {
+        case Op::Add:       return binary_fns<Op::Add>(m).stage;
+        case Op::Sub:       return binary_fns<Op::Sub>(m).stage;
+        case Op::Mul:       return binary_fns<Op::Mul>(m).stage;
+        case Op::Relu:      return unary_stage<Op::Relu>(m, cpu);
+        case Op::Exp:       return unary_stage<Op::Exp>(m, cpu);
+        case Op::Log:       return unary_stage<Op::Log>(m, cpu);
+        case Op::Tanh:      return unary_stage<Op::Tanh>(m, cpu);
+        case Op::Sigmoid:   return unary_stage<Op::Sigmoid>(m, cpu);
+        case Op::Softplus:  return unary_stage<Op::Softplus>(m, cpu);
+        case Op::SiLU:      return unary_stage<Op::SiLU>(m, cpu);
+        case Op::GELU:      return unary_stage<Op::GELU>(m, cpu);
+        case Op::LeakyRelu: return unary_stage<Op::LeakyRelu>(m, cpu);
+        default:            return nullptr;
+    }
+}
+
+Kernel fused_kernel(Op tail) {
+    switch (tail) {
+        case Op::Sum:          return &k_fused<Op::Sum>;
+        case Op::MeanAll:      return &k_fused<Op::MeanAll>;
+        case Op::RowSum:       return &k_fused<Op::RowSum>;
+        case Op::RowMax:       return &k_fused<Op::RowMax>;
+        case Op::LogSumExpRow: return &k_fused<Op::LogSumExpRow>;
+        case Op::SoftmaxRow:   return &k_fused<Op::SoftmaxRow>;
+        case Op::CeWithLogits: return &k_fused<Op::CeWithLogits>;
+        default:               return &k_fused<Op::Leaf>;
+    }
+}
+
+template <Op Act>
+Kernel linear_kernel(Step& st, const kernels::Cpu& cpu) {
+    st.matmul_fn = cpu.matmul;
+    if constexpr (Act != Op::Leaf) st.unary_fn = plugin_unary(Act, cpu);
+    return &k_linear<Act>;
+}
+
+Kernel plain_kernel(Step& st, const kernels::Cpu& cpu) {
+    switch (st.op) {
+        case Op::Add:          return binary_fns<Op::Add>(st).kernel;
+        case Op::Sub:          return binary_fns<Op::Sub>(st).kernel;
+        case Op::Mul:          return binary_fns<Op::Mul>(st).kernel;
+        case Op::Relu:         return unary_kernel<Op::Relu>(st, cpu);
+        case Op::Exp:          return unary_kernel<Op::Exp>(st, cpu);
+        case Op::Log:          return unary_kernel<Op::Log>(st, cpu);
+        case Op::Tanh:         return unary_kernel<Op::Tanh>(st, cpu);
+        case Op::Sigmoid:      return unary_kernel<Op::Sigmoid>(st, cpu);
+        case Op::Softplus:     return unary_kernel<Op::Softplus>(st, cpu);
+        case Op::SiLU:         return unary_kernel<Op::SiLU>(st, cpu);
+        case Op::GELU:         return unary_kernel<Op::GELU>(st, cpu);
+        case Op::LeakyRelu:    return unary_kernel<Op::LeakyRelu>(st, cpu);
+        case Op::Transpose:    return &k_transpose;
+        case Op::MatMul:
+            st.matmul_fn = cpu.matmul;
+            return st.matmul_fn ? &k_matmul_plugin : &k_matmul;
+        case Op::FMA:          return linear_kernel<Op::Leaf>(st, cpu);
+        case Op::LinearRelu:   return linear_kernel<Op::Relu>(st, cpu);
+        case Op::LinearGELU:   return linear_kernel<Op::GELU>(st, cpu);
+        case Op::LinearSiLU:   return linear_kernel<Op::SiLU>(st, cpu);
+        case Op::Sum:          return &k_total<Op::Sum>;
+        case Op::MeanAll:      return &k_total<Op::MeanAll>;
+        case Op::RowSum:       return &k_rows<Op::RowSum>;
+        case Op::RowMax:       return &k_rows<Op::RowMax>;
+        case Op::LogSumExpRow: return &k_rows<Op::LogSumExpRow>;
+        case Op::SoftmaxRow:   return &k_softmax;
+        case Op::CeWithLogits: return &k_ce;
+        default:               return nullptr;
+    }
+}
+
+elem_bwd_fn plugin_unary_bwd(Op op, const kernels::Cpu& cpu) {
+    switch (op) {
+        case Op::Relu:     return cpu.relu_bwd;
+        case Op::Exp:      return cpu.exp_bwd_from_y;
+        case Op::Log:      return cpu.log_bwd;
+        case Op::Tanh:     return cpu.tanh_bwd_from_t;
+        case Op::Sigmoid:  return cpu.sigmoid_bwd_from_s;
+        case Op::Softplus: return cpu.softplus_bwd;
+        case Op::GELU:     return cpu.gelu_bwd;
+        default:           return nullptr;
+    }
+}
+
+template <Op O>
+Kernel grad_unary_kernel(Step& st, const kernels::Cpu& cpu) {
+    if constexpr (O == Op::LeakyRelu) {
+        st.grad_alpha_fn = cpu.leakyrelu_bwd;
+        return st.grad_alpha_fn ? &k_grad_leaky_plugin : &k_grad_unary<O>;
+    } else {
+        st.grad_fn = plugin_unary_bwd(O, cpu);
+        return st.grad_fn ? &k_grad_unary_plugin : &k_grad_unary<O>;
+    }
+}
+
+// MatMul and Transpose never get here: emit_backward() lowers their VJPs
+// to forward MatMul/Transpose steps.
+Kernel grad_kernel(Step& st, const kernels::Cpu& cpu) {
+    switch (st.op) {
+        case Op::Add:          return &k_grad_add<1>;
+        case Op::Sub:          return st.grad_of == 0 ? &k_grad_add<1> : &k_grad_add<-1>;
+        case Op::Mul:          return &k_grad_mul;
+        case Op::Relu:         return grad_unary_kernel<Op::Relu>(st, cpu);
+        case Op::Exp:          return grad_unary_kernel<Op::Exp>(st, cpu);
+        case Op::Log:          return grad_unary_kernel<Op::Log>(st, cpu);
+        case Op::Tanh:         return grad_unary_kernel<Op::Tanh>(st, cpu);
+        case Op::Sigmoid:      return grad_unary_kernel<Op::Sigmoid>(st, cpu);
+        case Op::Softplus:     return grad_unary_kernel<Op::Softplus>(st, cpu);
+        case Op::SiLU:         return grad_unary_kernel<Op::SiLU>(st, cpu);
+        case Op::GELU:         return grad_unary_kernel<Op::GELU>(st, cpu);
+        case Op::LeakyRelu:    return grad_unary_kernel<Op::LeakyRelu>(st, cpu);
+        case Op::Sum:          return &k_grad_total<Op::Sum>;
+        case Op::MeanAll:      return &k_grad_total<Op::MeanAll>;
+        case Op::RowSum:       return &k_grad_rowsum;
+        case Op::RowMax:       return &k_grad_rows<Op::RowMax>;
+        case Op::LogSumExpRow: return &k_grad_rows<Op::LogSumExpRow>;
+        case Op::SoftmaxRow:   return &k_grad_softmax;
+        case Op::CeWithLogits: return &k_grad_ce;
+        default:               return nullptr;
+    }
+}
+
+Kernel quant_kernel(Op op) {
+    switch (op) {
+        case Op::MatMul: case Op::FMA: return &k_qgemm<Op::Leaf>;
+        case Op::LinearRelu:           return &k_qgemm<Op::Relu>;
+        case Op::LinearGELU:           return &k_qgemm<Op::GELU>;
+        case Op::LinearSiLU:           return &k_qgemm<Op::SiLU>;
+        default:                       return nullptr;
+    }
+}
+
+bool uses_plugin(const Step& st) {
+    return st.unary_fn || st.leaky_fn || st.matmul_fn || st.grad_fn || st.grad_alpha_fn;
+}
+
+} // namespace
+
+/*
+ *  bind_kernels():
+ *  ----------------
+ *  Resolves every step (and every member of a fused step) to a function
+ *  pointer once, so execute() is a straight loop of indirect calls with
+ *  no per-step dispatch on the op. Binary ops get a kernel specialised
+ *  for the broadcast kind of each operand. Plugin entry points are read from
+ *  kernels::cpu() here and stored in the step; a plugin loaded later only
+ *  affects plans compiled after it.
+ */
+static void set_bcast(const Plan& plan, Step& st) {
+    if (op_kind(st.op) != OpKind::Elementwise || st.grad_of >= 0) return;
+    for (size_t k = 0; k < st.args.size() && k < 2; ++k)
+        st.bcast[k] = bcast_of(arg_shape(plan, st.args[k]), st.out_shape);
+}
+
+static void bind_kernels(Plan& plan) {
+    const kernels::Cpu& cpu = kernels::cpu();
+    plan.plugin_kernels = 0;
+    for (Step& st : plan.steps) {
+        if (st.members.empty()) {
+            set_bcast(plan, st);
+            st.kernel = st.q ? quant_kernel(st.op) : st.grad_of < 0 ? plain_kernel(st, cpu) : grad_kernel(st, cpu);
+            if (!st.kernel)
+                throw std::runtime_error(std::string("jit: no replay kernel for op ") + op_name(st.op));
+            plan.plugin_kernels += uses_plugin(st);
+            continue;
+        }
+        const bool reduce = op_kind(st.members.back().op) != OpKind::Elementwise;
+        st.kernel = fused_kernel(reduce ? st.members.back().op : Op::Leaf);
+        for (size_t k = 0; k + (reduce ? 1 : 0) < st.members.size(); ++k) {
+            Step& m = st.members[k];
+            set_bcast(plan, m);
+            m.stage = member_stage(m, cpu);
+            if (!m.stage)
+                throw std::runtime_error(std::string("jit: no fused stage for op ") + op_name(m.op));
+            plan.plugin_kernels += uses_plugin(m);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------
+// Graph passes. They run on the unfused step list, after emit_backward().
+// fold_constants() and eliminate_common() only redirect readers; the steps
+// they make redundant are left in place for eliminate_dead() to drop, so
+// each pass can be switched off on its own.
+// ---------------------------------------------------------------------
+
+template <class F>
+static void for_each_output(Plan& plan, F f) {
+    for (int& s : plan.out_slots) f(s);
+    for (Arg& a : plan.grad_src)
+        if (auto* s = std::get_if<ArgSlot>(&a)) f(s->slot);
+}
+
+// Runs one step whose args are all literals and returns its value.
+static Tensor eval_literal(const Plan& plan, Step st, const kernels::Cpu& cpu) {
+    set_bcast(plan, st);
+    st.kernel = st.grad_of < 0 ? plain_kernel(st, cpu) : grad_kernel(st, cpu);
+    if (!st.kernel) throw std::runtime_error(std::string("jit: no replay kernel for op ") + op_name(st.op));
+    std::vector<const float*> p;
+    std::vector<Shape> shapes;
+    for (const Arg& a : st.args) {
+        const Tensor& t = std::get<ArgLit>(a).t;
+        p.push_back(t.data());
+        shapes.push_back(t.shape());
+    }
+    Tensor y(st.out_shape.first, st.out_shape.second);
+    st.kernel(st, p.data(), shapes.data(), y.data(), nullptr);
+    return y;
+}
+
+/*
+ *  fold_constants():
+ *  ------------------
+ *  Walks the steps in order; a step whose args are all literals (or were
+ *  folded already) is evaluated with its replay kernel and every later
+ *  reader gets the result as an ArgLit. With all_ops == false only
+ *  Transpose steps fold: constant weights feeding Transpose + MatMul are
+ *  stored pre-transposed. Returns the number of folded steps.
+ */
+static int fold_constants(Plan& plan, bool all_ops) {
+    const kernels::Cpu& cpu = kernels::cpu();
+    std::unordered_map<int, Tensor> folded;
+    auto redirect = [&](Arg& a) {
+        auto* s = std::get_if<ArgSlot>(&a);
+        if (!s) return;
+        auto it = folded.find(s->slot);
+        if (it != folded.end()) a = ArgLit{it->second};
+    };
+    for (Step& st : plan.steps) {
+        for (Arg& a : st.args) redirect(a);
+        if (!all_ops && st.op != Op::Transpose) continue;
+        const bool lits = std::all_of(st.args.begin(), st.args.end(),
+                                      [](const Arg& a) { return std::holds_alternative<ArgLit>(a); });
+        if (lits) folded.emplace(st.out_slot, eval_literal(plan, st, cpu));
+    }
+    for (Arg& a : plan.grad_src) redirect(a);
+    return int(folded.size());
+}
+
+static bool same_arg(const Arg& a, const Arg& b) {
+    if (a.index() != b.index()) return false;
+    if (auto* x = std::get_if<ArgInput>(&a)) return x->idx == std::get<ArgInput>(b).idx;
+    if (auto* x = std::get_if<ArgParam>(&a)) return x->idx == std::get<ArgParam>(b).idx;
+    if (auto* x = std::get_if<ArgSlot>(&a))  return x->slot == std::get<ArgSlot>(b).slot;
+    const Tensor& s = std::get<ArgLit>(a).t;
+    const Tensor& t = std::get<ArgLit>(b).t;
+    if (s.shape() != t.shape()) return false;
+    if (s.data() == t.data()) return true;
+    // Small literals (LeakyRelu slopes, scalar factors) are made per call,
+    // so compare those by value.
+    return s.numel() <= 16 && std::memcmp(s.data(), t.data(), s.numel() * sizeof(float)) == 0;
+}
+
+static bool same_step(const Step& a, const Step& b) {
+    if (a.op != b.op || a.grad_of != b.grad_of || a.out_shape != b.out_shape ||
+        a.args.size() != b.args.size())
+        return false;
+    bool eq = true;
+    for (size_t k = 0; k < a.args.size() && eq; ++k) eq = same_arg(a.args[k], b.args[k]);
+    if (eq) return true;
+    const bool commutes = a.grad_of < 0 && (a.op == Op::Add || a.op == Op::Mul);
+    return commutes && same_arg(a.args[0], b.args[1]) && same_arg(a.args[1], b.args[0]);
+}
+
+// Order-insensitive, so a commuted duplicate lands in the same bucket.
+static size_t step_hash(const Step& st) {
+    size_t h = size_t(st.op) * 131 + size_t(uint8_t(st.grad_of));
+    h = h * 131 + size_t(st.out_shape.first) * 31 + size_t(st.out_shape.second);
+    size_t args = 0;
+    for (const Arg& a : st.args) {
+        size_t v = a.index();
+        if (auto* x = std::get_if<ArgInput>(&a))     v += size_t(x->idx) << 4;
+        else if (auto* x = std::get_if<ArgParam>(&a)) v += size_t(x->idx) << 4;
+        else if (auto* x = std::get_if<ArgSlot>(&a))  v += size_t(x->slot) << 4;
+        args += v * 0x9E3779B97F4A7C15ull;
+    }
+    return h ^ args;
+}
+
+/*
+ *  eliminate_common():
+ *  --------------------
+ *  Common subexpression elimination. In step order, args are first
+ *  redirected through earlier merges; a step identical to an earlier one
+ *  (same op, same args, up to commuting Add/Mul) then becomes an alias of
+ *  that step's slot. Returns the number of merged steps.
+ */
+static int eliminate_common(Plan& plan) {
+    std::vector<int> alias(plan.num_slots);
+    for (int s = 0; s < plan.num_slots; ++s) alias[s] = s;
+    auto redirect = [&](Arg& a) {
+        if (auto* s = std::get_if<ArgSlot>(&a)) s->slot = alias[s->slot];
+    };
+    std::unordered_map<size_t, std::vector<size_t>> seen;
+    int merged = 0;
+    for (size_t i = 0; i < plan.steps.size(); ++i) {
+        Step& st = plan.steps[i];
+        for (Arg& a : st.args) redirect(a);
+        auto& bucket = seen[step_hash(st)];
+        auto hit = std::find_if(bucket.begin(), bucket.end(),
+                                [&](size_t j) { return same_step(plan.steps[j], st); });
+        if (hit == bucket.end()) { bucket.push_back(i); continue; }
+        alias[st.out_slot] = plan.steps[*hit].out_slot;
+        ++merged;
+    }
+    for (int& s : plan.out_slots) s = alias[s];
+    for (Arg& a : plan.grad_src) redirect(a);
+    return merged;
+}
+
+/*
+ *  eliminate_dead():
+ *  ------------------
+ *  Drops steps whose slot no output reaches, walking back from the plan
+ *  output and gradient slots. Returns the number of dropped steps.
+ */
+static int eliminate_dead(Plan& plan) {
+    std::vector<char> live(plan.num_slots, 0);
+    for_each_output(plan, [&](int s) { live[s] = 1; });
+    std::vector<char> keep(plan.steps.size(), 0);
+    for (size_t i = plan.steps.size(); i-- > 0;) {
+        const Step& st = plan.steps[i];
+        if (!live[st.out_slot]) continue;
+        keep[i] = 1;
+        for (const Arg& a : st.args)
+            if (auto* s = std::get_if<ArgSlot>(&a)) live[s->slot] = 1;
+    }
+    std::vector<Step> out;
+    out.reserve(plan.steps.size());
+    for (size_t i = 0; i < plan.steps.size(); ++i)
+        if (keep[i]) out.push_back(std::move(plan.steps[i]));
+    const int removed = int(plan.steps.size() - out.size());
+    plan.steps = std::move(out);
+    return removed;
+}
+
+static void optimize(Plan& plan, const CompileOptions& opts) {
+    if (opts.fold_constants || opts.pretranspose)
+        plan.folded_steps = fold_constants(plan, opts.fold_constants);
+    if (opts.eliminate_common) plan.merged_steps = eliminate_common(plan);
+    if (opts.eliminate_dead)   plan.removed_steps = eliminate_dead(plan);
+}
+
+/*
+ *  fuse_linear():
+ *  ---------------
+ *  The plan-side twin of fusion::fuse_linear(), run on the forward steps
+ *  before emit_backward(). Add(MatMul(a, b), c) becomes one FMA step, and
+ *  Relu/GELU/SiLU of an FMA becomes LinearRelu/GELU/SiLU, so the bias and
+ *  the activation are applied in the GEMM's output pass instead of two
+ *  more sweeps over [M,N]. A folded slot must have no other reader and
+ *  must not be an output. With gradients GELU and SiLU stay separate:
+ *  their VJPs read a @ b + c, which the fused step never stores. Returns
+ *  the number of steps folded away.
+ */
+static int fuse_linear(Plan& plan, bool with_grads) {
+    std::vector<int> readers(plan.num_slots, 0), producer(plan.num_slots, -1);
+    for (const Step& st : plan.steps)
+        for (const Arg& a : st.args)
+            if (auto* s = std::get_if<ArgSlot>(&a)) ++readers[s->slot];
+    for (int s : plan.out_slots) ++readers[s];
+
+    // Index of the step producing `a` if it is a `op` step read only here.
+    auto sole = [&](const Arg& a, Op op) {
+        auto* s = std::get_if<ArgSlot>(&a);
+        if (!s || readers[s->slot] != 1) return -1;
+        const int p = producer[s->slot];
+        return p >= 0 && plan.steps[p].op == op ? p : -1;
+    };
+
+    std::vector<char> drop(plan.steps.size(), 0);
+    int folded = 0;
+    for (size_t i = 0; i < plan.steps.size(); ++i) {
+        Step& st = plan.steps[i];
+        producer[st.out_slot] = int(i);
+        int p = -1;
+        if (st.op == Op::Add) {
+            for (int k = 0; k < 2 && p < 0; ++k) {
+                p = sole(st.args[k], Op::MatMul);
+                if (p < 0 || plan.steps[p].out_shape != st.out_shape) { p = -1; continue; }
+                st.args = {plan.steps[p].args[0], plan.steps[p].args[1], st.args[1 - k]};
+                st.op = Op::FMA;
+            }
+        } else if (st.op == Op::Relu || (!with_grads && (st.op == Op::GELU || st.op == Op::SiLU))) {
+            p = sole(st.args[0], Op::FMA);
+            if (p >= 0) {
+                st.args = plan.steps[p].args;
+                st.op = st.op == Op::Relu ? Op::LinearRelu : st.op == Op::GELU ? Op::LinearGELU : Op::LinearSiLU;
+            }
+        }
+        if (p >= 0) { drop[p] = 1; ++folded; }
+    }
+
+    std::vector<Step> out;
+    out.reserve(plan.steps.size() - folded);
+    for (size_t i = 0; i < plan.steps.size(); ++i)
+        if (!drop[i]) out.push_back(std::move(plan.steps[i]));
+    plan.steps = std::move(out);
+
+    // Renumber the slots so the folded ones leave no gaps.
+    std::vector<int> remap(plan.num_slots, -1);
+    plan.slot_shape.clear();
+    for (Step& st : plan.steps) {
+        for (Arg& a : st.args)
+            if (auto* s = std::get_if<ArgSlot>(&a)) s->slot = remap[s->slot];
+        remap[st.out_slot] = int(plan.slot_shape.size());
+        st.out_slot = remap[st.out_slot];
+        plan.slot_shape.push_back(st.out_shape);
+    }
+    for (int& s : plan.out_slots) s = remap[s];
+    plan.num_slots = int(plan.slot_shape.size());
+    return folded;
+}
+
+/*
+ *  emit_backward():
+ *  -----------------
+ *  Appends the reverse-mode sweep to a forward plan, seeded with ones at
+ *  every output (so the gradients are of the sum of all outputs' sums,
+ *  e.g. a loss plus auxiliary losses), and records in plan.grad_src where
+ *  each parameter's gradient ends up. Inputs and literals get none.
+ *
+ *  Forward steps are visited in reverse; a slot's contributions are
+ *  summed with plain Add steps once all its readers are done. Per op:
+ *      MatMul     gA = g @ B^T, gB = A^T @ g  (Transpose + MatMul steps)
+ *      FMA        as MatMul for a and b; c gets g, reduced if broadcast
+ *      LinearRelu as FMA, from a Relu VJP step of g
+ *      Transpose  Transpose(g)
+ *      Add        g itself when no broadcast has to be undone
+ *      otherwise  one grad_of step reading what the op's ops.def row saves
+ *  The forward values those steps read simply stay live longer, so
+ *  plan_buffers() keeps them in the arena and fusion leaves them
+ *  materialised.
+ */
+static void emit_backward(Plan& plan) {
+    const size_t n_fwd = plan.steps.size();
+    std::vector<char> needs(plan.num_slots, 0);   // depends on some param
+    auto wants = [&](const Arg& a) {
+        if (std::holds_alternative<ArgParam>(a)) return true;
+        auto* s = std::get_if<ArgSlot>(&a);
+        return s && needs[s->slot];
+    };
+    for (const Step& st : plan.steps)
+        needs[st.out_slot] = std::any_of(st.args.begin(), st.args.end(), wants);
+
+    auto emit = [&](Op op, int grad_of, std::vector<Arg> args, Shape shape) -> Arg {
+        Step st;
+        st.op = op;
+        st.grad_of = int8_t(grad_of);
+        st.args = std::move(args);
+        st.out_shape = shape;
+        st.out_slot = plan.num_slots++;
+        plan.slot_shape.push_back(shape);
+        plan.steps.push_back(std::move(st));
+        return ArgSlot{plan.steps.back().out_slot};
+    };
+    auto total = [&](const std::vector<Arg>& parts, Shape shape) {
+        Arg acc = parts[0];
+        for (size_t k = 1; k < parts.size(); ++k) acc = emit(Op::Add, -1, {acc, parts[k]}, shape);
+        return acc;
+    };
+
+    std::vector<std::vector<Arg>> g_slot(plan.num_slots), g_param(plan.sig.param_shapes.size());
+    for (int s : plan.out_slots)
+        g_slot[s].push_back(ArgLit{Tensor::ones(plan.slot_shape[s].first, plan.slot_shape[s].second)});
+
+    for (size_t si = n_fwd; si-- > 0;) {
+        // emit() grows plan.steps, so copy what is needed out of the step.
+        const Op op = plan.steps[si].op;
+        const std::vector<Arg> fargs = plan.steps[si].args;
+        const int fout = plan.steps[si].out_slot;
+        const Shape fshape = plan.steps[si].out_shape;
+        if (!needs[fout] || g_slot[fout].empty()) continue;
+        const Arg g = total(g_slot[fout], fshape);
+        // FMA/LinearRelu: gz is the gradient at a @ b + c (relu's mask
+        // comes from the fused output). compile() splits the other Linear ops.
+        const bool gemm = op == Op::FMA || op == Op::LinearRelu;
+        const Arg gz = op == Op::LinearRelu ? emit(Op::Relu, 0, {g, ArgSlot{fout}}, fshape) : g;
+
+        for (size_t k = 0; k < fargs.size(); ++k) {
+            if (!wants(fargs[k])) continue;
+            const Shape xs = arg_shape(plan, fargs[k]);
+            Arg d;
+            if (op == Op::MatMul || (gemm && k < 2)) {
+                const Arg& other = fargs[1 - k];
+                const Shape os = arg_shape(plan, other);
+                const Arg ot = emit(Op::Transpose, -1, {other}, {os.second, os.first});
+                d = k == 0 ? emit(Op::MatMul, -1, {gz, ot}, xs) : emit(Op::MatMul, -1, {ot, gz}, xs);
+            } else if (gemm) {
+                d = xs == fshape ? gz : emit(Op::Add, 1, {gz}, xs);
+            } else if (op == Op::Transpose) {
+                d = emit(Op::Transpose, -1, {g}, xs);
+            } else if (op == Op::Add && xs == fshape) {
+                d = g;
+            } else {
+                std::vector<Arg> args{g};
+                if (bwd_needs_input(op)) args.insert(args.end(), fargs.begin(), fargs.end());
+                if (bwd_needs_output(op)) args.push_back(ArgSlot{fout});
+                d = emit(op, int(k), std::move(args), xs);
+            }
+            if (auto* pa = std::get_if<ArgParam>(&fargs[k])) g_param[pa->idx].push_back(d);
+            else g_slot[std::get<ArgSlot>(fargs[k]).slot].push_back(d);
+        }
+    }
+
+    plan.grad_src.clear();
+    for (size_t p = 0; p < g_param.size(); ++p) {
+        const Shape ps = plan.sig.param_shapes[p];
+        plan.grad_src.push_back(g_param[p].empty() ? Arg{ArgLit{Tensor::zeros(ps.first, ps.second)}}
+                                                   : total(g_param[p], ps));
+    }
+}
+
+/*
+ *  fuse_elementwise():
+ *  --------------------
+ *  Greedy chain fusion over the step list (already in topo order).
+ *
+ *  A step joins the open group whose last member produced one of its
+ *  args when:
+ *      - that slot has no other reader and is not the plan output,
+ *      - the step is a fusible elementwise op with the group's shape, or
+ *        a supported reduction that reads the chain as arg 0 (which then
+ *        closes the group).
+ *  Any other fusible elementwise step opens a new group. Moving earlier
+ *  members down to the tail's position is always legal: every external
+ *  arg of a member is produced before that member, hence before the tail.
+ *  Groups of one are left as plain steps. Backward (grad_of) steps never
+ *  fuse; the MatMul/Transpose/Add steps emit_backward() lowers to do.
+ */
+static void fuse_elementwise(Plan& plan) {
+    std::vector<int> uses(plan.num_slots, 0);
+    for (const Step& st : plan.steps)
+        for (const Arg& a : st.args)
+            if (auto* s = std::get_if<ArgSlot>(&a)) ++uses[s->slot];
+    for (const Arg& a : plan.grad_src)   // gradient outputs are read by run()
+        if (auto* s = std::get_if<ArgSlot>(&a)) ++uses[s->slot];
+    std::vector<char> is_out(plan.num_slots, 0);
+    for (int s : plan.out_slots) is_out[s] = 1;
+
+    struct Group { std::vector<Step> members; bool closed{false}; };
+    std::vector<Group> groups;
+    std::unordered_map<int,int> open_by_tail;    // tail slot -> group
+    std::vector<int> group_of_step(plan.steps.size(), -1);
+
+    for (size_t si = 0; si < plan.steps.size(); ++si) {
+        Step& st = plan.steps[si];
+        const bool elem = st.grad_of < 0 && fusible_elementwise(st.op);
+        const bool tail = st.grad_of < 0 && fusible_tail(st.op);
+        int join = -1;
+        if (elem || tail) {
+            for (size_t k = 0; k < st.args.size(); ++k) {
+                auto* s = std::get_if<ArgSlot>(&st.args[k]);
+                if (!s) continue;
+                auto it = open_by_tail.find(s->slot);
+                if (it == open_by_tail.end()) continue;
+                if (uses[s->slot] != 1 || is_out[s->slot]) continue;
+                const Shape gshape = groups[it->second].members.front().out_shape;
+                if (elem && st.out_shape != gshape) continue;
+                if (tail && k != 0) continue;
+                // CE reads its targets row-aligned with the logits.
+                if (st.op == Op::CeWithLogits && arg_shape(plan, st.args[1]) != gshape) continue;
+                join = it->second;
+                break;
+            }
+        }
+        if (join >= 0) {
+            open_by_tail.erase(groups[join].members.back().out_slot);
+            groups[join].members.push_back(std::move(st));
+            if (tail) groups[join].closed = true;
+            else open_by_tail[groups[join].members.back().out_slot] = join;
+            group_of_step[si] = join;
+        } else if (elem) {
+            groups.push_back(Group{});
+            groups.back().members.push_back(std::move(st));
+            open_by_tail[groups.back().members.back().out_slot] = int(groups.size()) - 1;
+            group_of_step[si] = int(groups.size()) - 1;
+        }
+    }
+
+    // Re-emit: each group goes where its last member was.
+    std::vector<int> last_pos(groups.size(), -1);
+    for (size_t si = 0; si < plan.steps.size(); ++si)
+        if (group_of_step[si] >= 0) last_pos[group_of_step[si]] = int(si);
+
+    std::vector<Step> out;
+    out.reserve(plan.steps.size());
+    plan.fused_groups = plan.fused_members = 0;
+    for (size_t si = 0; si < plan.steps.size(); ++si) {
+        const int g = group_of_step[si];
+        if (g < 0) { out.push_back(std::move(plan.steps[si])); continue; }
+        if (last_pos[g] != int(si)) continue;
+        auto& mem = groups[g].members;
+        if (mem.size() == 1) { out.push_back(std::move(mem[0])); continue; }
+        Step fused;
+        fused.op = mem.back().op;
+        fused.out_slot = mem.back().out_slot;
+        fused.out_shape = mem.back().out_shape;
+        fused.members = std::move(mem);
+        ++plan.fused_groups;
+        plan.fused_members += int(fused.members.size());
+        out.push_back(std::move(fused));
+    }
+    plan.steps = std::move(out);
+}
+
+/*
+ *  plan_buffers():
+ *  ----------------
+ *  Assigns every materialised slot to an arena buffer using slot lifetimes.
+ *
+ *      1. last_use[s] = index of the last step reading slot s
+ *         (the output and gradient slots live to the end).
+ *      2. Walk steps in order. An elementwise step whose first input
+ *         (same shape as the output) dies here takes over that input's
+ *         buffer; for a fused group, any input of its first member that
+ *         no later member reads. Otherwise the output gets the smallest
+ *         free buffer that fits, or the largest free one grown to fit, or
+ *         a new one.
+ *      3. After the step, buffers of slots that died at it are freed.
+ *
+ *  For parallel runs (`parallel`), a buffer is only handed to step i when
+ *  every step that wrote or read it so far is an ancestor of i. Reuse
+ *  then never adds an ordering edge the data flow did not already have,
+ *  so independent branches stay independent at the cost of a larger
+ *  arena.
+ *
+ *  Buffers are then packed back to back into one arena allocation,
+ *  followed by one block of scratch for fused reductions (per thread
+ *  when run() executes steps on several).
+ */
+static void plan_buffers(Plan& plan, bool reuse, bool parallel) {
+    const int S = plan.num_slots;
+    plan.slot_buf.assign(S, -1);
+    plan.in_place_steps = 0;
+    plan.naive_floats = 0;
+    plan.max_args = 0;
+
+    std::vector<int> last_use(S, -1);
+    size_t scratch = 0;
+    for (int i = 0; i < int(plan.steps.size()); ++i) {
+        const Step& st = plan.steps[i];
+        if (st.members.empty()) plan.naive_floats += numel(st.out_shape);
+        for (const Step& m : st.members) plan.naive_floats += numel(m.out_shape);
+        if (!st.members.empty() && op_kind(st.op) != OpKind::Elementwise)
+            scratch = std::max(scratch, size_t(block_rows(st.members.front().out_shape) *
+                                               st.members.front().out_shape.second));
+        plan.max_args = std::max(plan.max_args, flat_arg_count(st));
+        for_each_arg(st, [&](const Arg& a) {
+            if (auto* s = std::get_if<ArgSlot>(&a)) last_use[s->slot] = i;
+        });
+    }
+    for (int s : plan.out_slots) last_use[s] = std::numeric_limits<int>::max();
+    for (const Arg& a : plan.grad_src)
+        if (auto* s = std::get_if<ArgSlot>(&a)) last_use[s->slot] = std::numeric_limits<int>::max();
+
+    std::vector<size_t> cap;     // per-buffer capacity in floats
+    std::vector<int> free_bufs;
+
+    // Parallel runs: ancestor sets over the data flow, and who has touched
+    // each buffer.
+    const size_t n = plan.steps.size(), words = (n + 63) / 64;
+    std::vector<std::vector<uint64_t>> anc;
+    std::vector<std::vector<int>> users;
+    if (parallel) {
+        std::vector<int> producer(S, -1);
+        anc.assign(n, std::vector<uint64_t>(words, 0));
+        for (size_t i = 0; i < n; ++i) {
+            for_each_arg(plan.steps[i], [&](const Arg& a) {
+                auto* s = std::get_if<ArgSlot>(&a);
+                if (!s || producer[s->slot] < 0) return;
+                const int j = producer[s->slot];
+                anc[i][j / 64] |= uint64_t(1) << (j % 64);
+                for (size_t w = 0; w < words; ++w) anc[i][w] |= anc[j][w];
+            });
+            producer[plan.steps[i].out_slot] = int(i);
+        }
+    }
+    auto usable = [&](int b, int i) {
+        if (!parallel) return true;
+        for (int u : users[b])
+            if (u != i && !(anc[i][u / 64] >> (u % 64) & 1)) return false;
+        return true;
+    };
+
+    for (int i = 0; i < int(plan.steps.size()); ++i) {
+        const Step& st = plan.steps[i];
+        const size_t need = numel(st.out_shape);
+        int buf = -1;
+        if (parallel)
+            for_each_arg(st, [&](const Arg& a) {
+                if (auto* s = std::get_if<ArgSlot>(&a)) users[plan.slot_buf[s->slot]].push_back(i);
+            });
+
+        if (reuse && op_kind(st.op) == OpKind::Elementwise) {
+            // Plain steps overwrite args[0]; fused groups any arg of member 0.
+            const bool fused = !st.members.empty();
+            const std::vector<Arg>& first = fused ? st.members[0].args : st.args;
+            for (size_t k = 0; k < first.size() && (fused || k == 0); ++k) {
+                auto* s = std::get_if<ArgSlot>(&first[k]);
+                if (!s || last_use[s->slot] != i || plan.slot_shape[s->slot] != st.out_shape) continue;
+                if (read_by_later_member(st, s->slot) || !usable(plan.slot_buf[s->slot], i)) continue;
+                buf = plan.slot_buf[s->slot];
+                ++plan.in_place_steps;
+                break;
+            }
+        }
+
+        if (buf < 0 && reuse && !free_bufs.empty()) {
+            auto best = free_bufs.end(), largest = free_bufs.end();
+            for (auto it = free_bufs.begin(); it != free_bufs.end(); ++it) {
+                if (!usable(*it, i)) continue;
+                if (cap[*it] >= need && (best == free_bufs.end() || cap[*it] < cap[*best])) best = it;
+                if (largest == free_bufs.end() || cap[*it] > cap[*largest]) largest = it;
+            }
+            auto pickit = (best != free_bufs.end()) ? best : largest;
+            if (pickit != free_bufs.end()) {
+                buf = *pickit;
+                free_bufs.erase(pickit);
+            }
+        }
+        if (buf < 0) { buf = int(cap.size()); cap.push_back(0); users.emplace_back(); }
+        cap[buf] = std::max(cap[buf], need);
+        plan.slot_buf[st.out_slot] = buf;
+        if (parallel) users[buf].push_back(i);
+
+        if (!reuse) continue;
+        for_each_arg(st, [&](const Arg& a) {
+            auto* s = std::get_if<ArgSlot>(&a);
+            if (!s || last_use[s->slot] != i) return;
+            const int b = plan.slot_buf[s->slot];
+            if (b == buf) return; // taken over in place
+            if (std::find(free_bufs.begin(), free_bufs.end(), b) == free_bufs.end()) free_bufs.push_back(b);
+        });
+    }
+
+    plan.buf_offset.assign(cap.size(), 0);
+    size_t off = 0;
+    for (size_t b = 0; b < cap.size(); ++b) {
+        plan.buf_offset[b] = off;
+        off += (cap[b] + 15) & ~size_t(15);   // keep buffers 64-byte apart
+    }
+    plan.scratch_offset = off;
+    plan.scratch_floats = (scratch + 15) & ~size_t(15);
+    plan.arena_floats = off + plan.scratch_floats;
+}
+
+// Int8 steps (Compiled::quantize) quantise their input rows into the
+// scratch block; grow it to fit the largest.
+static void fit_quant_scratch(Plan& plan) {
+    size_t scratch = plan.scratch_floats;
+    for (const Step& st : plan.steps)
+        if (st.q)
+            scratch = std::max(scratch, (size_t(st.out_shape.first * arg_shape(plan, st.args[0]).second) + 3) / 4);
+    plan.scratch_floats = (scratch + 15) & ~size_t(15);
+    plan.arena_floats = plan.scratch_offset + plan.scratch_floats;
+}
+
+static double step_flops(const Plan& plan, const Step& st) {
+    auto one = [&](const Step& m) {
+        std::vector<Shape> in;
+        for (const Arg& a : m.args) in.push_back(arg_shape(plan, a));
+        return double(op_cost(m.op, in, m.out_shape).flops);
+    };
+    if (st.members.empty()) return one(st);
+    double f = 0.0;
+    for (const Step& m : st.members) f += one(m);
+    return f;
+}
+
+/*
+ *  plan_schedule():
+ *  -----------------
+ *  Records the dependency DAG that lets run() execute independent steps
+ *  concurrently. Dependencies are tracked per arena buffer, not per slot,
+ *  because buffers are shared once lifetimes end:
+ *      - a read waits for the buffer's last writer,
+ *      - a write waits for the last writer and every reader since,
+ *  (every thread has its own fused-reduction scratch block).
+ *  Each step also gets its rank (flops on the longest path to the end,
+ *  the list-scheduling priority) and whether it must run alone: plugin
+ *  kernels are OpenMP-parallel already, and running one next to other
+ *  steps would oversubscribe the cores.
+ */
+static void plan_schedule(Plan& plan) {
+    const size_t n = plan.steps.size();
+    const size_t nbuf = plan.buf_offset.size();
+    std::vector<int> last_writer(nbuf, -1);
+    std::vector<std::vector<int>> readers(nbuf);
+    std::vector<std::vector<int>> pred(n);
+
+    for (int i = 0; i < int(n); ++i) {
+        const Step& st = plan.steps[i];
+        auto after = [&](int j) { if (j >= 0 && j != i) pred[i].push_back(j); };
+        for_each_arg(st, [&](const Arg& a) {
+            auto* s = std::get_if<ArgSlot>(&a);
+            if (!s) return;
+            const int b = plan.slot_buf[s->slot];
+            after(last_writer[b]);
+            readers[b].push_back(i);
+        });
+        const int b = plan.slot_buf[st.out_slot];
+        after(last_writer[b]);
+        for (int r : readers[b]) after(r);
+        readers[b].clear();
+        last_writer[b] = i;
+    }
+
+    plan.dep_count.assign(n, 0);
+    plan.succ.assign(n, {});
+    plan.exclusive.assign(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        std::sort(pred[i].begin(), pred[i].end());
+        pred[i].erase(std::unique(pred[i].begin(), pred[i].end()), pred[i].end());
+        plan.dep_count[i] = int(pred[i].size());
+        for (int j : pred[i]) plan.succ[j].push_back(int(i));
+        const Step& st = plan.steps[i];
+        plan.exclusive[i] = uses_plugin(st) ||
+            std::any_of(st.members.begin(), st.members.end(), [](const Step& m) { return uses_plugin(m); });
+    }
+
+    plan.rank.assign(n, 0.0);
+    std::vector<int> depth(n, 1);
+    plan.critical_path = 0;
+    for (size_t i = n; i-- > 0;) {
+        double r = 0.0;
+        for (int j : plan.succ[i]) { r = std::max(r, plan.rank[j]); depth[i] = std::max(depth[i], depth[j] + 1); }
+        plan.rank[i] = r + step_flops(plan, plan.steps[i]);
+        plan.critical_path = std::max(plan.critical_path, depth[i]);
+    }
+}
+
+// Per-run scratch: the arena itself, one arg pointer/shape array per
+// thread executing steps ("lane"), and the ready-list state of a
+// parallel run. Sized once, so runs do not allocate. Behind the public
+// jit::Workspace; plans sharing one only ever grow it.
+struct Workspace::State {
+    std::vector<float>                     arena;
+    std::vector<std::vector<const float*>> argp;
+    std::vector<std::vector<Shape>>        args;
+    std::vector<int>                       pending, ready;
+    std::vector<const float*>              aot_in, aot_par;   // AOT runs
+
+    void reserve(const Plan& plan, int lanes) {
+        const size_t floats = plan.arena_floats + size_t(lanes - 1) * plan.scratch_floats;
+        if (arena.size() < floats) arena.assign(floats, 0.f);
+        if (argp.size() < size_t(lanes)) { argp.resize(lanes); args.resize(lanes); }
+        for (int l = 0; l < lanes; ++l)
+            if (argp[l].size() < plan.max_args) { argp[l].resize(plan.max_args); args[l].resize(plan.max_args); }
+        pending.reserve(plan.steps.size());
+        ready.reserve(plan.steps.size());
+        aot_in.resize(plan.sig.in_shapes.size());
+        aot_par.resize(plan.sig.param_shapes.size());
+    }
+};
+using RunState = Workspace::State;
+
+Workspace::Workspace() : s_(std::make_unique<State>()) {}
+Workspace::~Workspace() = default;
+Workspace::Workspace(Workspace&&) noexcept = default;
+Workspace& Workspace::operator=(Workspace&&) noexcept = default;
+
+// Entry point of an ahead-of-time model (see emit_cpp()): inputs, params,
+// literals, arena, per-step plugin kernels, and the fallback that runs
+// step k through the interpreter.
+using AotRun = void (*)(const float* const* in, const float* const* par, const float* const* lit,
+                        float* arena, const void* const* fns, void (*step)(void*, int), void* ctx);
+
+// A forward GEMM step whose weight (operand 1) is fixed at quantize()
+// time, i.e. a param or a literal.
+static bool quantisable(const Step& st) {
+    switch (st.op) {
+        case Op::MatMul: case Op::FMA: case Op::LinearRelu: case Op::LinearGELU: case Op::LinearSiLU: break;
+        default: return false;
+    }
+    return st.members.empty() && st.grad_of < 0 && !st.q &&
+           (std::holds_alternative<ArgParam>(st.args[1]) || std::holds_alternative<ArgLit>(st.args[1]));
+}
+
+struct Compiled::Impl {
+    Plan plan;
+
+    // Compiled::calibrate(): while on, runs go step by step on the caller
+    // and record, per quantisable step, the largest |operand 0| seen.
+    std::atomic<bool>          calibrating{false};
+    mutable std::mutex         calib_mu;
+    mutable std::vector<float> amax;
+
+    // One cached workspace; a concurrent caller that finds it busy falls
+    // back to its thread's own instead of blocking. Callers passing a
+    // jit::Workspace skip both.
+    mutable RunState ws;
+    mutable std::atomic<bool> ws_busy{false};
+
+    // Inter-op parallel runs (CompileOptions::inter_op_threads). Workers
+    // park on `cv` and join a run when `generation` moves; the caller
+    // holding the cached workspace drives the run as lane 0. A run pulls
+    // the ready step of highest rank; an exclusive step waits until
+    // nothing else is in flight and blocks new steps while it runs.
+    struct Job {
+        RunState* w{nullptr};
+        const std::vector<Tensor*>* inputs{nullptr};
+        const std::vector<Tensor*>* params{nullptr};
+        size_t done{0};
+        int    in_flight{0};
+        bool   exclusive_running{false};
+        std::exception_ptr error{};
+    };
+    std::vector<std::thread>        workers;
+    mutable std::mutex              mu;
+    mutable std::condition_variable cv;
+    mutable Job                     job;
+    mutable uint64_t                generation{0};
+    bool                            stop{false};
+
+    // Set by Compiled::load_aot(): generated code that replaces execute().
+    AotRun                   aot{nullptr};
+    std::vector<const float*> aot_lits;
+    std::vector<const void*>  aot_fns;
+
+    ~Impl() {
+        { std::lock_guard<std::mutex> lk(mu); stop = true; }
+        cv.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    int lanes() const { return 1 + int(workers.size()); }
+
+    float* slot_ptr(RunState& w, int slot) const {
+        return w.arena.data() + plan.buf_offset[plan.slot_buf[slot]];
+    }
+
+    void resolve(RunState& w, int lane, size_t k, const Arg& a,
+                 const std::vector<Tensor*>& inputs,
+                 const std::vector<Tensor*>& params) const {
+        const float*& p = w.argp[lane][k];
+        Shape& s = w.args[lane][k];
+        if (auto* in = std::get_if<ArgInput>(&a)) {
+            p = inputs[in->idx]->data(); s = inputs[in->idx]->shape();
+        } else if (auto* pa = std::get_if<ArgParam>(&a)) {
+            p = params[pa->idx]->data(); s = params[pa->idx]->shape();
+        } else if (auto* sl = std::get_if<ArgSlot>(&a)) {
+            p = slot_ptr(w, sl->slot); s = plan.slot_shape[sl->slot];
+        } else {
+            const Tensor& lit = std::get<ArgLit>(a).t;
+            p = lit.data(); s = lit.shape();
+        }
+    }
+
+    void run_step(const Step& st, RunState& w, int lane,
+                  const std::vector<Tensor*>& inputs,
+                  const std::vector<Tensor*>& params) const {
+        if (st.members.empty()) {
+            for (size_t k = 0; k < st.args.size(); ++k) resolve(w, lane, k, st.args[k], inputs, params);
+        } else {
+            size_t k = 0;
+            for (size_t m = 0; m < st.members.size(); ++m)
+                for (const Arg& a : st.members[m].args) {
+                    if (is_chain(st, m, a)) {
+                        w.argp[lane][k] = nullptr;
+                        w.args[lane][k] = plan.slot_shape[std::get<ArgSlot>(a).slot];
+                    } else {
+                        resolve(w, lane, k, a, inputs, params);
+                    }
+                    ++k;
+                }
+        }
+        st.kernel(st, w.argp[lane].data(), w.args[lane].data(), slot_ptr(w, st.out_slot),
+                  w.arena.data() + plan.scratch_offset + size_t(lane) * plan.scratch_floats);
+    }
+
+    struct AotCall {
+        const Impl* impl;
+        RunState* w;
+        const std::vector<Tensor*>* inputs;
+        const std::vector<Tensor*>* params;
+    };
+    static void aot_step(void* ctx, int k) {
+        auto* c = static_cast<AotCall*>(ctx);
+        c->impl->run_step(c->impl->plan.steps[k], *c->w, 0, *c->inputs, *c->params);
+    }
+
+    void execute(RunState& w,
+                 const std::vector<Tensor*>& inputs,
+                 const std::vector<Tensor*>& params) const {
+        if (aot) {
+            for (size_t i = 0; i < inputs.size(); ++i) w.aot_in[i] = inputs[i]->data();
+            for (size_t i = 0; i < params.size(); ++i) w.aot_par[i] = params[i]->data();
+            AotCall call{this, &w, &inputs, &params};
+            aot(w.aot_in.data(), w.aot_par.data(), aot_lits.data(), w.arena.data(), aot_fns.data(),
+                &aot_step, &call);
+            return;
+        }
+        for (const Step& st : plan.steps) run_step(st, w, 0, inputs, params);
+    }
+
+    void execute_calibrating(RunState& w,
+                             const std::vector<Tensor*>& inputs,
+                             const std::vector<Tensor*>& params) const {
+        std::lock_guard<std::mutex> lk(calib_mu);
+        for (size_t k = 0; k < plan.steps.size(); ++k) {
+            const Step& st = plan.steps[k];
+            run_step(st, w, 0, inputs, params);
+            if (!quantisable(st)) continue;
+            const float* x = w.argp[0][0];   // still operand 0 of this step
+            float m = amax[k];
+            for (size_t i = 0, n = numel(w.args[0][0]); i < n; ++i) m = std::max(m, std::abs(x[i]));
+            amax[k] = m;
+        }
+    }
+
+    // Index into w.ready of the step to start now, or -1 to wait.
+    int pick_ready(const RunState& w) const {
+        if (job.exclusive_running || w.ready.empty()) return -1;
+        int best = 0;
+        for (int k = 1; k < int(w.ready.size()); ++k)
+            if (plan.rank[w.ready[k]] > plan.rank[w.ready[best]]) best = k;
+        if (plan.exclusive[w.ready[best]] && job.in_flight > 0) return -1;
+        return best;
+    }
+
+    // Executes ready steps on `lane` until the run is over. Called with
+    // `lk` held; returns with it held.
+    void drive(int lane, std::unique_lock<std::mutex>& lk) const {
+        const size_t n = plan.steps.size();
+        while (job.w && job.done < n && !job.error) {
+            RunState& w = *job.w;
+            const int k = pick_ready(w);
+            if (k < 0) { cv.wait(lk); continue; }
+            const int i = w.ready[k];
+            w.ready[k] = w.ready.back();
+            w.ready.pop_back();
+            ++job.in_flight;
+            job.exclusive_running = plan.exclusive[i];
+
+            lk.unlock();
+            std::exception_ptr err;
+            try { run_step(plan.steps[i], w, lane, *job.inputs, *job.params); }
+            catch (...) { err = std::current_exception(); }
+            lk.lock();
+
+            --job.in_flight;
+            job.exclusive_running = false;
+            ++job.done;
+            if (err && !job.error) job.error = err;
+            for (int j : plan.succ[i])
+                if (--w.pending[j] == 0) w.ready.push_back(j);
+            cv.notify_all();
+        }
+    }
+
+    void worker(int lane) const {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lk(mu);
+        for (;;) {
+            cv.wait(lk, [&] { return stop || generation != seen; });
+            if (stop) return;
+            seen = generation;
+            drive(lane, lk);
+        }
+    }
+
+    void execute_parallel(RunState& w,
+                          const std::vector<Tensor*>& inputs,
+                          const std::vector<Tensor*>& params) const {
+        std::unique_lock<std::mutex> lk(mu);
+        w.pending.assign(plan.dep_count.begin(), plan.dep_count.end());
+        w.ready.clear();
+        for (int i = 0; i < int(plan.steps.size()); ++i)
+            if (plan.dep_count[i] == 0) w.ready.push_back(i);
+        job = Job{&w, &inputs, &params};
+        ++generation;
+        cv.notify_all();
+        drive(0, lk);
+        cv.wait(lk, [&] { return job.in_flight == 0; });
+        job.w = nullptr;
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+    static void copy_out(const float* src, Shape s, Tensor& dst) {
+        if (dst.shape() != s || !dst.is_cpu() || dst.data() == nullptr) dst = Tensor(s.first, s.second);
+        std::memcpy(dst.data(), src, numel(s) * sizeof(float));
+    }
+
+    // Copies the first n_outs outputs into outs[0..n_outs).
+    bool run(RunState* caller,
+             const std::vector<Tensor*>& inputs,
+             const std::vector<Tensor*>& params,
+             Tensor* const* outs, size_t n_outs,
+             const std::vector<Tensor*>* grads) const {
+        if (grads && grads->size() != plan.grad_src.size())
+            throw std::runtime_error(plan.grad_src.empty() && !params.empty()
+                ? "Compiled::run: plan was compiled without with_grads"
+                : "Compiled::run: need one gradient tensor per param");
+        if (!plan.sig.matches(inputs, params)) return false;
+
+        // Shared by every plan run on this thread without a workspace.
+        thread_local RunState tls;
+        const bool own = !caller && !ws_busy.exchange(true, std::memory_order_acquire);
+        RunState& w = caller ? *caller : own ? ws : tls;
+        try {
+            w.reserve(plan, own ? lanes() : 1);
+            if (calibrating.load(std::memory_order_relaxed)) execute_calibrating(w, inputs, params);
+            else if (own && !workers.empty()) execute_parallel(w, inputs, params);
+            else execute(w, inputs, params);
+        } catch (...) {
+            if (own) ws_busy.store(false, std::memory_order_release);
+            throw;
+        }
+
+        for (size_t i = 0; i < n_outs; ++i)
+            copy_out(slot_ptr(w, plan.out_slots[i]), plan.slot_shape[plan.out_slots[i]], *outs[i]);
+        if (grads)
+            for (size_t i = 0; i < grads->size(); ++i) {
+                resolve(w, 0, 0, plan.grad_src[i], inputs, params);
+                copy_out(w.argp[0][0], w.args[0][0], *(*grads)[i]);
+            }
+
+        if (own) ws_busy.store(false, std::memory_order_release);
+        return true;
+    }
+};
+
+static bool is_in(const std::unordered_map<Node*,int>& m, Node* n){ return m.find(n)!=m.end(); }
+
+// ---- Shared literal storage --------------------------------------------
+//
+// One entry per distinct literal value (shape and bytes) held by any live
+// plan. Plans pin entries through ArgLit::shared; the store itself keeps
+// only weak references, so a value is released with the last plan using
+// it. Literals are read-only once compiled: run() never writes them.
+
+struct SharedWeight {
+    Tensor t;
+    uint64_t hash;
+};
+
+class WeightStore {
+public:
+    static WeightStore& global() {
+        static WeightStore store;
+        return store;
+    }
+
+    // The entry holding t's value, made from t (sharing its storage, no
+    // copy) when there is none yet.
+    std::shared_ptr<const SharedWeight> intern(const Tensor& t) {
+        const uint64_t h = hash(t);
+        std::lock_guard<std::mutex> lk(mu_);
+        auto [lo, hi] = by_hash_.equal_range(h);
+        for (auto it = lo; it != hi;) {
+            auto e = it->second.lock();
+            if (!e) { it = by_hash_.erase(it); continue; }
+            if (e->t.shape() == t.shape() &&
+                (e->t.data() == t.data() ||
+                 std::memcmp(e->t.data(), t.data(), t.numel() * sizeof(float)) == 0))
+                return e;
+            ++it;
+        }
+        auto e = std::make_shared<const SharedWeight>(SharedWeight{t, h});
+        by_hash_.emplace(h, e);
+        return e;
+    }
+
+    WeightStats stats() {
+        std::lock_guard<std::mutex> lk(mu_);
+        WeightStats s;
+        for (auto it = by_hash_.begin(); it != by_hash_.end();) {
+            auto e = it->second.lock();
+            if (!e) { it = by_hash_.erase(it); continue; }
+            const long refs = e.use_count() - 1;   // not counting `e`
+            const std::size_t bytes = e->t.numel() * sizeof(float);
+            s.weights += 1;
+            s.resident_bytes += bytes;
+            s.references += std::size_t(refs);
+            s.referenced_bytes += std::size_t(refs) * bytes;
+            ++it;
+        }
+        return s;
+    }
+
+private:
+    static uint64_t hash(const Tensor& t) {
+        uint64_t h = 1469598103934665603ull ^ uint64_t(t.rows()) * 0x9e3779b97f4a7c15ull ^ uint64_t(t.cols());
+        const float* d = t.data();
+        for (size_t i = 0; i < t.numel(); ++i) {
+            uint32_t w;
+            std::memcpy(&w, d + i, sizeof w);
+            h = (h ^ w) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    std::mutex mu_;
+    std::unordered_multimap<uint64_t, std::weak_ptr<const SharedWeight>> by_hash_;
+};
+
+WeightStats weight_stats() { return WeightStore::global().stats(); }
+
+static void share_literals(Plan& plan) {
+    auto share = [](Arg& a) {
+        auto* lit = std::get_if<ArgLit>(&a);
+        if (!lit || lit->shared || !lit->t.is_cpu() || lit->t.numel() == 0) return;
+        lit->shared = WeightStore::global().intern(lit->t);
+        lit->t = lit->shared->t;
+    };
+    for (Step& st : plan.steps) {
+        for (Arg& a : st.args) share(a);
+        for (Step& m : st.members)
+            for (Arg& a : m.args) share(a);
+    }
+    for (Arg& a : plan.grad_src) share(a);
+}
+
+// Last stage of compile() and load(): bind kernels against the plugin
+// loaded now, build the schedule, start workers, size the workspace.
+static Compiled finish(Plan&& plan) {
+    share_literals(plan);
+    bind_kernels(plan);
+    plan_schedule(plan);
+
+    Compiled c;
+    c.p = std::make_shared<Compiled::Impl>();
+    c.p->plan = std::move(plan);
+    // Workers only pay off when some steps can overlap.
+    const Plan& pl = c.p->plan;
+    if (pl.threads > 1 && pl.critical_path < int(pl.steps.size()))
+        for (int l = 1; l < pl.threads; ++l)
+            c.p->workers.emplace_back([impl = c.p.get(), l] { impl->worker(l); });
+    c.p->ws.reserve(pl, c.p->lanes());
+    return c;
+}
+
+Compiled compile(const std::vector<Value>& outputs,
+                 const std::vector<Value>& inputs,
+                 const std::vector<Value>& params,
+                 const CompileOptions& opts) {
+    if (outputs.empty()) throw std::runtime_error("jit::compile: no outputs");
+    // Map externals
+    std::unordered_map<Node*,int> in_ix, par_ix;
+    in_ix.reserve(inputs.size()); par_ix.reserve(params.size());
+    for (size_t i=0;i<inputs.size(); ++i) in_ix[ inputs[i].node.get() ] = int(i);
+    for (size_t i=0;i<params.size(); ++i) par_ix[ params[i].node.get() ] = int(i);
+
+    // Build plan
+    Plan plan;
+    plan.sig.in_shapes.reserve(inputs.size());
+    for (auto& v: inputs)  plan.sig.in_shapes.push_back(v.val().shape());
+    plan.sig.param_shapes.reserve(params.size());
+    for (auto& v: params)  plan.sig.param_shapes.push_back(v.val().shape());
+
+    // One order over every output's graph, so shared nodes get one step.
+    std::vector<Node*> order;
+    {
+        std::unordered_set<Node*> seen;
+        for (const Value& out : outputs) {
+            if (out.node->op == Op::Leaf)
+                throw std::runtime_error("jit::compile: an output is a leaf, not a computed value");
+            for (Node* n : topo_from(out.node.get()))
+                if (seen.insert(n).second) order.push_back(n);
+        }
+    }
+    std::unordered_map<Node*,int> slot_of;
+    slot_of.reserve(order.size());
+
+    for (Node* n : order) {
+        if (n->op == Op::Leaf) {
+            // Leaves are sources; nothing to emit. They get materialized as ArgInput/ArgParam or ArgLit where used.
+            continue;
+        }
+        if (!supported(n->op))
+            throw std::runtime_error(std::string("jit::compile: op not supported by replay: ") + op_name(n->op));
+        if (n->value.shape() == Shape{0, 0})
+            throw std::runtime_error("jit::compile: graph values were released by backward(); "
+                                     "pass retain_graph = true to compile a graph after it");
+        Step st;
+        st.op = n->op;
+        st.out_shape = n->value.shape();
+        st.out_slot = plan.num_slots++;
+        slot_of[n] = st.out_slot;
+        plan.slot_shape.push_back(st.out_shape);
+
+        // Gather args
+        st.args.reserve(n->inputs.size());
+        for (auto& pin : n->inputs) {
+            Node* p = pin.get();
+            if (p->op == Op::Leaf) {
+                if (is_in(in_ix, p))        st.args.push_back(ArgInput{ in_ix[p] });
+                else if (is_in(par_ix, p))  st.args.push_back(ArgParam{ par_ix[p] });
+                else                        st.args.push_back(ArgLit{ p->value }); // embedded literal leaf
+            } else {
+                // computed parent
+                st.args.push_back(ArgSlot{ slot_of.at(p) });
+            }
+        }
+
+        // The VJPs of LinearGELU/SiLU need a @ b + c, so with gradients
+        // they replay as an FMA step plus the activation.
+        if (opts.with_grads && (st.op == Op::LinearGELU || st.op == Op::LinearSiLU)) {
+            Step act;
+            act.op = st.op == Op::LinearGELU ? Op::GELU : Op::SiLU;
+            act.args = {ArgSlot{st.out_slot}};
+            act.out_shape = st.out_shape;
+            act.out_slot = plan.num_slots++;
+            slot_of[n] = act.out_slot;
+            plan.slot_shape.push_back(act.out_shape);
+            st.op = Op::FMA;
+            plan.steps.push_back(std::move(st));
+            plan.steps.push_back(std::move(act));
+            continue;
+        }
+        plan.steps.push_back(std::move(st));
+    }
+
+    for (const Value& out : outputs) plan.out_slots.push_back(slot_of.at(out.node.get()));
+    if (opts.fuse_linear) plan.linear_fused = fuse_linear(plan, opts.with_grads);
+    if (opts.with_grads) emit_backward(plan);
+    optimize(plan, opts);
+    if (opts.fuse_elementwise) fuse_elementwise(plan);
+    plan.threads = std::max(1, opts.inter_op_threads);
+    plan.reuse_buffers = opts.reuse_buffers;
+    plan_buffers(plan, plan.reuse_buffers, plan.threads > 1);
+    return finish(std::move(plan));
+}
+
+Compiled compile(const Value& output,
+                 const std::vector<Value>& inputs,
+                 const std::vector<Value>& params,
+                 const CompileOptions& opts) {
+    return compile(std::vector<Value>{output}, inputs, params, opts);
+}
+
+Compiled compile(const trace::Tracer& capture,
+                 const std::vector<Value>& inputs,
+                 const std::vector<Value>& params,
+                 const CompileOptions& opts) {
+    // Marked outputs are what the caller asked for, even when one feeds
+    // another (features and a loss computed from them).
+    std::vector<Value> outputs;
+    auto cand = capture.outputs();
+    if (capture.has_marked_outputs()) {
+        for (const auto& n : cand) outputs.emplace_back(n);
+        return compile(outputs, inputs, params, opts);
+    }
+    // Detected outputs can include leaves made during capture but never
+    // used, and values whose consumer was not captured (not every op
+    // reports its node to the tracer); neither is a result, so keep only
+    // computed values no other candidate depends on.
+    std::unordered_set<Node*> below;
+    for (const auto& n : cand)
+        for (Node* m : topo_from(n.get()))
+            if (m != n.get()) below.insert(m);
+    for (const auto& n : cand)
+        if (n->op != Op::Leaf && !below.count(n.get())) outputs.emplace_back(n);
+    return compile(outputs, inputs, params, opts);
+}
+
+bool Compiled::run(const std::vector<Tensor*>& inputs,
+                   const std::vector<Tensor*>& params,
+                   Tensor& out) const {
+    Tensor* o = &out;
+    return p->run(nullptr, inputs, params, &o, 1, nullptr);
+}
+
+bool Compiled::run(const std::vector<Tensor*>& inputs,
+                   const std::vector<Tensor*>& params,
+                   Tensor& out,
+                   const std::vector<Tensor*>& grads) const {
+    Tensor* o = &out;
+    return p->run(nullptr, inputs, params, &o, 1, &grads);
+}
+
+bool Compiled::run(Workspace& ws,
+                   const std::vector<Tensor*>& inputs,
+                   const std::vector<Tensor*>& params,
+                   Tensor& out) const {
+    Tensor* o = &out;
+    return p->run(ws.s_.get(), inputs, params, &o, 1, nullptr);
+}
+
+bool Compiled::run(Workspace& ws,
+                   const std::vector<Tensor*>& inputs,
+                   const std::vector<Tensor*>& params,
+                   Tensor& out,
+                   const std::vector<Tensor*>& grads) const {
+    Tensor* o = &out;
+    return p->run(ws.s_.get(), inputs, params, &o, 1, &grads);
+}
+
+static void check_outs(const std::vector<Tensor*>& outs, size_t n) {
+    if (outs.size() != n)
+        throw std::runtime_error("Compiled::run: plan has " + std::to_string(n) + " outputs, got " +
+                                 std::to_string(outs.size()) + " tensors");
+}
+
+bool Compiled::run(const std::vector<Tensor*>& inputs,
+                   const std::vector<Tensor*>& params,
+                   const std::vector<Tensor*>& outs,
+                   const std::vector<Tensor*>& grads) const {
+    check_outs(outs, p->plan.out_slots.size());
+    return p->run(nullptr, inputs, params, outs.data(), outs.size(), grads.empty() ? nullptr : &grads);
+}
+
+bool Compiled::run(Workspace& ws,
+                   const std::vector<Tensor*>& inputs,
+                   const std::vector<Tensor*>& params,
+                   const std::vector<Tensor*>& outs,
+                   const std::vector<Tensor*>& grads) const {
+    check_outs(outs, p->plan.out_slots.size());
+    return p->run(ws.s_.get(), inputs, params, outs.data(), outs.size(), grads.empty() ? nullptr : &grads);
+}
+
+// ---------------------------------------------------------------------
+// Plan files. Everything compile() decided is stored: signature, steps
+// (fused groups with their members), embedded literals, gradient outputs
+// and the buffer plan. Kernel pointers and the schedule are not; load()
+// rebinds them through finish(), as compile() does.
+//
+// Layout: "AGJIT\0\0\0", u32 version, then fields in declaration order as
+// raw little-endian values; vectors are a u64 count followed by elements.
+// Bump kPlanVersion whenever that order or the Op enum changes.
+// ---------------------------------------------------------------------
+static constexpr char     kPlanMagic[8] = {'A', 'G', 'J', 'I', 'T', 0, 0, 0};
+static constexpr uint32_t kPlanVersion  = 5;   // 2: several outputs, 3: fused GEMM ops, 4: int8 steps,
+                                                // 5: layout recomputed on load
+// A loaded plan starts threads - 1 workers; a corrupt count must not
+// start an unbounded number.
+static constexpr int      kMaxLoadThreads = 64;
+
+namespace {
+
+struct PlanWriter {
+    std::ofstream& out;
+
+    template <class T> void pod(const T& v) { out.write(reinterpret_cast<const char*>(&v), sizeof(T)); }
+    void shape(const Shape& sh) { pod(sh.first); pod(sh.second); }
+
+    void arg(const Arg& a) {
+        pod(uint8_t(a.index()));
+        if (auto* x = std::get_if<ArgInput>(&a))      pod(int32_t(x->idx));
+        else if (auto* x = std::get_if<ArgParam>(&a)) pod(int32_t(x->idx));
+        else if (auto* x = std::get_if<ArgSlot>(&a))  pod(int32_t(x->slot));
+        else {
+            const Tensor& t = std::get<ArgLit>(a).t;
+            if (!t.is_cpu()) throw std::runtime_error("Compiled::save: literal is not on the CPU");
+            shape(t.shape());
+            out.write(reinterpret_cast<const char*>(t.data()), std::streamsize(t.numel() * sizeof(float)));
+        }
+    }
+
+    void step(const Step& st) {
+        pod(uint8_t(st.op));
+        pod(st.grad_of);
+        pod(int32_t(st.out_slot));
+        shape(st.out_shape);
+        pod(uint64_t(st.args.size()));
+        for (const Arg& a : st.args) arg(a);
+        pod(uint64_t(st.members.size()));
+        for (const Step& m : st.members) step(m);
+        pod(uint8_t(st.q ? 1 : 0));
+        if (st.q) {
+            pod(st.q->a_scale);
+            pod(uint8_t(st.q->in_int8));
+            pod(st.q->out_scale);
+            vec(st.q->w);
+            vec(st.q->col_scale);
+        }
+    }
+
+    template <class T> void vec(const std::vector<T>& v) {
+        pod(uint64_t(v.size()));
+        for (const T& x : v) pod(x);
+    }
+};
+
+struct PlanReader {
+    std::ifstream& in;
+
+    template <class T> T pod() {
+        T v{};
+        if (!in.read(reinterpret_cast<char*>(&v), sizeof(T)))
+            throw std::runtime_error("Compiled::load: truncated plan file");
+        return v;
+    }
+    Shape shape() {
+        const int64_t r = pod<int64_t>(), c = pod<int64_t>();
+        if (r < 0 || c < 0 || (c > 0 && r > std::numeric_limits<int64_t>::max() / c))
+            throw std::runtime_error("Compiled::load: corrupt plan file");
+        return {r, c};
+    }
+    size_t count() {
+        const uint64_t n = pod<uint64_t>();
+        if (n > (uint64_t(1) << 32)) throw std::runtime_error("Compiled::load: corrupt plan file");
+        return size_t(n);
+    }
+
+    Arg arg() {
+        switch (pod<uint8_t>()) {
+            case 0: return ArgInput{pod<int32_t>()};
+            case 1: return ArgParam{pod<int32_t>()};
+            case 2: return ArgSlot{pod<int32_t>()};
+            case 3: {
+                const Shape sh = shape();
+                Tensor t(sh.first, sh.second);
+                if (!in.read(reinterpret_cast<char*>(t.data()), std::streamsize(t.numel() * sizeof(float))))
+                    throw std::runtime_error("Compiled::load: truncated plan file");
+                return ArgLit{t};
+            }
+            default: throw std::runtime_error("Compiled::load: corrupt plan file");
+        }
+    }
+
+    Step step() {
+        Step st;
+        const uint8_t op = pod<uint8_t>();
+        if (op >= OpCount) throw std::runtime_error("Compiled::load: corrupt plan file");
+        st.op = Op(op);
+        st.grad_of = pod<int8_t>();
+        st.out_slot = pod<int32_t>();
+        st.out_shape = shape();
+        st.args.resize(count());
+        for (Arg& a : st.args) a = arg();
+        st.members.resize(count());
+        for (Step& m : st.members) m = step();
+        if (pod<uint8_t>()) {
+            auto q = std::make_shared<QuantGemm>();
+            q->a_scale = pod<float>();
+            q->in_int8 = pod<uint8_t>() != 0;
+            q->out_scale = pod<float>();
+            q->w = vec<int8_t>();
+            q->col_scale = vec<float>();
+            st.q = q;
+        }
+        return st;
+    }
+
+    template <class T> std::vector<T> vec() {
+        std::vector<T> v(count());
+        for (T& x : v) x = pod<T>();
+        return v;
+    }
+};
+
+// Every slot/input/param index a step refers to must exist, each step's
+// shape must match its slot's, and every slot must be written before it
+// is read. The arena layout is not checked: load() recomputes it.
+void check_plan(const Plan& plan) {
+    auto bad = [] { throw std::runtime_error("Compiled::load: corrupt plan file"); };
+    auto slot_ok = [&](int s) { return s >= 0 && s < plan.num_slots; };
+    auto arg_ok = [&](const Arg& a) {
+        if (auto* x = std::get_if<ArgInput>(&a)) return x->idx >= 0 && size_t(x->idx) < plan.sig.in_shapes.size();
+        if (auto* x = std::get_if<ArgParam>(&a)) return x->idx >= 0 && size_t(x->idx) < plan.sig.param_shapes.size();
+        if (auto* x = std::get_if<ArgSlot>(&a))  return slot_ok(x->slot);
+        return true;
+    };
+    if (plan.num_slots < 0 || plan.slot_shape.size() != size_t(plan.num_slots) ||
+        plan.out_slots.empty() || plan.grad_src.size() > plan.sig.param_shapes.size())
+        bad();
+    for (int s : plan.out_slots)
+        if (!slot_ok(s)) bad();
+    for (const Step& st : plan.steps) {
+        if (!slot_ok(st.out_slot) || plan.slot_shape[st.out_slot] != st.out_shape) bad();
+        for (const Arg& a : st.args) if (!arg_ok(a)) bad();
+        if (st.q) {
+            const int64_t N = st.out_shape.second;
+            if (!quant_kernel(st.op) || st.args.size() < 2 || !arg_ok(st.args[0]) ||
+                st.q->w.size() != size_t(arg_shape(plan, st.args[0]).second * N) ||
+                (st.q->col_scale.size() != 1 && st.q->col_scale.size() != size_t(N)))
+                bad();
+        }
+        for (const Step& m : st.members) {
+            if (!slot_ok(m.out_slot) || !m.members.empty() || plan.slot_shape[m.out_slot] != m.out_shape) bad();
+            for (const Arg& a : m.args) if (!arg_ok(a)) bad();
+        }
+    }
+    for (const Arg& a : plan.grad_src) if (!arg_ok(a)) bad();
+
+    // Only step outputs get a buffer (members write chain slots), so
+    // those are the only slots a later step, output or gradient may read.
+    std::vector<char> written(size_t(plan.num_slots), 0);
+    auto read_ok = [&](const Arg& a) {
+        auto* s = std::get_if<ArgSlot>(&a);
+        return !s || written[size_t(s->slot)];
+    };
+    for (const Step& st : plan.steps) {
+        bool ok = true;
+        for_each_arg(st, [&](const Arg& a) { ok = ok && read_ok(a); });
+        if (!ok) bad();
+        written[size_t(st.out_slot)] = 1;
+    }
+    for (int s : plan.out_slots) if (!written[size_t(s)]) bad();
+    for (const Arg& a : plan.grad_src) if (!read_ok(a)) bad();
+}
+
+} // namespace
+
+void Compiled::save(const std::string& path) const {
+    if (!p) throw std::runtime_error("Compiled::save: empty plan");
+    const Plan& pl = p->plan;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Compiled::save: cannot open " + path);
+    PlanWriter w{out};
+    out.write(kPlanMagic, sizeof(kPlanMagic));
+    w.pod(kPlanVersion);
+
+    w.pod(uint64_t(pl.sig.in_shapes.size()));
+    for (const Shape& sh : pl.sig.in_shapes) w.shape(sh);
+    w.pod(uint64_t(pl.sig.param_shapes.size()));
+    for (const Shape& sh : pl.sig.param_shapes) w.shape(sh);
+
+    w.pod(int32_t(pl.num_slots));
+    std::vector<int32_t> outs(pl.out_slots.begin(), pl.out_slots.end());
+    w.vec(outs);
+    w.pod(uint64_t(pl.slot_shape.size()));
+    for (const Shape& sh : pl.slot_shape) w.shape(sh);
+    w.pod(uint64_t(pl.steps.size()));
+    for (const Step& st : pl.steps) w.step(st);
+    w.pod(uint64_t(pl.grad_src.size()));
+    for (const Arg& a : pl.grad_src) w.arg(a);
+
+    w.pod(uint8_t(pl.reuse_buffers));
+    for (int v : {pl.folded_steps, pl.merged_steps, pl.removed_steps,
+                  pl.fused_groups, pl.fused_members, pl.threads, pl.linear_fused,
+                  pl.quantized_steps, pl.int8_links})
+        w.pod(int32_t(v));
+    if (!out) throw std::runtime_error("Compiled::save: write failed for " + path);
+}
+
+Compiled Compiled::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Compiled::load: cannot open " + path);
+    PlanReader r{in};
+    char magic[sizeof(kPlanMagic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kPlanMagic, sizeof(magic)) != 0)
+        throw std::runtime_error("Compiled::load: " + path + " is not a jit plan file");
+    const uint32_t version = r.pod<uint32_t>();
+    if (version != kPlanVersion)
+        throw std::runtime_error("Compiled::load: plan file version " + std::to_string(version) +
+                                 ", expected " + std::to_string(kPlanVersion));
+
+    Plan pl;
+    pl.sig.in_shapes.resize(r.count());
+    for (Shape& sh : pl.sig.in_shapes) sh = r.shape();
+    pl.sig.param_shapes.resize(r.count());
+    for (Shape& sh : pl.sig.param_shapes) sh = r.shape();
+
+    pl.num_slots = r.pod<int32_t>();
+    for (int32_t o : r.vec<int32_t>()) pl.out_slots.push_back(o);
+    pl.slot_shape.resize(r.count());
+    for (Shape& sh : pl.slot_shape) sh = r.shape();
+    pl.steps.resize(r.count());
+    for (Step& st : pl.steps) st = r.step();
+    pl.grad_src.resize(r.count());
+    for (Arg& a : pl.grad_src) a = r.arg();
+
+    pl.reuse_buffers = r.pod<uint8_t>() != 0;
+    for (int* v : {&pl.folded_steps, &pl.merged_steps, &pl.removed_steps,
+                   &pl.fused_groups, &pl.fused_members, &pl.threads, &pl.linear_fused,
+                   &pl.quantized_steps, &pl.int8_links})
+        *v = r.pod<int32_t>();
+    pl.threads = std::clamp(pl.threads, 1, kMaxLoadThreads);
+    check_plan(pl);
+    // Buffer assignment, arena offsets, scratch and the argument-array
+    // size are derived from the steps rather than trusted from the file.
+    plan_buffers(pl, pl.reuse_buffers, pl.threads > 1);
+    fit_quant_scratch(pl);
+    return finish(std::move(pl));
+}
+
+// ---------------------------------------------------------------------
+// Ahead-of-time models. emit_cpp() prints the plan as one C++ function
+// with every shape, arena offset and broadcast kind baked in: a fused
+// group becomes a single loop nest whose chain values are locals, matmul
+// and unary steps call the plugin kernel bound at load time (else an
+// inline loop), and steps without a template here (the backward ones)
+// call back into the interpreter. The file needs only the standard
+// library, so any C++17 compiler can build it into a shared object;
+// load_aot() opens that with the plugin loader's dlopen and checks it was
+// generated from this very plan.
+// ---------------------------------------------------------------------
+static constexpr uint32_t kAotAbi = 1;
+
+static const char* const kAotPrelude = R"(#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#define AG_AOT_EXPORT extern "C" __attribute__((visibility("default")))
+
+namespace {
+
+typedef void (*unary_fn)(const float*, float*, int64_t);
+typedef void (*leakyrelu_fn)(const float*, float*, int64_t, float);
+typedef void (*matmul_fn)(const float*, const float*, float*, int64_t, int64_t, int64_t);
+
+// Same formulas as the interpreter's kernels.
+inline float f_relu(float v, float) { return v > 0.f ? v : 0.f; }
+inline float f_exp(float v, float) { return std::exp(v); }
+inline float f_log(float v, float) { return std::log(v); }
+inline float f_tanh(float v, float) { return std::tanh(v); }
+inline float f_sigmoid(float v, float) { return 1.f / (1.f + std::exp(-v)); }
+inline float f_softplus(float v, float) { return std::log1p(std::exp(v)); }
+inline float f_silu(float v, float) { return v * (1.f / (1.f + std::exp(-v))); }
+inline float f_gelu(float v, float) {
+    const float c = 0.7978845608028654f;
+    return 0.5f * v * (1.f + std::tanh(c * (v + 0.044715f * v * v * v)));
+}
+inline float f_leakyrelu(float v, float alpha) { return v > 0.f ? v : alpha * v; }
+
+inline float row_max(const float* x, int64_t C) {
+    float m = -INFINITY;
+    for (int64_t j = 0; j < C; ++j) m = std::max(m, x[j]);
+    return m;
+}
+inline float row_lse(const float* x, int64_t C) {
+    float m = row_max(x, C), s = 0.f;
+    for (int64_t j = 0; j < C; ++j) s += std::exp(x[j] - m);
+    return std::log(s) + m;
+}
+inline void softmax_row(const float* x, float* y, int64_t C) {
+    const float m = row_max(x, C);
+    float s = 0.f;
+    for (int64_t j = 0; j < C; ++j) { y[j] = std::exp(x[j] - m); s += y[j]; }
+    for (int64_t j = 0; j < C; ++j) y[j] /= s;
+}
+inline float ce_row(const float* z, const float* t, int64_t C) {
+    const float lse = row_lse(z, C);
+    float s = 0.f;
+    for (int64_t j = 0; j < C; ++j) s += t[j] * (z[j] - lse);
+    return s;
+}
+
+} // namespace
+)";
+
+// Literal args in plan order; the generated code indexes them that way.
+template <class F>
+static void for_each_literal(const Plan& plan, F f) {
+    auto visit = [&](const Step& st) {
+        for (const Arg& a : st.args)
+            if (std::holds_alternative<ArgLit>(a)) f(a);
+    };
+    for (const Step& st : plan.steps) {
+        visit(st);
+        for (const Step& m : st.members) visit(m);
+    }
+}
+
+// FNV-1a over everything the generated code bakes in.
+static uint64_t plan_fingerprint(const Plan& plan) {
+    uint64_t h = 1469598103934665603ull;
+    auto add = [&](uint64_t v) {
+        for (int b = 0; b < 8; ++b) { h ^= (v >> (8 * b)) & 0xff; h *= 1099511628211ull; }
+    };
+    auto add_arg = [&](const Arg& a) {
+        add(a.index());
+        if (auto* x = std::get_if<ArgInput>(&a))      add(uint64_t(x->idx));
+        else if (auto* x = std::get_if<ArgParam>(&a)) add(uint64_t(x->idx));
+        else if (auto* x = std::get_if<ArgSlot>(&a))  add(uint64_t(x->slot));
+        else { const Shape s = std::get<ArgLit>(a).t.shape(); add(uint64_t(s.first)); add(uint64_t(s.second)); }
+    };
+    auto add_step = [&](const Step& st) {
+        add(uint64_t(st.op)); add(uint64_t(int64_t(st.grad_of))); add(uint64_t(st.out_slot));
+        add(st.q ? 1u + 2u * st.q->in_int8 + 4u * (st.q->out_scale > 0.f) : 0u);
+        add(uint64_t(st.out_shape.first)); add(uint64_t(st.out_shape.second));
+        add(st.args.size());
+        for (const Arg& a : st.args) add_arg(a);
+    };
+    add(kAotAbi);
+    for (const Shape& s : plan.sig.in_shapes)    { add(uint64_t(s.first)); add(uint64_t(s.second)); }
+    for (const Shape& s : plan.sig.param_shapes) { add(uint64_t(s.first)); add(uint64_t(s.second)); }
+    add(plan.steps.size());
+    for (const Step& st : plan.steps) {
+        add_step(st);
+        add(st.members.size());
+        for (const Step& m : st.members) add_step(m);
+    }
+    for (const Shape& s : plan.slot_shape) { add(uint64_t(s.first)); add(uint64_t(s.second)); }
+    for (int b : plan.slot_buf) add(uint64_t(int64_t(b)));
+    for (size_t o : plan.buf_offset) add(o);
+    add(plan.scratch_offset);
+    return h;
+}
+
+namespace {
+
+struct AotEmitter {
+    const Plan& plan;
+    std::unordered_map<const Arg*, int> lit_ix;
+    std::string out;
+
+    explicit AotEmitter(const Plan& p) : plan(p) {
+        for_each_literal(plan, [&](const Arg& a) { lit_ix.emplace(&a, int(lit_ix.size())); });
+    }
+
+    static std::string num(int64_t v) { return std::to_string(v); }
+
+    std::string slot(int s) const {
+        return "(A + " + num(int64_t(plan.buf_offset[plan.slot_buf[s]])) + ")";
+    }
+    std::string ptr(const Arg& a) const {
+        if (auto* x = std::get_if<ArgInput>(&a)) return "in[" + num(x->idx) + "]";
+        if (auto* x = std::get_if<ArgParam>(&a)) return "par[" + num(x->idx) + "]";
+        if (auto* x = std::get_if<ArgSlot>(&a))  return slot(x->slot);
+        return "lit[" + num(lit_ix.at(&a)) + "]";
+    }
+    // Element (i, j) of a C-wide output, read from an operand broadcast as k.
+    static std::string at(const std::string& p, Bcast k, int64_t C) {
+        switch (k) {
+            case Bcast::Full: return p + "[i * " + num(C) + " + j]";
+            case Bcast::Row:  return p + "[j]";
+            case Bcast::Col:  return p + "[i]";
+            default:          return p + "[0]";
+        }
+    }
+    // The value of elementwise step m given its operands' expressions.
+    std::string elem(const Step& m, const std::string& u, const std::string& v) const {
+        switch (m.op) {
+            case Op::Add: return "(" + u + " + " + v + ")";
+            case Op::Sub: return "(" + u + " - " + v + ")";
+            case Op::Mul: return "(" + u + " * " + v + ")";
+            default:
+                return std::string("f_") + op_name(m.op) + "(" + u + ", " +
+                       (m.op == Op::LeakyRelu ? ptr(m.args[1]) + "[0]" : std::string("0.f")) + ")";
+        }
+    }
+    void line(int indent, const std::string& s) { out.append(size_t(indent) * 4, ' ').append(s).append("\n"); }
+
+    // Y += a @ b for a MatMul-shaped step, through the plugin when bound.
+    void gemm_acc(const std::string& fn, const Step& st) {
+        const Shape sa = arg_shape(plan, st.args[0]);
+        const std::string M = num(sa.first), K = num(sa.second), N = num(st.out_shape.second);
+        const std::string a = ptr(st.args[0]), b = ptr(st.args[1]), Y = slot(st.out_slot);
+        line(1, "if (" + fn + ") ((matmul_fn)" + fn + ")(" + a + ", " + b + ", " + Y + ", " + M + ", " + K +
+                ", " + N + ");");
+        line(1, "else for (int64_t i = 0; i < " + M + "; ++i)");
+        line(2, "for (int64_t k = 0; k < " + K + "; ++k) {");
+        line(3, "const float aik = " + a + "[i * " + K + " + k];");
+        line(3, "for (int64_t j = 0; j < " + N + "; ++j) " + Y + "[i * " + N + " + j] += aik * " + b +
+                "[k * " + N + " + j];");
+        line(2, "}");
+    }
+
+    // Returns false for steps left to the interpreter (and int8 ones).
+    bool plain(int k, const Step& st) {
+        if (st.q) return false;
+        const std::string Y = slot(st.out_slot);
+        const int64_t R = st.out_shape.first, C = st.out_shape.second, n = R * C;
+        const std::string fn = "fns[" + num(k) + "]";
+        switch (st.op) {
+            case Op::Add: case Op::Sub: case Op::Mul: {
+                const std::string a = ptr(st.args[0]), b = ptr(st.args[1]);
+                if (st.bcast[0] == Bcast::Full && st.bcast[1] == Bcast::Full) {
+                    line(1, "for (int64_t t = 0; t < " + num(n) + "; ++t) " + Y + "[t] = " +
+                            elem(st, a + "[t]", b + "[t]") + ";");
+                } else {
+                    line(1, "for (int64_t i = 0; i < " + num(R) + "; ++i)");
+                    line(2, "for (int64_t j = 0; j < " + num(C) + "; ++j) " + Y + "[i * " + num(C) + " + j] = " +
+                            elem(st, at(a, st.bcast[0], C), at(b, st.bcast[1], C)) + ";");
+                }
+                return true;
+            }
+            case Op::Relu: case Op::Exp: case Op::Log: case Op::Tanh: case Op::Sigmoid:
+            case Op::Softplus: case Op::SiLU: case Op::GELU: case Op::LeakyRelu: {
+                const std::string x = ptr(st.args[0]);
+                if (st.op == Op::LeakyRelu)
+                    line(1, "if (" + fn + ") ((leakyrelu_fn)" + fn + ")(" + x + ", " + Y + ", " + num(n) + ", " +
+                            ptr(st.args[1]) + "[0]);");
+                else
+                    line(1, "if (" + fn + ") ((unary_fn)" + fn + ")(" + x + ", " + Y + ", " + num(n) + ");");
+                line(1, "else for (int64_t t = 0; t < " + num(n) + "; ++t) " + Y + "[t] = " + elem(st, x + "[t]", "") + ";");
+                return true;
+            }
+            case Op::Transpose: {
+                const Shape s = arg_shape(plan, st.args[0]);
+                line(1, "for (int64_t i = 0; i < " + num(s.first) + "; ++i)");
+                line(2, "for (int64_t j = 0; j < " + num(s.second) + "; ++j) " + Y + "[j * " + num(s.first) +
+                        " + i] = " + ptr(st.args[0]) + "[i * " + num(s.second) + " + j];");
+                return true;
+            }
+            case Op::MatMul:
+                line(1, "std::fill(" + Y + ", " + Y + " + " + num(n) + ", 0.f);");
+                gemm_acc(fn, st);
+                return true;
+            case Op::FMA: case Op::LinearRelu: case Op::LinearGELU: case Op::LinearSiLU: {
+                // Bias first, GEMM onto it, then the activation in place
+                // (always the inline formula: fns[k] holds the matmul).
+                const std::string c = at(ptr(st.args[2]), bcast_of(arg_shape(plan, st.args[2]), st.out_shape), C);
+                line(1, "for (int64_t i = 0; i < " + num(R) + "; ++i)");
+                line(2, "for (int64_t j = 0; j < " + num(C) + "; ++j) " + Y + "[i * " + num(C) + " + j] = " + c + ";");
+                gemm_acc(fn, st);
+                if (st.op != Op::FMA) {
+                    const std::string f = st.op == Op::LinearRelu ? "f_relu" : st.op == Op::LinearGELU ? "f_gelu" : "f_silu";
+                    line(1, "for (int64_t t = 0; t < " + num(n) + "; ++t) " + Y + "[t] = " + f + "(" + Y + "[t], 0.f);");
+                }
+                return true;
+            }
+            case Op::Sum: case Op::MeanAll: {
+                const size_t m = numel(arg_shape(plan, st.args[0]));
+                line(1, "float s = 0.f;");
+                line(1, "for (int64_t t = 0; t < " + num(int64_t(m)) + "; ++t) s += " + ptr(st.args[0]) + "[t];");
+                line(1, Y + "[0] = " + (st.op == Op::MeanAll ? "s / float(" + num(int64_t(m)) + ")" : "s") + ";");
+                return true;
+            }
+            case Op::RowSum: case Op::RowMax: case Op::LogSumExpRow: case Op::SoftmaxRow: {
+                const Shape s = arg_shape(plan, st.args[0]);
+                const std::string x = ptr(st.args[0]) + " + i * " + num(s.second), W = num(s.second);
+                line(1, "for (int64_t i = 0; i < " + num(s.first) + "; ++i) {");
+                if (st.op == Op::RowSum) {
+                    line(2, "float s = 0.f;");
+                    line(2, "for (int64_t j = 0; j < " + W + "; ++j) s += (" + x + ")[j];");
+                    line(2, Y + "[i] = s;");
+                } else if (st.op == Op::SoftmaxRow) {
+                    line(2, "softmax_row(" + x + ", " + Y + " + i * " + W + ", " + W + ");");
+                } else {
+                    line(2, Y + "[i] = " + (st.op == Op::RowMax ? "row_max(" : "row_lse(") + x + ", " + W + ");");
+                }
+                line(1, "}");
+                return true;
+            }
+            case Op::CeWithLogits: {
+                const Shape s = arg_shape(plan, st.args[0]);
+                const std::string W = num(s.second);
+                line(1, "float s = 0.f;");
+                line(1, "for (int64_t i = 0; i < " + num(s.first) + "; ++i) s += ce_row(" + ptr(st.args[0]) + " + i * " +
+                        W + ", " + ptr(st.args[1]) + " + i * " + W + ", " + W + ");");
+                line(1, Y + "[0] = -s / float(" + num(s.first) + ");");
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    // One loop nest per fused group: member values are locals, and a
+    // reducing tail folds them as they are produced (or, for the tails
+    // that need a whole row twice, from a row built in scratch).
+    void fused(const Step& g) {
+        const Op tail = op_kind(g.members.back().op) != OpKind::Elementwise ? g.members.back().op : Op::Leaf;
+        const size_t n_elem = g.members.size() - (tail != Op::Leaf ? 1 : 0);
+        const Shape e = g.members.front().out_shape;
+        const int64_t R = e.first, C = e.second;
+        const std::string Y = slot(g.out_slot), S = "(A + " + num(int64_t(plan.scratch_offset)) + ")";
+        const bool whole = tail == Op::Sum || tail == Op::MeanAll || tail == Op::CeWithLogits;
+
+        if (whole) line(1, "float acc = 0.f;");
+        line(1, "for (int64_t i = 0; i < " + num(R) + "; ++i) {");
+        if (tail == Op::RowSum) line(2, "float r = 0.f;");
+        if (tail == Op::RowMax) line(2, "float r = -INFINITY;");
+        line(2, "for (int64_t j = 0; j < " + num(C) + "; ++j) {");
+        for (size_t k = 0; k < n_elem; ++k) {
+            const Step& m = g.members[k];
+            const bool binary = m.op == Op::Add || m.op == Op::Sub || m.op == Op::Mul;
+            std::string ops[2];
+            for (size_t q = 0; q < (binary ? 2u : 1u); ++q)
+                ops[q] = is_chain(g, k, m.args[q]) ? "v" + num(int64_t(k) - 1)
+                                                   : at(ptr(m.args[q]), binary ? m.bcast[q] : Bcast::Full, C);
+            line(3, "const float v" + num(int64_t(k)) + " = " + elem(m, ops[0], ops[1]) + ";");
+        }
+        const std::string v = "v" + num(int64_t(n_elem) - 1), ij = "[i * " + num(C) + " + j]";
+        switch (tail) {
+            case Op::Leaf:   line(3, Y + ij + " = " + v + ";"); break;
+            case Op::Sum: case Op::MeanAll: line(3, "acc += " + v + ";"); break;
+            case Op::RowSum: line(3, "r += " + v + ";"); break;
+            case Op::RowMax: line(3, "r = std::max(r, " + v + ");"); break;
+            default:         line(3, S + "[j] = " + v + ";"); break;
+        }
+        line(2, "}");
+        if (tail == Op::RowSum || tail == Op::RowMax) line(2, Y + "[i] = r;");
+        if (tail == Op::LogSumExpRow) line(2, Y + "[i] = row_lse(" + S + ", " + num(C) + ");");
+        if (tail == Op::SoftmaxRow) line(2, "softmax_row(" + S + ", " + Y + " + i * " + num(C) + ", " + num(C) + ");");
+        if (tail == Op::CeWithLogits)
+            line(2, "acc += ce_row(" + S + ", " + ptr(g.members.back().args[1]) + " + i * " + num(C) + ", " + num(C) + ");");
+        line(1, "}");
+        if (tail == Op::Sum)          line(1, Y + "[0] = acc;");
+        if (tail == Op::MeanAll)      line(1, Y + "[0] = acc / float(" + num(R * C) + ");");
+        if (tail == Op::CeWithLogits) line(1, Y + "[0] = -acc / float(" + num(R) + ");");
+    }
+
+    std::string run() {
+        out = kAotPrelude;
+        out += "\nAG_AOT_EXPORT unsigned ag_aot_abi() { return " + num(kAotAbi) + "; }\n";
+        out += "AG_AOT_EXPORT unsigned long long ag_aot_fingerprint() { return " +
+               std::to_string(plan_fingerprint(plan)) + "ull; }\n\n";
+        out += "AG_AOT_EXPORT void ag_aot_run(const float* const* in, const float* const* par, "
+               "const float* const* lit,\n        float* A, const void* const* fns, "
+               "void (*step)(void*, int), void* ctx) {\n";
+        out += "    (void)in; (void)par; (void)lit; (void)fns; (void)step; (void)ctx;\n";
+        for (int k = 0; k < int(plan.steps.size()); ++k) {
+            const Step& st = plan.steps[k];
+            std::string name = st.members.empty() ? op_name(st.op) : "fused";
+            if (st.grad_of >= 0) name += " backward";
+            out += "  { // step " + num(k) + ": " + name + "\n";
+            if (!st.members.empty()) fused(st);
+            else if (st.grad_of >= 0 || !plain(k, st)) line(1, "step(ctx, " + num(k) + ");");
+            out += "  }\n";
+        }
+        out += "}\n";
+        return out;
+    }
+};
+
+} // namespace
+
+void Compiled::emit_cpp(const std::string& path) const {
+    if (!p) throw std::runtime_error("Compiled::emit_cpp: empty plan");
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) throw std::runtime_error("Compiled::emit_cpp: cannot open " + path);
+    out << AotEmitter(p->plan).run();
+    if (!out) throw std::runtime_error("Compiled::emit_cpp: write failed for " + path);
+}
+
+Compiled Compiled::load_aot(const std::string& so_path) const {
+    if (!p) throw std::runtime_error("Compiled::load_aot: empty plan");
+    void* h = kernels::open_library(so_path.c_str());
+    auto abi = reinterpret_cast<unsigned (*)()>(kernels::library_symbol(h, "ag_aot_abi"));
+    auto fp  = reinterpret_cast<unsigned long long (*)()>(kernels::library_symbol(h, "ag_aot_fingerprint"));
+    auto fn  = reinterpret_cast<AotRun>(kernels::library_symbol(h, "ag_aot_run"));
+    if (!abi || !fp || !fn) throw std::runtime_error("Compiled::load_aot: " + so_path + " is not a jit AOT model");
+    if (abi() != kAotAbi) throw std::runtime_error("Compiled::load_aot: " + so_path + " has another AOT ABI");
+    if (fp() != plan_fingerprint(p->plan))
+        throw std::runtime_error("Compiled::load_aot: " + so_path + " was generated from a different plan");
+
+    Plan pl = p->plan;
+    pl.threads = 1;   // the generated function runs steps in plan order
+    Compiled c = finish(std::move(pl));
+    Impl& im = *c.p;
+    im.aot = fn;
+    for_each_literal(im.plan, [&](const Arg& a) { im.aot_lits.push_back(std::get<ArgLit>(a).t.data()); });
+    for (const Step& st : im.plan.steps)
+        im.aot_fns.push_back(st.matmul_fn ? reinterpret_cast<const void*>(st.matmul_fn)
+                             : st.unary_fn ? reinterpret_cast<const void*>(st.unary_fn)
+                             : st.leaky_fn ? reinterpret_cast<const void*>(st.leaky_fn) : nullptr);
+    return c;
+}
+
+// Runs argv[0] with the given arguments and waits for it; no shell is
+// involved, so paths are passed through untouched. True on exit status 0.
+static bool run_command(const std::vector<std::string>& argv) {
+    std::vector<char*> args;
+    for (const std::string& a : argv) args.push_back(const_cast<char*>(a.c_str()));
+    args.push_back(nullptr);
+#if defined(_WIN32)
+    return _spawnvp(_P_WAIT, args[0], args.data()) == 0;
+#else
+    const pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        execvp(args[0], args.data());
+        _exit(127);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0)
+        if (errno != EINTR) return false;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+#endif
+}
+
+Compiled Compiled::build_aot(const std::string& stem, const std::string& cxx) const {
+    const std::string src = stem + ".cpp", so = stem + ".so";
+    emit_cpp(src);
+    const char* env = std::getenv("CXX");
+    const std::string cc = !cxx.empty() ? cxx : env && *env ? env : "c++";
+    // The compiler may carry a launcher or flags ("ccache g++"): split it
+    // on whitespace, then pass every other argument as is.
+    std::vector<std::string> argv;
+    {
+        std::istringstream words(cc);
+        for (std::string w; words >> w;) argv.push_back(w);
+    }
+    if (argv.empty()) throw std::runtime_error("Compiled::build_aot: empty compiler command");
+    for (const char* a : {"-std=c++17", "-O3", "-shared", "-fPIC", "-o"}) argv.push_back(a);
+    argv.push_back(so);
+    argv.push_back(src);
+    if (!run_command(argv)) {
+        std::string cmd;
+        for (const std::string& a : argv) cmd += (cmd.empty() ? "" : " ") + a;
+        throw std::runtime_error("Compiled::build_aot: `" + cmd + "` failed");
+    }
+    // dlopen searches the library path for names without a slash.
+    return load_aot(so.find('/') == std::string::npos ? "./" + so : so);
+}
+
+// ---------------------------------------------------------------------
+// Post-training int8 quantisation.
+// ---------------------------------------------------------------------
+
+void Compiled::calibrate(bool on) {
+    if (!p) throw std::runtime_error("Compiled::calibrate: empty plan");
+    std::lock_guard<std::mutex> lk(p->calib_mu);
+    if (on && !p->calibrating) p->amax.assign(p->plan.steps.size(), 0.f);
+    p->calibrating = on;
+}
+
+/*
+ *  quantize():
+ *  ------------
+ *  Copies the plan and gives every calibrated GEMM step a QuantGemm:
+ *  the activation scale from its recorded range, and the weight (read
+ *  from `params` or the literal now) rounded to int8 with one scale per
+ *  output column or per tensor. A quantised step whose only reader is
+ *  another quantised step, as its operand 0, hands that step int8 directly:
+ *  its epilogue requantises with the reader's scale, so the pair never
+ *  materialises the float activation between them. The int8 copy of an
+ *  operand lives in the per-lane scratch block, grown here if needed.
+ */
+Compiled Compiled::quantize(const std::vector<Tensor*>& params, const QuantOptions& opts) const {
+    if (!p) throw std::runtime_error("Compiled::quantize: empty plan");
+    Plan plan = p->plan;
+    if (!plan.grad_src.empty())
+        throw std::runtime_error("Compiled::quantize: plans compiled with_grads cannot be quantised");
+    if (params.size() != plan.sig.param_shapes.size())
+        throw std::runtime_error("Compiled::quantize: need one tensor per param");
+    for (size_t i = 0; i < params.size(); ++i)
+        if (params[i]->shape() != plan.sig.param_shapes[i] || !params[i]->is_cpu())
+            throw std::runtime_error("Compiled::quantize: param " + std::to_string(i) + " does not match the plan");
+    std::vector<float> amax;
+    {
+        std::lock_guard<std::mutex> lk(p->calib_mu);
+        amax = p->amax;
+    }
+
+    const size_t n = plan.steps.size();
+    std::vector<std::shared_ptr<QuantGemm>> qs(n);
+    for (size_t k = 0; k < n && k < amax.size(); ++k) {
+        Step& st = plan.steps[k];
+        if (!quantisable(st) || !(amax[k] > 0.f)) continue;
+        const Tensor& W = std::holds_alternative<ArgParam>(st.args[1])
+                              ? *params[std::get<ArgParam>(st.args[1]).idx]
+                              : std::get<ArgLit>(st.args[1]).t;
+        const int64_t K = W.rows(), N = W.cols();
+        const float* w = W.data();
+        auto q = std::make_shared<QuantGemm>();
+        q->a_scale = amax[k] / 127.f;
+        std::vector<float> wmax(opts.per_channel ? N : 1, 0.f);
+        for (int64_t i = 0; i < K; ++i)
+            for (int64_t j = 0; j < N; ++j) {
+                float& m = wmax[opts.per_channel ? j : 0];
+                m = std::max(m, std::abs(w[i * N + j]));
+            }
+        q->w.resize(size_t(K * N));
+        q->col_scale.resize(wmax.size());
+        for (size_t c = 0; c < wmax.size(); ++c) {
+            const float ws = wmax[c] > 0.f ? wmax[c] / 127.f : 1.f;
+            q->col_scale[c] = q->a_scale * ws;
+            wmax[c] = 1.f / ws;   // now the inverse scale
+        }
+        for (int64_t j = 0; j < N; ++j)
+            for (int64_t i = 0; i < K; ++i)
+                q->w[size_t(j * K + i)] = to_int8(w[i * N + j], wmax[opts.per_channel ? j : 0]);
+        qs[k] = q;
+        ++plan.quantized_steps;
+    }
+    if (plan.quantized_steps == 0)
+        throw std::runtime_error("Compiled::quantize: no calibrated GEMM step with a param or literal weight "
+                                 "(call calibrate(true) and run sample batches first)");
+
+    // Int8 hand-offs between quantised steps.
+    std::vector<int> readers(plan.num_slots, 0), reader(plan.num_slots, -1);
+    for (size_t k = 0; k < n; ++k)
+        for_each_arg(plan.steps[k], [&](const Arg& a) {
+            if (auto* sl = std::get_if<ArgSlot>(&a)) { ++readers[sl->slot]; reader[sl->slot] = int(k); }
+        });
+    for (int sl : plan.out_slots) readers[sl] += 2;
+    for (size_t k = 0; k < n; ++k) {
+        const int sl = plan.steps[k].out_slot;
+        if (!qs[k] || readers[sl] != 1 || !qs[reader[sl]]) continue;
+        const Step& next = plan.steps[reader[sl]];
+        auto* a0 = std::get_if<ArgSlot>(&next.args[0]);
+        if (!a0 || a0->slot != sl) continue;
+        qs[k]->out_scale = qs[reader[sl]]->a_scale;
+        qs[reader[sl]]->in_int8 = true;
+        ++plan.int8_links;
+    }
+
+    for (size_t k = 0; k < n; ++k) {
+        if (!qs[k]) continue;
+        Step& st = plan.steps[k];
+        st.q = qs[k];
+        st.matmul_fn = nullptr;
+        st.unary_fn = nullptr;
+    }
+    fit_quant_scratch(plan);
+    return finish(std::move(plan));
+}
+
+PlanStats Compiled::stats() const {
+    PlanStats s;
+    if (!p) return s;
+    const Plan& pl = p->plan;
+    s.steps = int(pl.steps.size());
+    s.slots = pl.num_slots;
+    s.buffers = int(pl.buf_offset.size());
+    s.in_place = pl.in_place_steps;
+    s.arena_bytes = pl.arena_floats * sizeof(float);
+    s.naive_bytes = pl.naive_floats * sizeof(float);
+    s.fused_groups = pl.fused_groups;
+    s.fused_steps = pl.fused_members;
+    s.plugin_kernels = pl.plugin_kernels;
+    s.folded = pl.folded_steps;
+    s.merged = pl.merged_steps;
+    s.removed = pl.removed_steps;
+    s.linear_fused = pl.linear_fused;
+    s.quantized = pl.quantized_steps;
+    s.int8_links = pl.int8_links;
+    for_each_literal(pl, [&](const Arg& a) { s.literal_bytes += std::get<ArgLit>(a).t.numel() * sizeof(float); });
+    for (const Arg& a : pl.grad_src)
+        if (auto* lit = std::get_if<ArgLit>(&a)) s.literal_bytes += lit->t.numel() * sizeof(float);
+    s.critical_path = pl.critical_path;
+    s.threads = p->lanes();
+    s.outputs = int(p->plan.out_slots.size());
+
+    // Traffic: every executed step reads its external args once and
+    // writes its output once; fused chain links never reach memory.
+    for (const Step& st : pl.steps) {
+        std::vector<Shape> in;
+        for_each_arg(st, [&](const Arg& a) { in.push_back(arg_shape(pl, a)); });
+        if (st.members.empty()) {
+            s.bytes_moved += std::size_t(op_cost(st.op, in, st.out_shape).bytes);
+        } else {
+            std::size_t b = numel(st.out_shape) * sizeof(float);
+            for (const Shape& sh : in) b += numel(sh) * sizeof(float);
+            s.bytes_moved += b;
+        }
+    }
+    return s;
+}
+
+} // namespace ag::jit
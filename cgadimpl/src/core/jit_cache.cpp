@@ -0,0 +1,146 @@
+// =====================
+// file: cgadimpl/src/core/jit_cache.cpp
+// =====================
+// PlanCache: compiled plans keyed by input/param shapes, with optional
+// batch bucketing and an LRU bound. See graph.hpp for the contract.
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "ad/graph.hpp"
+
+namespace ag::jit {
+
+struct PlanCache::Entry {
+    std::vector<std::pair<int64_t,int64_t>> key;   // inputs, then params
+    Compiled plan;
+    // Padded runs only, made on first use: copies of the padded inputs
+    // (empty for inputs passed through) and the full-bucket output.
+    std::vector<Tensor> staged;
+    Tensor out;
+};
+
+PlanCache::PlanCache(Builder build, CacheOptions opts)
+    : build_(std::move(build)), opts_(std::move(opts)) {
+    if (!build_) throw std::runtime_error("PlanCache: builder is empty");
+    if (!std::is_sorted(opts_.buckets.begin(), opts_.buckets.end()))
+        throw std::runtime_error("PlanCache: buckets must be ascending");
+}
+
+PlanCache::~PlanCache() = default;
+
+int64_t PlanCache::bucket(int64_t n) const {
+    if (!opts_.pad_batch || n <= 0) return n;
+    if (!opts_.buckets.empty()) {
+        auto it = std::lower_bound(opts_.buckets.begin(), opts_.buckets.end(), n);
+        return it == opts_.buckets.end() ? n : *it;   // past the last bucket: exact
+    }
+    int64_t b = 1;
+    while (b < n) b <<= 1;
+    return b;
+}
+
+CacheStats PlanCache::stats() const {
+    CacheStats s = stats_;
+    s.plans = lru_.size();
+    return s;
+}
+
+void PlanCache::clear() { lru_.clear(); }
+
+/*
+ *  lookup():
+ *  ---------
+ *  Finds the plan for these shapes, with every input of `rows` rows padded
+ *  to bucket(rows) when `pad` is set, and moves it to the front of the LRU
+ *  list. On a miss it traces through the builder on the (staged) tensors,
+ *  compiles, and evicts from the back. The cache is expected to hold a
+ *  handful of plans, so a linear scan beats hashing the key.
+ */
+PlanCache::Entry& PlanCache::lookup(const std::vector<Tensor*>& inputs,
+                                    const std::vector<Tensor*>& params,
+                                    int64_t rows, bool pad) {
+    const int64_t padded_rows = pad ? bucket(rows) : rows;
+    pad = pad && padded_rows != rows;   // an exact bucket shares the plan
+
+    std::vector<std::pair<int64_t,int64_t>> key;
+    key.reserve(inputs.size() + params.size());
+    for (const Tensor* t : inputs) {
+        auto s = t->shape();
+        if (pad && s.first == rows) s.first = padded_rows;
+        key.push_back(s);
+    }
+    for (const Tensor* t : params) key.push_back(t->shape());
+
+    for (auto it = lru_.begin(); it != lru_.end(); ++it) {
+        if (it->key != key) continue;
+        lru_.splice(lru_.begin(), lru_, it);
+        ++stats_.hits;
+        return lru_.front();
+    }
+
+    ++stats_.misses;
+    Entry e;
+    e.key = key;
+    std::vector<Value> in_v, par_v;
+    for (size_t i = 0; i < inputs.size(); ++i)
+        in_v.push_back(constant(key[i] == inputs[i]->shape() ? *inputs[i]
+                                : Tensor::zeros(key[i].first, key[i].second), "input"));
+    for (const Tensor* t : params) par_v.push_back(param(*t, "param"));
+
+    Value y = build_(in_v, par_v);
+    // Padded rows would leak into an output that is not one row per
+    // sample (a scalar loss, a reduction over the batch).
+    if (pad && y.val().rows() != key[0].first)
+        throw std::runtime_error("PlanCache: pad_batch needs a batch-shaped output (rows "
+                                 + std::to_string(y.val().rows()) + " for a batch of "
+                                 + std::to_string(key[0].first) + ")");
+    e.plan = compile(y, in_v, par_v, opts_.compile);
+
+    lru_.push_front(std::move(e));
+    if (opts_.capacity && lru_.size() > opts_.capacity) {
+        lru_.pop_back();
+        ++stats_.evictions;
+    }
+    return lru_.front();
+}
+
+bool PlanCache::run(const std::vector<Tensor*>& inputs,
+                    const std::vector<Tensor*>& params,
+                    Tensor& out) {
+    const int64_t rows = inputs.empty() ? 0 : inputs[0]->rows();
+    Entry& e = lookup(inputs, params, rows, opts_.pad_batch && !inputs.empty());
+    const int64_t padded_rows = inputs.empty() ? 0 : e.key[0].first;
+    if (padded_rows == rows) return e.plan.run(inputs, params, out);
+
+    // Copy each padded input's rows into its staging tensor and zero the
+    // tail, which a larger batch in the same bucket may have filled.
+    if (e.staged.empty())
+        for (size_t i = 0; i < inputs.size(); ++i)
+            e.staged.push_back(e.key[i] == inputs[i]->shape() ? Tensor()
+                               : Tensor(e.key[i].first, e.key[i].second));
+    std::vector<Tensor*> staged(inputs);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (e.staged[i].numel() == 0) continue;
+        Tensor& s = e.staged[i];
+        const size_t live = size_t(rows * s.cols()), total = s.numel();
+        std::memcpy(s.data(), inputs[i]->data(), live * sizeof(float));
+        std::fill(s.data() + live, s.data() + total, 0.f);
+        staged[i] = &s;
+    }
+    if (!e.plan.run(staged, params, e.out)) return false;
+    if (out.shape() != std::make_pair(rows, e.out.cols())) out = Tensor(rows, e.out.cols());
+    std::memcpy(out.data(), e.out.data(), out.numel() * sizeof(float));
+    return true;
+}
+
+bool PlanCache::run(const std::vector<Tensor*>& inputs,
+                    const std::vector<Tensor*>& params,
+                    Tensor& out,
+                    const std::vector<Tensor*>& grads) {
+    // Padded rows would feed the parameter gradients, so never pad here.
+    const int64_t rows = inputs.empty() ? 0 : inputs[0]->rows();
+    return lookup(inputs, params, rows, false).plan.run(inputs, params, out, grads);
+}
+
+} // namespace ag::jit
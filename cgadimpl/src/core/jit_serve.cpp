@@ -0,0 +1,196 @@
+// =====================
+// file: cgadimpl/src/core/jit_serve.cpp
+// =====================
+// Server: a request queue coalesced into padded batches that run on
+// per-bucket compiled plans. See serve.hpp for the contract.
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "ad/serve.hpp"
+
+namespace ag::jit {
+
+Server::Server(Builder build, std::vector<Tensor> params,
+               std::vector<int64_t> input_cols, ServerOptions opts)
+    : params_(std::move(params)), cols_(std::move(input_cols)), opts_(std::move(opts)) {
+    if (!build) throw std::runtime_error("Server: builder is empty");
+    if (cols_.empty()) throw std::runtime_error("Server: a model needs at least one input");
+    if (opts_.max_batch < 1 || opts_.workers < 1)
+        throw std::runtime_error("Server: max_batch and workers must be positive");
+    if (!std::is_sorted(opts_.buckets.begin(), opts_.buckets.end()))
+        throw std::runtime_error("Server: buckets must be ascending");
+    for (Tensor& t : params_) param_ptrs_.push_back(&t);
+
+    // Bucket sizes: the configured ones (else powers of two) below
+    // max_batch, then max_batch itself so every batch has a plan.
+    std::vector<int64_t> sizes;
+    if (opts_.buckets.empty())
+        for (int64_t b = 1; b < opts_.max_batch; b <<= 1) sizes.push_back(b);
+    else
+        for (int64_t b : opts_.buckets)
+            if (b > 0 && b < opts_.max_batch) sizes.push_back(b);
+    sizes.push_back(opts_.max_batch);
+
+    for (int64_t rows : sizes) {
+        std::vector<Value> in_v, par_v;
+        for (int64_t c : cols_) in_v.push_back(constant(Tensor::zeros(rows, c), "input"));
+        for (const Tensor& t : params_) par_v.push_back(param(t, "param"));
+        Value y = build(in_v, par_v);
+        if (y.val().rows() != rows)
+            throw std::runtime_error("Server: model output is not batch-shaped (rows "
+                                     + std::to_string(y.val().rows()) + " for a batch of "
+                                     + std::to_string(rows) + ")");
+        buckets_.push_back({rows, compile(y, in_v, par_v, opts_.compile)});
+    }
+
+    for (int i = 0; i < opts_.workers; ++i) workers_.emplace_back([this] { work(); });
+}
+
+Server::~Server() { shutdown(); }
+
+int64_t Server::bucket(int64_t n) const {
+    for (const Bucket& b : buckets_)
+        if (b.rows >= n) return b.rows;
+    return n;   // more than max_batch: never run
+}
+
+ServerStats Server::stats() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return stats_;
+}
+
+void Server::shutdown() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (std::thread& t : workers_)
+        if (t.joinable()) t.join();
+}
+
+std::future<Tensor> Server::submit(std::vector<Tensor> inputs) {
+    if (inputs.size() != cols_.size())
+        throw std::runtime_error("Server::submit: expected " + std::to_string(cols_.size())
+                                 + " inputs, got " + std::to_string(inputs.size()));
+    const int64_t n = inputs[0].rows();
+    if (n < 1 || n > opts_.max_batch)
+        throw std::runtime_error("Server::submit: request of " + std::to_string(n)
+                                 + " rows (max_batch " + std::to_string(opts_.max_batch) + ")");
+    for (size_t i = 0; i < inputs.size(); ++i)
+        if (inputs[i].rows() != n || inputs[i].cols() != cols_[i])
+            throw std::runtime_error("Server::submit: input " + std::to_string(i)
+                                     + " has the wrong shape");
+
+    Request r;
+    r.inputs = std::move(inputs);
+    r.arrived = std::chrono::steady_clock::now();
+    std::future<Tensor> f = r.done.get_future();
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (stopping_) throw std::runtime_error("Server::submit: server is shut down");
+        queue_.push_back(std::move(r));
+        queued_rows_ += n;
+    }
+    // A worker may be waiting out the oldest request's delay: wake it too.
+    cv_.notify_all();
+    return f;
+}
+
+/*
+ *  work():
+ *  -------
+ *  One worker: wait for a request, then for max_batch queued rows or the
+ *  oldest request's deadline, take whole requests from the front while
+ *  they fit, and run them outside the lock. What did not fit stays at the
+ *  front of the queue; its deadline has usually passed, so the next
+ *  worker to look runs it at once. On shutdown the queue is drained.
+ */
+void Server::work() {
+    Workspace ws;
+    std::vector<Tensor> staged(cols_.size());
+    Tensor out;
+    std::vector<Request> batch;
+    for (;;) {
+        bool full = false;
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait(lk, [&] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) return;   // stopping, nothing left
+            const auto deadline = queue_.front().arrived + opts_.max_delay;
+            cv_.wait_until(lk, deadline, [&] {
+                return stopping_ || queue_.empty() || queued_rows_ >= opts_.max_batch;
+            });
+            if (queue_.empty()) continue;   // another worker took them
+            full = queued_rows_ >= opts_.max_batch;
+            int64_t rows = 0;
+            while (!queue_.empty() && rows + queue_.front().inputs[0].rows() <= opts_.max_batch) {
+                rows += queue_.front().inputs[0].rows();
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            queued_rows_ -= rows;
+        }
+        if (full) cv_.notify_all();   // leftovers may fill another batch
+        run_batch(batch, full, ws, staged, out);
+        batch.clear();
+    }
+}
+
+void Server::run_batch(std::vector<Request>& batch, bool full, Workspace& ws,
+                       std::vector<Tensor>& staged, Tensor& out) {
+    int64_t rows = 0;
+    for (const Request& r : batch) rows += r.inputs[0].rows();
+    const Bucket& b = *std::find_if(buckets_.begin(), buckets_.end(),
+                                    [&](const Bucket& k) { return k.rows >= rows; });
+
+    {
+        // Counted before the futures are set, so a caller that has seen
+        // every result also sees them in stats().
+        std::lock_guard<std::mutex> lk(mu_);
+        stats_.requests += batch.size();
+        stats_.batches += 1;
+        stats_.rows += size_t(rows);
+        stats_.padded += size_t(b.rows);
+        stats_.full += full;
+    }
+
+    size_t done = 0;
+    try {
+        // A lone request that fills its bucket runs on its own tensors;
+        // anything else is gathered into zero-padded staging tensors.
+        std::vector<Tensor*> in(cols_.size());
+        for (size_t i = 0; i < cols_.size(); ++i) {
+            if (batch.size() == 1 && rows == b.rows) {
+                in[i] = &batch[0].inputs[i];
+                continue;
+            }
+            Tensor& s = staged[i];
+            if (s.shape() != std::make_pair(b.rows, cols_[i])) s = Tensor(b.rows, cols_[i]);
+            float* dst = s.data();
+            for (const Request& r : batch) {
+                const size_t n = r.inputs[i].numel();
+                std::memcpy(dst, r.inputs[i].data(), n * sizeof(float));
+                dst += n;
+            }
+            std::fill(dst, s.data() + s.numel(), 0.f);
+            in[i] = &s;
+        }
+        if (!b.plan.run(ws, in, param_ptrs_, out))
+            throw std::runtime_error("Server: plan rejected the batch (param shapes changed?)");
+
+        const int64_t C = out.cols();
+        const float* src = out.data();
+        for (; done < batch.size(); ++done) {
+            const int64_t n = batch[done].inputs[0].rows();
+            Tensor y(n, C);
+            std::memcpy(y.data(), src, size_t(n * C) * sizeof(float));
+            src += n * C;
+            batch[done].done.set_value(std::move(y));
+        }
+    } catch (...) {
+        for (; done < batch.size(); ++done) batch[done].done.set_exception(std::current_exception());
+    }
+}
+
+} // namespace ag::jit
@@ -0,0 +1,41 @@
+// =====================
+// file: cgadimpl/src/core/meta.cpp
+// =====================
+#include "ad/meta.hpp"
+#include <vector>
+
+namespace ag {
+namespace meta {
+
+Footprint footprint(const Value& root) {
+    Footprint fp;
+    if (!root.node) return fp;
+    for (Node* n : topo_from(root.node.get())) {
+        const std::size_t bytes = n->value.numel() * sizeof(float);
+        ++fp.nodes;
+        if (n->op == Op::Leaf) {
+            ++fp.leaves;
+            if (n->requires_grad) fp.param_bytes += bytes;
+        } else {
+            fp.activation_bytes += bytes;
+            std::vector<Shape2> in;
+            in.reserve(n->inputs.size());
+            for (auto& p : n->inputs) in.push_back(p->value.shape());
+            OpCost c = op_cost(n->op, in, n->value.shape());
+            fp.flops += c.flops;
+            fp.bytes_moved += c.bytes;
+        }
+        if (n->requires_grad) fp.grad_bytes += bytes;
+    }
+    return fp;
+}
+
+bool is_meta_graph(const Value& root) {
+    if (!root.node) return false;
+    for (Node* n : topo_from(root.node.get()))
+        if (n->value.is_meta()) return true;
+    return false;
+}
+
+} // namespace meta
+} // namespace ag
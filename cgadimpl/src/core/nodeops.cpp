@@ -40,6 +40,42 @@
 namespace ag {
 namespace detail {
 
+// ---------------------------------------------------------------------
+// Meta mode: when any input is a meta tensor, the op only runs shape
+// inference (the ShapeRule column of ops.def) and returns a node whose
+// value is a meta tensor of the inferred shape. No kernel runs and no
+// data is allocated, so whole models can be traced to count nodes and
+// size activations before anything is materialised.
+// ---------------------------------------------------------------------
+namespace {
+
+template <class... Ns>
+bool any_meta(const Ns&... ns) { return (ns->value.is_meta() || ...); }
+
+std::shared_ptr<Node> meta_leaf(Shape2 shape, const char* name = "leaf") {
+    return std::make_shared<Node>(Tensor::meta(shape.first, shape.second), false, Op::Leaf, name);
+}
+
+std::shared_ptr<Node> meta_node(Op op, std::vector<std::shared_ptr<Node>> inputs,
+                                const char* name, Shape2 shape) {
+    bool rg = false;
+    for (auto& in : inputs) rg = rg || in->requires_grad;
+    auto n = std::make_shared<Node>(Tensor::meta(shape.first, shape.second), rg, op, name);
+    n->inputs = std::move(inputs);
+    ag::debug::on_node_created(n);
+    return n;
+}
+
+std::shared_ptr<Node> meta_node(Op op, std::vector<std::shared_ptr<Node>> inputs, const char* name) {
+    std::vector<Shape2> shapes;
+    shapes.reserve(inputs.size());
+    for (auto& in : inputs) shapes.push_back(in->value.shape());
+    Shape2 out = infer_shape(op, shapes);
+    return meta_node(op, std::move(inputs), name, out);
+}
+
+} // namespace
+
 
 // std::shared_ptr<Node> add_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b){ 
 
@@ -87,6 +123,7 @@ namespace detail {
 //         return n; 
 //     }
 std::shared_ptr<Node> add_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b){
+    if (any_meta(a, b)) return meta_node(Op::Add, {a, b}, "+");
     const Tensor& A = a->value;
     const Tensor& B = b->value;
     if (A.device() != B.device()) {
@@ -143,6 +180,7 @@ std::shared_ptr<Node> add_nodeops(const std::shared_ptr<Node>& a, const std::sha
     // }
 
    std::shared_ptr<Node> sub_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b){ 
+    if (any_meta(a, b)) return meta_node(Op::Sub, {a, b}, "-");
         Tensor y = a->value - b->value; 
         auto n = std::make_shared<Node>(y, a->requires_grad || b->requires_grad, Op::Sub, "-"); 
         n->inputs = {a, b}; 
@@ -186,6 +224,7 @@ std::shared_ptr<Node> add_nodeops(const std::shared_ptr<Node>& a, const std::sha
     // }
 
     std::shared_ptr<Node> mul_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b){ 
+    if (any_meta(a, b)) return meta_node(Op::Mul, {a, b}, "*");
         Tensor y = a->value * b->value; 
         auto n = std::make_shared<Node>(y, a->requires_grad || b->requires_grad, Op::Mul, "*"); 
         n->inputs = {a, b}; 
@@ -194,6 +233,7 @@ std::shared_ptr<Node> add_nodeops(const std::shared_ptr<Node>& a, const std::sha
     }
 
   std::shared_ptr<Node> flomul_nodeops(const std::shared_ptr<Node>& a, float b){ 
+    if (any_meta(a)) return meta_node(Op::Mul, {a, meta_leaf(a->value.shape())}, "*");
         auto c = std::make_shared<Node>(b*Tensor::ones_like(a->value), false, Op::Leaf, "leaf");
         Tensor y = a->value * c->value; 
         auto n = std::make_shared<Node>(y, a->requires_grad || c->requires_grad, Op::Mul, "*"); 
@@ -234,6 +274,7 @@ std::shared_ptr<Node> add_nodeops(const std::shared_ptr<Node>& a, const std::sha
 // }
 
 std::shared_ptr<Node> relu_nodeops(const std::shared_ptr<Node>& x){
+    if (any_meta(x)) return meta_node(Op::Relu, {x}, "relu");
     const Tensor& X = x->value;
     Tensor Y = Tensor::zeros_like(X);
 
@@ -313,6 +354,7 @@ std::shared_ptr<Node> relu_nodeops(const std::shared_ptr<Node>& x){
 // }
 
 std::shared_ptr<Node> matmul_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b) {
+    if (any_meta(a, b)) return meta_node(Op::MatMul, {a, b}, "matmul");
     const Tensor& A = a->value;
     const Tensor& B = b->value;
     if (A.device() != B.device()) {
@@ -375,18 +417,91 @@ std::shared_ptr<Node> matmul_nodeops(const std::shared_ptr<Node>& a, const std::
     //      n->inputs = { a, b , c};
     //      return n;
     // }
+// ---------------------------------------------------------------------
+// GEMM + bias (+ activation): fmab and the Linear* ops. The plugin's
+// matmul accumulates into its output, so the output starts as the
+// broadcast bias and the bias costs no extra pass. The activation then
+// reads that buffer once, instead of the three nodes (and two
+// temporaries) of act(matmul(a, b) + c).
+// ---------------------------------------------------------------------
+namespace {
+
+Tensor gemm_bias(const Tensor& A, const Tensor& B, const Tensor& C, const char* name) {
+    if (A.cols() != B.rows())
+        throw std::runtime_error(std::string(name) + ": inner dimension mismatch.");
+    const int64_t M = A.rows(), K = A.cols(), N = B.cols();
+    auto mm = ag::kernels::cpu().matmul;
+    if (!mm) return Tensor::matmul(A, B) + C;
+    if ((C.rows() != 1 && C.rows() != M) || (C.cols() != 1 && C.cols() != N))
+        throw std::runtime_error(std::string(name) + ": bias does not broadcast to the output.");
+    Tensor Z(M, N);
+    const int64_t rs = C.rows() == 1 ? 0 : C.cols(), cs = C.cols() == 1 ? 0 : 1;
+    const float* c = C.data();
+    float* z = Z.data();
+    for (int64_t i = 0; i < M; ++i)
+        for (int64_t j = 0; j < N; ++j) z[i * N + j] = c[i * rs + j * cs];
+    mm(A.data(), B.data(), z, M, K, N);
+    return Z;
+}
+
+// act(Z) for Relu / GELU / SiLU, written over Z when in_place.
+Tensor activate(Tensor& Z, Op act, bool in_place) {
+    const auto& cpu = ag::kernels::cpu();
+    ag_relu_fn fn = act == Op::Relu ? cpu.relu : act == Op::GELU ? cpu.gelu : nullptr;
+    if (fn) {
+        Tensor Y = in_place ? Z : Tensor(Z.rows(), Z.cols());
+        fn(Z.data(), Y.data(), Z.numel());
+        return Y;
+    }
+    if (act == Op::Relu) return Tensor::relu(Z);
+    if (act == Op::GELU) return Tensor::gelu_tanh(Z);
+    return Tensor::sigmoid(Z) * Z;   // SiLU, as silu_nodeops
+}
+
+std::shared_ptr<Node> linear_act_node(Op op, Op act, const char* name, const std::shared_ptr<Node>& a,
+                                      const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c) {
+    if (any_meta(a, b, c)) return meta_node(op, {a, b, c}, name);
+    if (!a->value.is_cpu()) throw std::runtime_error(std::string(name) + " on CUDA not implemented yet!");
+    const bool rg = a->requires_grad || b->requires_grad || c->requires_grad;
+    Tensor Z = gemm_bias(a->value, b->value, c->value, name);
+    // GELU and SiLU gradients read the pre-activation; ReLU's reads the output.
+    const bool keep_z = rg && act != Op::Relu;
+    Tensor Y = activate(Z, act, !keep_z);
+    auto n = std::make_shared<Node>(Y, rg, op, name);
+    n->inputs = {a, b, c};
+    if (keep_z) n->tape = {std::make_shared<Tensor>(Z)};
+    ag::debug::on_node_created(n);
+    return n;
+}
+
+} // namespace
+
     std::shared_ptr<Node> fmab_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c){ 
-        Tensor y = Tensor::matmul(a->value, b->value)+c->value; 
+    if (any_meta(a, b, c)) return meta_node(Op::FMA, {a, b, c}, "fmab");
+        Tensor y = a->value.is_cpu() ? gemm_bias(a->value, b->value, c->value, "fmab")
+                                     : Tensor::matmul(a->value, b->value) + c->value;
         auto n = std::make_shared<Node>(y, a->requires_grad || b->requires_grad || c->requires_grad, Op::FMA, "fmab"); 
         n->inputs = {a, b, c}; ag::debug::on_node_created(n); 
         return n; 
     }
 
+std::shared_ptr<Node> linear_relu_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c){
+    return linear_act_node(Op::LinearRelu, Op::Relu, "linear_relu", a, b, c);
+}
+
+std::shared_ptr<Node> linear_gelu_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c){
+    return linear_act_node(Op::LinearGELU, Op::GELU, "linear_gelu", a, b, c);
+}
+
+std::shared_ptr<Node> linear_silu_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c){
+    return linear_act_node(Op::LinearSiLU, Op::SiLU, "linear_silu", a, b, c);
+}
+
 // std::shared_ptr<Node> attention_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c, const std::shared_ptr<Node>& d){ 
 //     Tensor q = Tensor::matmul(a->value, b->value); 
 //     Tensor k = Tensor::matmul(a->value, c->value); 
 //     Tensor v = Tensor::matmul(a->value, d->value);
-//     Tensor g = Tensor::matmul(q, Tensor::transpose(k)*(1.f/sqrt(float(k.cols())))) ;
+//     Tensor g = Tensor::matmul(q, k, false, true, 1.f / sqrt(float(k.cols())));
 //     Tensor s = Tensor::softmax_row(g);
 
 
@@ -429,10 +544,11 @@ std::shared_ptr<Node> matmul_nodeops(const std::shared_ptr<Node>& a, const std::
 
 
     std::shared_ptr<Node> attention_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c, const std::shared_ptr<Node>& d){ 
+    if (any_meta(a, b, c, d)) return meta_node(Op::Attention, {a, b, c, d}, "attention");
     Tensor q = Tensor::matmul(a->value, b->value); 
     Tensor k = Tensor::matmul(a->value, c->value); 
     Tensor v = Tensor::matmul(a->value, d->value);
-    Tensor g = Tensor::matmul(q, Tensor::transpose(k)*(1.f/sqrt(float(k.cols())))) ;
+    Tensor g = Tensor::matmul(q, k, false, true, 1.f / sqrt(float(k.cols())));
     Tensor s = Tensor::softmax_row(g);
     Tensor y = Tensor::matmul(s, v);
     auto n = std::make_shared<Node>(y, a->requires_grad || b->requires_grad || c->requires_grad || d->requires_grad, Op::Attention, "attention"); 
@@ -445,10 +561,11 @@ std::shared_ptr<Node> matmul_nodeops(const std::shared_ptr<Node>& a, const std::
 
 
 std::shared_ptr<Node> sigatt_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c, const std::shared_ptr<Node>& d){ 
+    if (any_meta(a, b, c, d)) return meta_node(Op::SigAtt, {a, b, c, d}, "sigatt");
     Tensor q = Tensor::matmul(a->value, b->value); 
     Tensor k = Tensor::matmul(a->value, c->value); 
     Tensor v = Tensor::matmul(a->value, d->value);
-    Tensor g = Tensor::matmul(q, Tensor::transpose(k)*(1.f/sqrt(float(k.cols())))) ;
+    Tensor g = Tensor::matmul(q, k, false, true, 1.f / sqrt(float(k.cols())));
     Tensor s = Tensor::sigmoid(g);
     Tensor y = Tensor::matmul(s, v);
     auto n = std::make_shared<Node>(y, a->requires_grad || b->requires_grad || c->requires_grad || d->requires_grad, Op::SigAtt, "sigatt"); 
@@ -460,10 +577,11 @@ std::shared_ptr<Node> sigatt_nodeops(const std::shared_ptr<Node>& a, const std::
     }
 
 std::shared_ptr<Node> reluatt_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c, const std::shared_ptr<Node>& d){ 
+    if (any_meta(a, b, c, d)) return meta_node(Op::RELUAtt, {a, b, c, d}, "reluatt");
     Tensor q = Tensor::matmul(a->value, b->value); 
     Tensor k = Tensor::matmul(a->value, c->value); 
     Tensor v = Tensor::matmul(a->value, d->value);
-    Tensor g = Tensor::matmul(q, Tensor::transpose(k)*(1.f/sqrt(float(k.cols())))) ;
+    Tensor g = Tensor::matmul(q, k, false, true, 1.f / sqrt(float(k.cols())));
     Tensor s = Tensor::relu(g);
     Tensor y = Tensor::matmul(s, v);
     auto n = std::make_shared<Node>(y, a->requires_grad || b->requires_grad || c->requires_grad || d->requires_grad, Op::RELUAtt, "reluatt"); 
@@ -475,7 +593,8 @@ std::shared_ptr<Node> reluatt_nodeops(const std::shared_ptr<Node>& a, const std:
     }
 
 std::shared_ptr<Node> moewe_nodeops(const std::shared_ptr<Node>& x, const std::shared_ptr<Node>& w, const std::shared_ptr<Node>& b){ 
-        Tensor y = Tensor::softmax_row(Tensor::matmul(x->value, Tensor::transpose(w->value)) + b->value); 
+    if (any_meta(x, w, b)) return meta_node(Op::MOE, {x}, "moe", infer_shape(Op::MOE, {x->value.shape(), w->value.shape(), b->value.shape()}));
+        Tensor y = Tensor::softmax_row(Tensor::matmul(x->value, w->value, false, true) + b->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::MOE, "moe"); 
         n->inputs={x}; 
         ag::debug::on_node_created(n);  
@@ -515,6 +634,7 @@ std::shared_ptr<Node> moewe_nodeops(const std::shared_ptr<Node>& x, const std::s
 //     }
 
 std::shared_ptr<Node> div_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b){
+    if (any_meta(a, b)) return meta_node(Op::Div, {a, b}, "/");
     const Tensor& A = a->value;
     const Tensor& B = b->value;
 
@@ -544,6 +664,7 @@ std::shared_ptr<Node> div_nodeops(const std::shared_ptr<Node>& a, const std::sha
 }
 
         std::shared_ptr<Node> reci_nodeops(const std::shared_ptr<Node>& a){ 
+    if (any_meta(a)) return meta_node(Op::Reciprocal, {a}, "reciprocal");
         Tensor y = Tensor::ones_like(a->value)/a->value; 
         auto n = std::make_shared<Node>(y, a->requires_grad, Op::Reciprocal, "reciprocal"); 
         n->inputs = {a}; 
@@ -552,6 +673,7 @@ std::shared_ptr<Node> div_nodeops(const std::shared_ptr<Node>& a, const std::sha
     }
 
      std::shared_ptr<Node> flodiv_nodeops(float b , const std::shared_ptr<Node>& a){ 
+    if (any_meta(a)) return meta_node(Op::Div, {a, meta_leaf(a->value.shape())}, "/");
         auto c = std::make_shared<Node>(b*Tensor::ones_like(a->value), false, Op::Leaf, "leaf");
         Tensor y = c->value / a->value; 
         auto n = std::make_shared<Node>(y, a->requires_grad || c->requires_grad, Op::Div, "/"); 
@@ -562,6 +684,7 @@ std::shared_ptr<Node> div_nodeops(const std::shared_ptr<Node>& a, const std::sha
 
 
      std::shared_ptr<Node> floadd_nodeops(float b , const std::shared_ptr<Node>& a){ 
+    if (any_meta(a)) return meta_node(Op::Add, {a, meta_leaf(a->value.shape())}, "+");
         auto c = std::make_shared<Node>(b*Tensor::ones_like(a->value), false, Op::Leaf, "leaf");
         Tensor y = c->value + a->value; 
         auto n = std::make_shared<Node>(y, a->requires_grad || c->requires_grad, Op::Add, "+"); 
@@ -585,6 +708,7 @@ std::shared_ptr<Node> div_nodeops(const std::shared_ptr<Node>& a, const std::sha
 //     }
 
 std::shared_ptr<Node> relumask_nodeops(const std::shared_ptr<Node>& x) {
+    if (any_meta(x)) return meta_node(Op::Relumask, {x}, "relumask");
     const Tensor& xin = x->value;
     Tensor y = Tensor::zeros_like(xin);
 
@@ -629,34 +753,25 @@ std::shared_ptr<Node> relumask_nodeops(const std::shared_ptr<Node>& x) {
 
 
 std::shared_ptr<Node> linear_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c){
+    if (any_meta(a, b, c)) return meta_node(Op::Linear, {a, b, c}, "linear");
     const Tensor& A = a->value;
-    const Tensor B = Tensor::transpose(b->value);
+    const Tensor& W = b->value;   // [N, K]: y = a @ w^T + c
 
     auto [M,K]  = A.shape();
-    auto [K2,N] = B.shape();
+    auto [N,K2] = W.shape();
     if (K != K2) throw std::runtime_error("gemm: inner dims mismatch");
 
     const Tensor& C = c->value;
 
-    Tensor E({M,N});
+    Tensor E(M, N);
 
-    // Direct implementation of fused multiply-add (A * B + C)
-    const float* a_data = A.data();
-    const float* b_data = B.data();
+    // E = c (broadcast if it is a row), then E += A @ W^T with W read in place.
     const float* c_data = C.data();
     float* e_data = E.data();
-
-    for (int64_t i = 0; i < M; ++i) {
-        for (int64_t j = 0; j < N; ++j) {
-            float sum = 0.0f;
-            for (int64_t k = 0; k < K; ++k) {
-                // A is row-major, B (transposed) is row-major
-                sum += a_data[i * K + k] * b_data[k * N + j];
-            }
-            // Add bias, assuming C can be broadcasted if it's a vector
-            e_data[i * N + j] = sum + (C.numel() == N ? c_data[j] : c_data[i * N + j]);
-        }
-    }
+    for (int64_t i = 0; i < M; ++i)
+        for (int64_t j = 0; j < N; ++j)
+            e_data[i * N + j] = C.numel() == N ? c_data[j] : c_data[i * N + j];
+    ag::kernels::gemm(false, true, M, N, K, 1.f, A.data(), K, W.data(), K, 1.f, e_data, N);
 
     auto n = std::make_shared<Node>(E,
         (a->requires_grad || b->requires_grad || c->requires_grad),
@@ -667,6 +782,7 @@ std::shared_ptr<Node> linear_nodeops(const std::shared_ptr<Node>& a, const std::
 
 
     std::shared_ptr<Node> cosh_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Cosh, {x}, "cosh");
         Tensor y = Tensor::cosh(x->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Cosh, "cosh"); 
         n->inputs={x}; 
@@ -675,6 +791,7 @@ std::shared_ptr<Node> linear_nodeops(const std::shared_ptr<Node>& a, const std::
     }
 
      std::shared_ptr<Node> sinh_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Sinh, {x}, "sinh");
         Tensor y = Tensor::sinh(x->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Sinh, "sinh"); 
         n->inputs={x}; 
@@ -684,6 +801,7 @@ std::shared_ptr<Node> linear_nodeops(const std::shared_ptr<Node>& a, const std::
 
 
      std::shared_ptr<Node> cos_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Cosh, {x}, "cosh");
         Tensor y = Tensor::cosh(x->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Cosh, "cosh"); 
         n->inputs={x}; 
@@ -692,6 +810,7 @@ std::shared_ptr<Node> linear_nodeops(const std::shared_ptr<Node>& a, const std::
     }
 
      std::shared_ptr<Node> sin_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Sinh, {x}, "sinh");
         Tensor y = Tensor::sinh(x->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Sinh, "sinh"); 
         n->inputs={x}; 
@@ -701,6 +820,7 @@ std::shared_ptr<Node> linear_nodeops(const std::shared_ptr<Node>& a, const std::
 
 
         std::shared_ptr<Node> sign_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Sign, {x}, "sign");
         Tensor y = Tensor::sign(x->value); 
 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Sign, "sign"); 
@@ -719,6 +839,7 @@ std::shared_ptr<Node> linear_nodeops(const std::shared_ptr<Node>& a, const std::
     // }
 
 std::shared_ptr<Node> sqrt_nodeops(const std::shared_ptr<Node>& x){
+    if (any_meta(x)) return meta_node(Op::Sqrt, {x}, "sqrt");
     const Tensor& X = x->value;
     Tensor Y = Tensor::zeros_like(X);
 
@@ -744,11 +865,12 @@ std::shared_ptr<Node> sqrt_nodeops(const std::shared_ptr<Node>& x){
 
 
     std::shared_ptr<Node> alibiatt_nodeops(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c, const std::shared_ptr<Node>& d, float& m) { 
+    if (any_meta(a, b, c, d)) return meta_node(Op::AlibiAttention, {a, b, c, d}, "alibiattention");
     Tensor q = Tensor::matmul(a->value, b->value); 
     Tensor k = Tensor::matmul(a->value, c->value); 
     Tensor v = Tensor::matmul(a->value, d->value);
     
-    Tensor logits = Tensor::matmul(q, Tensor::transpose(k) * (1.f / sqrt(float(k.cols()))));
+    Tensor logits = Tensor::matmul(q, k, false, true, 1.f / sqrt(float(k.cols())));
     Tensor bias   = Tensor::alibi(logits.rows(), logits.cols(), m);
     Tensor g      = logits + bias;
 
@@ -769,10 +891,11 @@ std::shared_ptr<Node> sqrt_nodeops(const std::shared_ptr<Node>& x){
 
 
     std::shared_ptr<Node> swiglu_nodeops(const std::shared_ptr<Node>& x, const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c, const std::shared_ptr<Node>& d){ 
-    Tensor y = Tensor::matmul(x->value, Tensor::transpose(a->value))+b->value; 
+    if (any_meta(x, a, b, c, d)) return meta_node(Op::SWIGLU, {x, a, b, c, d}, "swiglu", infer_shape(Op::SWIGLU, {x->value.shape(), a->value.shape(), b->value.shape()}));
+    Tensor y = Tensor::matmul(x->value, a->value, false, true)+b->value; 
     debug::print_tensor("y",y);
     Tensor q = y*Tensor::sigmoid(y); 
-    Tensor w = q*(Tensor::matmul(x->value, Tensor::transpose(c->value)) + d->value);
+    Tensor w = q*(Tensor::matmul(x->value, c->value, false, true) + d->value);
     auto n=std::make_shared<Node>(w, x->requires_grad || a->requires_grad || b->requires_grad || c->requires_grad || d->requires_grad, Op::SWIGLU, "swiglu"); 
     n->inputs={x, a, b, c, d};
     ag::debug::on_node_created(n); 
@@ -781,6 +904,7 @@ std::shared_ptr<Node> sqrt_nodeops(const std::shared_ptr<Node>& x){
 
 
     std::shared_ptr<Node> sum_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Sum, {x}, "sum");
         Tensor y = Tensor::sum_all(x->value); 
         auto n = std::make_shared<Node>(y, x->requires_grad, Op::Sum, "sum"); 
         n->inputs = {x}; 
@@ -789,6 +913,7 @@ std::shared_ptr<Node> sqrt_nodeops(const std::shared_ptr<Node>& x){
     }
 
     std::shared_ptr<Node> transpose_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Transpose, {x}, "exp");
         Tensor y = Tensor::transpose(x->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Transpose, "exp"); 
         n->inputs={x}; 
@@ -820,6 +945,7 @@ std::shared_ptr<Node> sqrt_nodeops(const std::shared_ptr<Node>& x){
 
 
 std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
+    if (any_meta(x)) return meta_node(Op::Exp, {x}, "exp");
     const Tensor& X = x->value;
     Tensor Y = Tensor::zeros_like(X);
 
@@ -852,6 +978,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     //     return n;
     // }
     std::shared_ptr<Node> log_nodeops(const std::shared_ptr<Node>& x){
+    if (any_meta(x)) return meta_node(Op::Log, {x}, "log");
     const Tensor& X = x->value;
     Tensor Y = Tensor::zeros_like(X);
 
@@ -877,6 +1004,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
 
 
     std::shared_ptr<Node> mish_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Mish, {x}, "mish");
         Tensor y = x->value * Tensor::tanh( Tensor::softplus(x->value) ); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Mish, "mish"); 
         n->inputs={x}; 
@@ -893,6 +1021,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     // }
     
     std::shared_ptr<Node> tanh_nodeops(const std::shared_ptr<Node>& x){
+    if (any_meta(x)) return meta_node(Op::Tanh, {x}, "tanh");
     const Tensor& X = x->value;
     Tensor Y = Tensor::zeros_like(X);
 
@@ -930,6 +1059,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
 
 
     std::shared_ptr<Node> sigmoid_nodeops(const std::shared_ptr<Node>& x){
+    if (any_meta(x)) return meta_node(Op::Sigmoid, {x}, "sigmoid");
         const Tensor& X = x->value;
         Tensor Y = Tensor::zeros_like(X);
 
@@ -962,6 +1092,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     // }
 
   std::shared_ptr<Node> softplus_nodeops(const std::shared_ptr<Node>& x){
+    if (any_meta(x)) return meta_node(Op::Softplus, {x}, "softplus");
         const Tensor& X = x->value;
         Tensor Y = Tensor::zeros_like(X);
 
@@ -986,6 +1117,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
 
     std::shared_ptr<Node> gaus_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Gaus, {x}, "gaus");
         Tensor y = Tensor::exp(-1*x->value*x->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Gaus, "gaus"); 
         n->inputs={x}; 
@@ -994,6 +1126,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
     
     std::shared_ptr<Node> gelu_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::GELU, {x}, "gelu");
         const Tensor& X = x->value;
         Tensor Y = Tensor::zeros_like(X);
 
@@ -1019,6 +1152,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
 
 
     std::shared_ptr<Node> gcu_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::GCU, {x}, "gcu");
         Tensor y = x->value * Tensor::cos(x->value);
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::GCU, "gcu"); 
         n->inputs={x}; 
@@ -1027,6 +1161,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
     
     std::shared_ptr<Node> silu_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::SiLU, {x}, "silu");
         Tensor y = Tensor::sigmoid(x->value); 
         y = y * x->value; 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::SiLU, "silu"); 
@@ -1036,6 +1171,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
 
     std::shared_ptr<Node> parcon_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Parcon, {x}, "parcon");
         Tensor y = x->value*(2*Tensor::ones_like(x->value)-x->value); 
 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Parcon, "parcon"); 
@@ -1045,6 +1181,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
 
     std::shared_ptr<Node> lisht_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::Parcon, {x}, "parcon");
         Tensor y = x->value*Tensor::tanh(x->value); 
 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::Parcon, "parcon"); 
@@ -1055,6 +1192,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     
     
     std::shared_ptr<Node> leaky_relu_nodeops(const std::shared_ptr<Node>& x, float alpha){ 
+    if (any_meta(x)) return meta_node(Op::LeakyRelu, {x, meta_leaf({1, 1}, "alpha")}, "leakyrelu");
         const Tensor& X = x->value;
         Tensor Y = Tensor::zeros_like(X);
 
@@ -1083,6 +1221,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
 
 
     std::shared_ptr<Node> rowsum_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::RowSum, {x}, "rowsum");
         Tensor y = Tensor::row_sum(x->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::RowSum, "rowsum"); 
         n->inputs={x}; 
@@ -1091,6 +1230,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
     
     std::shared_ptr<Node> rowmax_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::RowMax, {x}, "rowmax");
         Tensor y = Tensor::row_max(x->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::RowMax, "rowmax"); 
         n->inputs={x}; 
@@ -1100,6 +1240,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
 
 
     std::shared_ptr<Node> rms_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::RMSNorm, {x}, "rmsnorm");
         Tensor z = Tensor::row_sum(x->value*x->value) * (1.f/x->value.cols());
         Tensor q = Tensor::sqrt(z + 1e-8f);
         Tensor y = x->value / q;
@@ -1113,6 +1254,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
 
     std::shared_ptr<Node> realrms_nodeops(const std::shared_ptr<Node>& x, float& g){ 
+    if (any_meta(x)) return meta_node(Op::RealRMSNorm, {x, meta_leaf(x->value.shape())}, "realrmsnorm");
         Tensor z = Tensor::row_sum(x->value*x->value) * (1.f/x->value.cols());
         Tensor q = Tensor::sqrt(z + 1e-8f);
         Tensor y = (x->value) / q;
@@ -1127,6 +1269,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
 
     std::shared_ptr<Node> laynor_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::LayerNorm, {x}, "layernorm");
         Tensor y = Tensor::row_sum(x->value)*(1.f/x->value.cols()); 
       //  std::cout<<"q      "<<y<<std::endl;
         Tensor vrc = Tensor::row_sum(((x->value )- y)*((x->value )- y))*(1.f/x->value.cols());
@@ -1145,6 +1288,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
 
     std::shared_ptr<Node> relaynor_nodeops(const std::shared_ptr<Node>& x, float& b, float& g){ 
+    if (any_meta(x)) return meta_node(Op::RealLayerNorm, {x}, "reallayernorm");
         Tensor y = Tensor::row_sum(x->value)*(1.f/x->value.cols()); 
       //  std::cout<<"q      "<<y<<std::endl;
         Tensor vrc = Tensor::row_sum(((x->value )- y)*((x->value )- y))*(1.f/x->value.cols());
@@ -1168,6 +1312,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
     
     std::shared_ptr<Node> mean_all_nodeops(const std::shared_ptr<Node>& x){ 
+    if (any_meta(x)) return meta_node(Op::MeanAll, {x}, "meanall");
         Tensor y = Tensor::mean_all(x->value); 
         auto n=std::make_shared<Node>(y, x->requires_grad, Op::MeanAll, "meanall"); 
         n->inputs={x}; 
@@ -1176,6 +1321,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
 
     std::shared_ptr<Node> dyntanh_nodeops(const std::shared_ptr<Node>& x, float& a, float& b, float& g){ 
+    if (any_meta(x)) return meta_node(Op::MeanAll, {x, meta_leaf(x->value.shape(), "a"), meta_leaf(x->value.shape(), "b"), meta_leaf(x->value.shape(), "g")}, "meanall", x->value.shape());
         Tensor h = x->value*a;
         Tensor y = Tensor::tanh(h)*g + b; 
         std::shared_ptr<Node> A = std::make_shared<Node>(a*Tensor::ones_like(x->value), false, Op::Leaf, "a");
@@ -1189,6 +1335,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
     
     std::shared_ptr<Node> softmax_row_nodeops(const std::shared_ptr<Node>& z){ 
+    if (any_meta(z)) return meta_node(Op::SoftmaxRow, {z}, "softmax_row");
         Tensor y = Tensor::softmax_row(z->value); 
         auto n=std::make_shared<Node>(y, z->requires_grad, Op::SoftmaxRow, "softmax_row"); 
         n->inputs={z}; 
@@ -1197,6 +1344,7 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
     }
     
     std::shared_ptr<Node> logsumexp_row_nodeops(const std::shared_ptr<Node>& z){ 
+    if (any_meta(z)) return meta_node(Op::LogSumExpRow, {z}, "logsumexp_row");
         Tensor y = Tensor::logsumexp_row(z->value); 
         auto n=std::make_shared<Node>(y, z->requires_grad, Op::LogSumExpRow, "logsumexp_row"); 
         n->inputs={z}; 
@@ -1206,6 +1354,13 @@ std::shared_ptr<Node> exp_nodeops(const std::shared_ptr<Node>& x){
 
 
 std::shared_ptr<Node> mambassm_nodeops(const std::shared_ptr<Node>& z, const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b, const std::shared_ptr<Node>& c, const std::shared_ptr<Node>& d){ 
+    if (any_meta(z, a, b, c, d)) {
+        // Shape-only step: the recurrent state on z is left untouched.
+        Shape2 w = infer_shape(Op::MatMul, {z->value.shape(), b->value.shape()});
+        Shape2 q = infer_shape(Op::MatMul, {w, c->value.shape()});
+        Shape2 y = infer_shape(Op::Add, {infer_shape(Op::Mul, {z->value.shape(), d->value.shape()}), q});
+        return meta_node(Op::LogSumExpRow, {z, a, b, c, d, meta_leaf(w)}, "logsumexp_row", y);
+    }
 
         if (z->tape.size()==0) {
 
@@ -1243,6 +1398,7 @@ std::shared_ptr<Node> mambassm_nodeops(const std::shared_ptr<Node>& z, const std
 
 
      std::shared_ptr<Node> cross_entropy_with_logits_nodeops(const std::shared_ptr<Node>& logits,const std::shared_ptr<Node>& onehot){
+    if (any_meta(logits, onehot)) return meta_node(Op::CeWithLogits, {logits, onehot}, "ce_with_logits");
     // Stable CE = mean( -sum(onehot * (logits - logsumexp_row(logits))) )
         Tensor Z = logits->value;
         Tensor Y = onehot->value;
@@ -1263,6 +1419,7 @@ std::shared_ptr<Node> mambassm_nodeops(const std::shared_ptr<Node>& z, const std
 
 
     std::shared_ptr<Node> kldivergence_nodeops(const std::shared_ptr<Node>& logits,const std::shared_ptr<Node>& onehot){
+    if (any_meta(logits, onehot)) return meta_node(Op::KLDivergence, {logits, onehot}, "kldivergence");
     // Stable CE = mean( -sum(onehot * (logits - logsumexp_row(logits))) )
         Tensor Z = logits->value;
         Tensor Y = onehot->value;
@@ -1283,10 +1440,11 @@ std::shared_ptr<Node> mambassm_nodeops(const std::shared_ptr<Node>& z, const std
     }
 
     std::shared_ptr<Node> mse_loss_nodeops(const std::shared_ptr<Node>& pred, const std::shared_ptr<Node>& target) {
+    if (any_meta(pred, target)) return meta_node(Op::MSELoss, {pred, target}, "mseloss");
     Tensor diff = pred->value - target->value;
     Tensor sq   = diff * diff;               // elementwise
     Tensor s    = Tensor::sum_all(sq);                   // scalar [1,1]
-    int B = pred->value.shape().first, C = pred->value.shape().second;
+    int64_t B = pred->value.shape().first, C = pred->value.shape().second;
     Tensor scale = Tensor::ones(1,1);
     scale(0,0) = 1.0f / float(B * C);
     Tensor loss = s * scale;                 // broadcast scalar
@@ -1298,10 +1456,11 @@ std::shared_ptr<Node> mambassm_nodeops(const std::shared_ptr<Node>& z, const std
 
 
     std::shared_ptr<Node> mae_loss_nodeops(const std::shared_ptr<Node>& pred, const std::shared_ptr<Node>& target) {
+    if (any_meta(pred, target)) return meta_node(Op::MAELoss, {pred, target}, "maeloss");
     Tensor diff = pred->value - target->value;
     Tensor sq   = Tensor::abs(diff);               // elementwise
     Tensor s    = Tensor::sum_all(sq);                   // scalar [1,1]
-    int B = pred->value.shape().first, C = pred->value.shape().second;
+    int64_t B = pred->value.shape().first, C = pred->value.shape().second;
     Tensor scale = Tensor::ones(1,1);
     scale(0,0) = 1.0f / float(B * C);
     Tensor loss = s * scale;                 // broadcast scalar
@@ -1331,7 +1490,7 @@ std::shared_ptr<Node> mambassm_nodeops(const std::shared_ptr<Node>& z, const std
     //             Tensor q = Tensor::matmul(a, b);
     //             Tensor k = Tensor::matmul(a, c);
     //             Tensor v = Tensor::matmul(a, d);
-    //             Tensor logits = Tensor::matmul(q, Tensor::transpose(k) * (1.f / sqrt(float(k.cols()))));
+    //             Tensor logits = Tensor::matmul(q, k, false, true, 1.f / sqrt(float(k.cols())));
     //             Tensor bias   = Tensor::alibi(logits.rows(), logits.cols(), /*m*/128);
     //             Tensor g      = logits + bias;
     //             Tensor s      = Tensor::softmax_row(g);
@@ -116,6 +116,18 @@ namespace ag {
         return Value(detail::fmab_nodeops(a.node, b.node, c.node)); 
     }
 
+    Value linear_relu(const Value& a, const Value& b, const Value& c){
+        return Value(detail::linear_relu_nodeops(a.node, b.node, c.node));
+    }
+
+    Value linear_gelu(const Value& a, const Value& b, const Value& c){
+        return Value(detail::linear_gelu_nodeops(a.node, b.node, c.node));
+    }
+
+    Value linear_silu(const Value& a, const Value& b, const Value& c){
+        return Value(detail::linear_silu_nodeops(a.node, b.node, c.node));
+    }
+
 
     Value attention(const Value& a, const Value& b, const Value& c, const Value& d){ 
     return Value(detail::attention_nodeops(a.node, b.node, c.node, d.node));
@@ -360,6 +372,21 @@ Tensor forward_eval_node(const std::shared_ptr<Node> &node) {
             return Tensor::matmul(A, B);
         }
 
+        // GEMM + bias (+ activation); c broadcasts onto a@b.
+        case Op::FMA:
+        case Op::LinearRelu:
+        case Op::LinearGELU:
+        case Op::LinearSiLU: {
+            const Tensor &A = node->inputs[0]->value;
+            const Tensor &B = node->inputs[1]->value;
+            const Tensor &C = node->inputs[2]->value;
+            Tensor Z = Tensor::matmul(A, B) + C;
+            if (node->op == Op::LinearRelu) return Tensor::relu(Z);
+            if (node->op == Op::LinearGELU) return Tensor::gelu_tanh(Z);
+            if (node->op == Op::LinearSiLU) return Tensor::sigmoid(Z) * Z;
+            return Z;
+        }
+
         // ============================================================
         // Unary elementwise activations
         // ============================================================
@@ -412,7 +439,7 @@ Tensor forward_eval_node(const std::shared_ptr<Node> &node) {
             Tensor v = Tensor::matmul(a, d);
 
             // Step 2: scaled dot-product attention
-            Tensor logits = Tensor::matmul(q, Tensor::transpose(k) * (1.f / sqrt(float(k.cols()))));
+            Tensor logits = Tensor::matmul(q, k, false, true, 1.f / sqrt(float(k.cols())));
 
             // Step 3: add ALIBI bias (creates a position-dependent attention slope)
             Tensor bias = Tensor::alibi(logits.rows(), logits.cols(), /*m*/128);
@@ -3,14 +3,17 @@
 // =====================
 
 #include "ad/schema.hpp"
+#include <algorithm>
 #include <array>
+#include <stdexcept>
+#include <string>
 // #include "ad/ops.def" // Ensure OpCount is defined or included
 
 namespace ag {
 
 const char* op_name(Op o) {
   static constexpr std::array<const char*, OpCount> names = {{
-  #define OP(name, arity, str) str,
+  #define OP(name, arity, str, ...) str,
   #include "ad/detail/ops.def"
   #undef OP
   }};
@@ -19,11 +22,117 @@ const char* op_name(Op o) {
 
 int op_arity(Op o) {
   static constexpr std::array<int, OpCount> arities = {{
-  #define OP(name, arity, str) arity,
+  #define OP(name, arity, str, ...) arity,
   #include "ad/detail/ops.def"
   #undef OP
   }};
   return arities[static_cast<std::size_t>(o)];
 }
 
+namespace {
+
+std::string fmt(const Shape2& s) {
+  return "(" + std::to_string(s.first) + ", " + std::to_string(s.second) + ")";
+}
+
+[[noreturn]] void shape_error(Op op, const std::string& what) {
+  throw std::runtime_error(std::string("infer_shape(") + op_name(op) + "): " + what);
+}
+
+void need(Op op, const std::vector<Shape2>& in, std::size_t n) {
+  if (in.size() < n)
+    shape_error(op, "expected at least " + std::to_string(n) + " input shapes, got " + std::to_string(in.size()));
+}
+
+// Same compatibility test as the eager broadcast in tensor.cpp.
+bool broadcast_into(Shape2& acc, const Shape2& s) {
+  bool row_ok = acc.first  == s.first  || acc.first  == 1 || s.first  == 1;
+  bool col_ok = acc.second == s.second || acc.second == 1 || s.second == 1;
+  if (!row_ok || !col_ok) return false;
+  acc = {std::max(acc.first, s.first), std::max(acc.second, s.second)};
+  return true;
+}
+
+} // namespace
+
+Shape2 infer_shape(Op op, const std::vector<Shape2>& in) {
+  switch (op_shape_rule(op)) {
+    case ShapeRule::Leaf:
+      shape_error(op, "leaf shapes come from their tensor, not from inputs");
+
+    case ShapeRule::Same: {
+      need(op, in, 1);
+      for (std::size_t i = 1; i < in.size(); ++i) {
+        Shape2 acc = in[0];
+        if (!broadcast_into(acc, in[i]) || acc != in[0])
+          shape_error(op, "input " + std::to_string(i) + " " + fmt(in[i]) + " does not broadcast onto " + fmt(in[0]));
+      }
+      return in[0];
+    }
+
+    case ShapeRule::Broadcast: {
+      need(op, in, 2);
+      Shape2 acc = in[0];
+      if (!broadcast_into(acc, in[1]))
+        shape_error(op, "incompatible broadcast shapes " + fmt(in[0]) + " and " + fmt(in[1]));
+      return acc;
+    }
+
+    case ShapeRule::MatMul: {
+      need(op, in, 2);
+      if (in[0].second != in[1].first)
+        shape_error(op, "inner dims mismatch " + fmt(in[0]) + " x " + fmt(in[1]));
+      Shape2 out{in[0].first, in[1].second};
+      if (in.size() > 2) {            // FMA: bias broadcasts onto the product
+        Shape2 acc = out;
+        if (!broadcast_into(acc, in[2]) || acc != out)
+          shape_error(op, "bias " + fmt(in[2]) + " does not broadcast onto " + fmt(out));
+      }
+      return out;
+    }
+
+    case ShapeRule::MatMulNT: {
+      need(op, in, 2);
+      if (in[0].second != in[1].second)
+        shape_error(op, "inner dims mismatch " + fmt(in[0]) + " x " + fmt(in[1]) + "^T");
+      Shape2 out{in[0].first, in[1].first};
+      if (in.size() > 2) {            // Linear/MOE/SWIGLU: bias broadcasts onto x W^T
+        Shape2 acc = out;
+        if (!broadcast_into(acc, in[2]) || acc != out)
+          shape_error(op, "bias " + fmt(in[2]) + " does not broadcast onto " + fmt(out));
+      }
+      return out;
+    }
+
+    case ShapeRule::Transpose:
+      need(op, in, 1);
+      return {in[0].second, in[0].first};
+
+    case ShapeRule::RowReduce:
+      need(op, in, 1);
+      return {in[0].first, 1};
+
+    case ShapeRule::Scalar: {
+      need(op, in, 1);
+      Shape2 acc = in[0];
+      for (std::size_t i = 1; i < in.size(); ++i)
+        if (!broadcast_into(acc, in[i]))
+          shape_error(op, "incompatible input shapes " + fmt(in[0]) + " and " + fmt(in[i]));
+      return {1, 1};
+    }
+
+    case ShapeRule::Attention: {
+      need(op, in, 4);
+      const Shape2& x = in[0];
+      for (std::size_t i = 1; i < 4; ++i)
+        if (in[i].first != x.second)
+          shape_error(op, "projection " + std::to_string(i) + " " + fmt(in[i]) + " does not match x " + fmt(x));
+      if (in[1].second != in[2].second)
+        shape_error(op, "query " + fmt(in[1]) + " and key " + fmt(in[2]) + " projections differ");
+      return {x.first, in[3].second};
+    }
+  }
+  shape_error(op, "unknown shape rule");
+}
+
 } // namespace ag
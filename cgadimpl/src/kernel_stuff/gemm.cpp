@@ -0,0 +1,65 @@
+// ============================================
+// cgadimpl/src/kernel_stuff/gemm.cpp
+// ============================================
+#include "ad/kernels_api.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace ag::kernels {
+
+/*
+ *  gemm():
+ *  -------
+ *  C = alpha * op(A) @ op(B) + beta * C (see ag_gemm_fn). The portable
+ *  path keeps the innermost loop contiguous for every transpose pair:
+ *  rows of B are scaled into rows of C when B is not transposed, and
+ *  rows of A (a column of a transposed A is gathered first) are dotted
+ *  with rows of B when it is.
+ */
+void gemm(bool trans_a, bool trans_b, int64_t M, int64_t N, int64_t K,
+          float alpha, const float* A, int64_t lda,
+          const float* B, int64_t ldb,
+          float beta, float* C, int64_t ldc) {
+    if (M <= 0 || N <= 0) return;
+    if (auto fn = cpu().gemm) {
+        fn(trans_a ? 1 : 0, trans_b ? 1 : 0, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc);
+        return;
+    }
+
+    for (int64_t i = 0; i < M; ++i) {
+        float* c = C + i * ldc;
+        if (beta == 0.f)      std::fill(c, c + N, 0.f);
+        else if (beta != 1.f) for (int64_t j = 0; j < N; ++j) c[j] *= beta;
+    }
+    if (K <= 0 || alpha == 0.f) return;
+
+    if (!trans_b) {
+        for (int64_t i = 0; i < M; ++i) {
+            float* c = C + i * ldc;
+            for (int64_t k = 0; k < K; ++k) {
+                const float a = alpha * (trans_a ? A[k * lda + i] : A[i * lda + k]);
+                const float* b = B + k * ldb;
+                for (int64_t j = 0; j < N; ++j) c[j] += a * b[j];
+            }
+        }
+        return;
+    }
+
+    std::vector<float> col(trans_a ? size_t(K) : 0);
+    for (int64_t i = 0; i < M; ++i) {
+        const float* a = A + i * lda;
+        if (trans_a) {
+            for (int64_t k = 0; k < K; ++k) col[size_t(k)] = A[k * lda + i];
+            a = col.data();
+        }
+        float* c = C + i * ldc;
+        for (int64_t j = 0; j < N; ++j) {
+            const float* b = B + j * ldb;
+            float s = 0.f;
+            for (int64_t k = 0; k < K; ++k) s += a[k] * b[k];
+            c[j] += alpha * s;
+        }
+    }
+}
+
+} // namespace ag::kernels
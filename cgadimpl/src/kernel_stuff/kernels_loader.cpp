@@ -2,9 +2,13 @@
 // cgadimpl/src/kernel_stuff/kernels_loader.cpp
 // ============================================
 #include "ad/kernels_api.hpp"
+#include "ad/context.hpp"
+#include <atomic>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <cstdlib>   // <<< add this for std::getenv
+#include <cstdint>
 
 #if defined(_WIN32)
   #include <windows.h>
@@ -20,27 +24,136 @@
 
 namespace ag::kernels {
 
+// Process registry: written only by load_cpu_plugin (under g_cpu_mu).
+// Each ExecutionContext keeps its own copy and re-copies it only when
+// g_cpu_gen moves, so cpu() on the op path is a thread-local read. A
+// pinned context (shared by backward()'s pool workers) is never re-copied.
 static Cpu g_cpu;
-Cpu& cpu(){ return g_cpu; }
+static std::mutex g_cpu_mu;
+static std::atomic<uint64_t> g_cpu_gen{1};
+
+Cpu& cpu(){
+  ExecutionContext& ctx = current_context();
+  const uint64_t gen = g_cpu_gen.load(std::memory_order_acquire);
+  if (!ctx.cpu_pinned && ctx.cpu_generation != gen) {
+    std::lock_guard<std::mutex> lk(g_cpu_mu);
+    ctx.cpu = g_cpu;
+    ctx.cpu_generation = gen;
+  }
+  return ctx.cpu;
+}
 
 static Cuda g_cuda;
 Cuda& cuda(){ return g_cuda; }
 
+// --- v1 fallback ---
+// A v1-only plugin takes int dimensions. We keep its table around and expose
+// 64-bit shims that forward when the sizes fit and throw otherwise, so the
+// registry always has a single (v2) signature.
+static ag_cpu_v1 g_cpu_v1{};
+
+static int narrow_dim(int64_t d, const char* what) {
+  if (d < 0 || d > INT32_MAX)
+    throw std::runtime_error(std::string(what) + ": dimension exceeds v1 plugin ABI (int32); rebuild the plugin against ABI v2");
+  return static_cast<int>(d);
+}
+static void v1_matmul(const float* A, const float* B, float* C, int64_t M, int64_t K, int64_t N) {
+  g_cpu_v1.matmul(A, B, C, narrow_dim(M, "matmul"), narrow_dim(K, "matmul"), narrow_dim(N, "matmul"));
+}
+static void v1_linear(const float* X, const float* W, const float* b, float* Y, int64_t B, int64_t In, int64_t Out) {
+  g_cpu_v1.linear(X, W, b, Y, narrow_dim(B, "linear"), narrow_dim(In, "linear"), narrow_dim(Out, "linear"));
+}
+static void v1_matmul_bwd_dA(const float* dC, const float* B, float* dA, int64_t M, int64_t K, int64_t N) {
+  g_cpu_v1.matmul_bwd_dA(dC, B, dA, narrow_dim(M, "matmul_bwd_dA"), narrow_dim(K, "matmul_bwd_dA"), narrow_dim(N, "matmul_bwd_dA"));
+}
+static void v1_matmul_bwd_dB(const float* A, const float* dC, float* dB, int64_t M, int64_t K, int64_t N) {
+  g_cpu_v1.matmul_bwd_dB(A, dC, dB, narrow_dim(M, "matmul_bwd_dB"), narrow_dim(K, "matmul_bwd_dB"), narrow_dim(N, "matmul_bwd_dB"));
+}
+static void v1_linear_dW(const float* X, const float* dY, float* dW, int64_t B, int64_t In, int64_t Out) {
+  g_cpu_v1.linear_dW(X, dY, dW, narrow_dim(B, "linear_dW"), narrow_dim(In, "linear_dW"), narrow_dim(Out, "linear_dW"));
+}
+static void v1_linear_dX(const float* dY, const float* W, float* dX, int64_t B, int64_t In, int64_t Out) {
+  g_cpu_v1.linear_dX(dY, W, dX, narrow_dim(B, "linear_dX"), narrow_dim(In, "linear_dX"), narrow_dim(Out, "linear_dX"));
+}
+static void v1_linear_db(const float* dY, float* db, int64_t B, int64_t Out) {
+  g_cpu_v1.linear_db(dY, db, narrow_dim(B, "linear_db"), narrow_dim(Out, "linear_db"));
+}
+
+static ag_cpu_v2 upgrade_v1_table(const ag_cpu_v1& t) {
+  g_cpu_v1 = t;
+  ag_cpu_v2 out{};
+  out.abi_version = AG_KERNELS_ABI_V2;
+  out.relu = t.relu;       out.gelu = t.gelu;       out.leakyrelu = t.leakyrelu;
+  out.sigmoid = t.sigmoid; out.tanh = t.tanh;       out.softplus = t.softplus;
+  out.exp = t.exp;         out.log = t.log;         out.sqrt = t.sqrt;
+  out.pow = t.pow;
+  out.relu_bwd = t.relu_bwd;             out.leakyrelu_bwd = t.leakyrelu_bwd;
+  out.sigmoid_bwd_from_s = t.sigmoid_bwd_from_s; out.tanh_bwd_from_t = t.tanh_bwd_from_t;
+  out.gelu_bwd = t.gelu_bwd;             out.softplus_bwd = t.softplus_bwd;
+  out.exp_bwd_from_y = t.exp_bwd_from_y; out.log_bwd = t.log_bwd;
+  out.sqrt_bwd_from_y = t.sqrt_bwd_from_y;
+  out.matmul        = t.matmul        ? &v1_matmul        : nullptr;
+  out.linear        = t.linear        ? &v1_linear        : nullptr;
+  out.matmul_bwd_dA = t.matmul_bwd_dA ? &v1_matmul_bwd_dA : nullptr;
+  out.matmul_bwd_dB = t.matmul_bwd_dB ? &v1_matmul_bwd_dB : nullptr;
+  out.linear_dW     = t.linear_dW     ? &v1_linear_dW     : nullptr;
+  out.linear_dX     = t.linear_dX     ? &v1_linear_dX     : nullptr;
+  out.linear_db     = t.linear_db     ? &v1_linear_db     : nullptr;
+  return out;
+}
+
+// A v2 table is the v3 one without gemm.
+static ag_cpu_v3 upgrade_v2_table(const ag_cpu_v2& t) {
+  ag_cpu_v3 out{};
+  out.abi_version = AG_KERNELS_ABI_V3;
+  out.relu = t.relu;       out.matmul = t.matmul;   out.gelu = t.gelu;
+  out.leakyrelu = t.leakyrelu; out.sigmoid = t.sigmoid; out.tanh = t.tanh;
+  out.softplus = t.softplus; out.exp = t.exp;       out.log = t.log;
+  out.sqrt = t.sqrt;       out.pow = t.pow;         out.linear = t.linear;
+  out.relu_bwd = t.relu_bwd;             out.leakyrelu_bwd = t.leakyrelu_bwd;
+  out.sigmoid_bwd_from_s = t.sigmoid_bwd_from_s; out.tanh_bwd_from_t = t.tanh_bwd_from_t;
+  out.gelu_bwd = t.gelu_bwd;             out.softplus_bwd = t.softplus_bwd;
+  out.exp_bwd_from_y = t.exp_bwd_from_y; out.log_bwd = t.log_bwd;
+  out.sqrt_bwd_from_y = t.sqrt_bwd_from_y;
+  out.matmul_bwd_dA = t.matmul_bwd_dA;   out.matmul_bwd_dB = t.matmul_bwd_dB;
+  out.linear_dW = t.linear_dW;           out.linear_dX = t.linear_dX;
+  out.linear_db = t.linear_db;
+  out.gemm = nullptr;
+  return out;
+}
+
 void load_cpu_plugin(const char* path) {
   if (!path) throw std::runtime_error("load_cpu_plugin: null path");
 
   void* handle = ag_dlopen(path);
   if (!handle) throw std::runtime_error(std::string("dlopen failed: ") + ag_dlerr());
 
-  using getter_t = int(*)(ag_cpu_v1*);
-  auto sym = (getter_t)ag_dlsym(handle, "ag_get_cpu_kernels_v1");
-  if (!sym) throw std::runtime_error("symbol ag_get_cpu_kernels_v1 not found");
+  ag_cpu_v3 table{};
+  using getter_v3_t = int(*)(ag_cpu_v3*);
+  using getter_v2_t = int(*)(ag_cpu_v2*);
+  if (auto sym3 = (getter_v3_t)ag_dlsym(handle, "ag_get_cpu_kernels_v3")) {
+    if (sym3(&table) != 0 || table.abi_version != AG_KERNELS_ABI_V3) {
+      throw std::runtime_error("CPU kernels ABI mismatch or plugin init failed");
+    }
+  } else if (auto sym2 = (getter_v2_t)ag_dlsym(handle, "ag_get_cpu_kernels_v2")) {
+    ag_cpu_v2 t2{};
+    if (sym2(&t2) != 0 || t2.abi_version != AG_KERNELS_ABI_V2) {
+      throw std::runtime_error("CPU kernels ABI mismatch or plugin init failed");
+    }
+    table = upgrade_v2_table(t2);
+  } else {
+    using getter_t = int(*)(ag_cpu_v1*);
+    auto sym = (getter_t)ag_dlsym(handle, "ag_get_cpu_kernels_v1");
+    if (!sym) throw std::runtime_error("symbol ag_get_cpu_kernels_v3/_v2/_v1 not found");
 
-  ag_cpu_v1 table{};
-  if (sym(&table) != 0 || table.abi_version != AG_KERNELS_ABI_V1) {
-    throw std::runtime_error("CPU kernels ABI mismatch or plugin init failed");
+    ag_cpu_v1 t1{};
+    if (sym(&t1) != 0 || t1.abi_version != AG_KERNELS_ABI_V1) {
+      throw std::runtime_error("CPU kernels ABI mismatch or plugin init failed");
+    }
+    table = upgrade_v2_table(upgrade_v1_table(t1));
   }
 
+  std::lock_guard<std::mutex> lk(g_cpu_mu);
   g_cpu.relu   = table.relu;
   g_cpu.matmul = table.matmul;
   g_cpu.gelu   = table.gelu;  
@@ -69,7 +182,19 @@ void load_cpu_plugin(const char* path) {
   g_cpu.linear_dW     = table.linear_dW;
   g_cpu.linear_dX     = table.linear_dX;
   g_cpu.linear_db     = table.linear_db;
+  g_cpu.gemm          = table.gemm;
+  g_cpu_gen.fetch_add(1, std::memory_order_release);
+}
+
+void* open_library(const char* path) {
+  if (!path) throw std::runtime_error("open_library: null path");
+  void* handle = ag_dlopen(path);
+  if (!handle) throw std::runtime_error(std::string("dlopen failed: ") + ag_dlerr());
+  return handle;
+}
 
+void* library_symbol(void* handle, const char* name) {
+  return ag_dlsym(handle, name);
 }
 
 void load_cuda_plugin(const char* path) {
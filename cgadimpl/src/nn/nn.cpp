@@ -41,7 +41,10 @@ Linear::Linear(int in_features, int out_features, Device dev) {
 }
 
 // Forward pass definition
+// On CPU one FMA node: the bias is applied in the GEMM's output pass.
+// CUDA has no fused kernel yet and keeps matmul + add.
 Value Linear::operator()(const Value& input) {   
+    if (W.val().is_cpu()) return fmab(input, W, b);
     return matmul(input, W) + b;
 }
 
@@ -49,7 +52,7 @@ Value Linear::operator()(const Value& input) {
 
 Tensor silu(const Tensor& x){
     Tensor y(x.rows(), x.cols());
-    for(int i=0;i<x.rows();++i) for(int j=0;j<x.cols();++j){
+    for(int64_t i=0;i<x.rows();++i) for(int64_t j=0;j<x.cols();++j){
         float v=x(i,j); float s=1.f/(1.f+std::exp(-v)); y(i,j)=v*s;
     }
     return y;
@@ -57,7 +60,7 @@ Tensor silu(const Tensor& x){
 Tensor gelu(const Tensor& x){
     Tensor y(x.rows(), x.cols());
     constexpr float c = 0.7978845608028654f; // sqrt(2/pi)
-    for(int i=0;i<x.rows();++i) for(int j=0;j<x.cols();++j){
+    for(int64_t i=0;i<x.rows();++i) for(int64_t j=0;j<x.cols();++j){
         float v=x(i,j);
         float u=c*(v+0.044715f*v*v*v);
         y(i,j)=0.5f*v*(1.f+std::tanh(u));
@@ -2,6 +2,7 @@
 // FILE: cgadimpl/src/tensor/tensor.cpp (The Complete and Correct Version)
 // ====================================================================
 #include "tensor.hpp"
+#include "ad/kernels_api.hpp"
 #include <random>
 #include <algorithm>
 #include <stdexcept>
@@ -28,7 +29,7 @@ void cuda_deleter(float* p) { CUDA_CHECK(cudaFree(p)); }
 
 // --- Private Helpers ---
 namespace {
-    inline std::pair<int,int> bshape(int r1,int c1,int r2,int c2){
+    inline std::pair<int64_t,int64_t> bshape(int64_t r1,int64_t c1,int64_t r2,int64_t c2){
         bool row_ok = (r1==r2) || (r1==1) || (r2==1);
         bool col_ok = (c1==c2) || (c1==1) || (c2==1);
         if (!row_ok || !col_ok){
@@ -41,15 +42,15 @@ namespace {
     } 
         return {std::max(r1,r2), std::max(c1,c2)};
     }
-    inline int pick(int i, int dim){ return dim==1 ? 0 : i; }
+    inline int64_t pick(int64_t i, int64_t dim){ return dim==1 ? 0 : i; }
 }
 
 // --- Constructors ---
 Tensor::Tensor() : data_ptr_(nullptr), r_(0), c_(0), dev_(Device::CPU) {}
 
-Tensor::Tensor(int rows, int cols, Device dev) : r_(rows), c_(cols), dev_(dev) {
+Tensor::Tensor(int64_t rows, int64_t cols, Device dev) : r_(rows), c_(cols), dev_(dev) {
     const size_t n = numel();
-    if (n == 0) { data_ptr_ = nullptr; return; }
+    if (n == 0 || dev == Device::Meta) { data_ptr_ = nullptr; return; }
     if (dev == Device::CPU) {
         data_ptr_ = std::shared_ptr<float>(new float[n], cpu_deleter);
     } else {
@@ -60,25 +61,27 @@ Tensor::Tensor(int rows, int cols, Device dev) : r_(rows), c_(cols), dev_(dev) {
 }
 
 // --- Device & Shape Info ---
-int Tensor::rows() const { return r_; }
-int Tensor::cols() const { return c_; }
-std::pair<int,int> Tensor::shape() const { return {r_, c_}; }
+int64_t Tensor::rows() const { return r_; }
+int64_t Tensor::cols() const { return c_; }
+std::pair<int64_t,int64_t> Tensor::shape() const { return {r_, c_}; }
 std::size_t Tensor::numel() const { return static_cast<std::size_t>(r_) * c_; }
 std::size_t Tensor::size() const { return numel(); }
 
 // --- CPU-only element access ---
-float& Tensor::operator()(int i, int j) {
-    if (is_cuda()) throw std::runtime_error("Cannot use operator() on a CUDA tensor.");
-    return data_ptr_.get()[static_cast<size_t>(i) * c_ + j];
+float& Tensor::operator()(int64_t i, int64_t j) {
+    if (!is_cpu()) throw std::runtime_error(is_meta() ? "Cannot use operator() on a meta tensor." : "Cannot use operator() on a CUDA tensor.");
+    return data_ptr_.get()[static_cast<size_t>(i * c_ + j)];
 }
-const float& Tensor::operator()(int i, int j) const {
-    if (is_cuda()) throw std::runtime_error("Cannot use operator() on a CUDA tensor.");
-    return data_ptr_.get()[static_cast<size_t>(i) * c_ + j];
+const float& Tensor::operator()(int64_t i, int64_t j) const {
+    if (!is_cpu()) throw std::runtime_error(is_meta() ? "Cannot use operator() on a meta tensor." : "Cannot use operator() on a CUDA tensor.");
+    return data_ptr_.get()[static_cast<size_t>(i * c_ + j)];
 }
 
 // --- The `.to()` method ---
 Tensor Tensor::to(Device target_dev) const {
     if (dev_ == target_dev) return *this;
+    if (target_dev == Device::Meta) return Tensor(r_, c_, Device::Meta);
+    if (dev_ == Device::Meta) throw std::runtime_error("to: a meta tensor has no data to copy");
     Tensor new_tensor(r_, c_, target_dev);
     const size_t n_bytes = numel() * sizeof(float);
     if (dev_ == Device::CPU && target_dev == Device::CUDA) {
@@ -90,18 +93,18 @@ Tensor Tensor::to(Device target_dev) const {
 }
 
 // --- Factories ---
-Tensor Tensor::zeros(int r, int c, Device dev) {
+Tensor Tensor::zeros(int64_t r, int64_t c, Device dev) {
     Tensor t(r, c, dev);
-    if (t.numel() > 0) {
+    if (t.numel() > 0 && dev != Device::Meta) {
         if (dev == Device::CPU) std::fill(t.data(), t.data() + t.numel(), 0.0f);
         else CUDA_CHECK(cudaMemset(t.data(), 0, t.numel() * sizeof(float)));
     }
     return t;
 }
 
-Tensor Tensor::ones(int r, int c, Device dev) {
+Tensor Tensor::ones(int64_t r, int64_t c, Device dev) {
     Tensor t(r, c, dev);
-    if (t.numel() > 0) {
+    if (t.numel() > 0 && dev != Device::Meta) {
         if (dev == Device::CPU) {
             std::fill(t.data(), t.data() + t.numel(), 1.0f);
         } else {
@@ -112,7 +115,8 @@ Tensor Tensor::ones(int r, int c, Device dev) {
     return t;
 }
 
-Tensor Tensor::randn(int r, int c, unsigned seed, Device dev) {
+Tensor Tensor::randn(int64_t r, int64_t c, unsigned seed, Device dev) {
+    if (dev == Device::Meta) return Tensor(r, c, Device::Meta);
     Tensor t_cpu(r, c, Device::CPU);
     std::mt19937 gen(seed);
     std::normal_distribution<float> dist(0.f, 1.f);
@@ -123,13 +127,12 @@ Tensor Tensor::randn(int r, int c, unsigned seed, Device dev) {
 Tensor Tensor::zeros_like(const Tensor& x) { return zeros(x.r_, x.c_, x.dev_); }
 Tensor Tensor::ones_like(const Tensor& x) { return ones(x.r_, x.c_, x.dev_); }
 Tensor Tensor::floten(float q) { Tensor t(1, 1); t(0,0) = q; return t; }
-Tensor Tensor::alibi(int rows, int cols, float m) { /* Unchanged CPU-only code */ return Tensor(); }
+Tensor Tensor::alibi(int64_t rows, int64_t cols, float m) { /* Unchanged CPU-only code */ return Tensor(); }
 
 // --- Grad accumulation ---
 Tensor& Tensor::add_(const Tensor& g) {
-    std::cout << "[Debug] add_ called on Tensor of shape (" << r_ << ", " << c_ << ") on device " 
-              << (is_cpu() ? "CPU" : "CUDA") << "\n";
     if (this->shape() != g.shape() || this->device() != g.device()) throw std::runtime_error("add_: shape or device mismatch");
+    if (is_meta()) return *this;
     if (is_cpu()) {
         for(size_t i=0; i<numel(); ++i) data()[i] += g.data()[i];
     } else {
@@ -140,7 +143,7 @@ Tensor& Tensor::add_(const Tensor& g) {
 
 // --- Math Functions (CPU-only implementations) ---
 #define REQUIRE_CPU(tensor, func_name) \
-    if ((tensor).is_cuda()) throw std::runtime_error(std::string(func_name) + " is CPU-only for now.")
+    if (!(tensor).is_cpu()) throw std::runtime_error(std::string(func_name) + ((tensor).is_meta() ? " has no data on a meta tensor." : " is CPU-only for now."))
 
 float Tensor::sum_scalar() const { REQUIRE_CPU(*this, "sum_scalar"); return std::accumulate(data(), data() + numel(), 0.0f); }
 Tensor Tensor::sum_all(const Tensor& X) { REQUIRE_CPU(X, "sum_all"); Tensor y(1,1); y(0,0) = X.sum_scalar(); return y; }
@@ -149,10 +152,10 @@ Tensor operator+(const Tensor& a, const Tensor& b) {
     REQUIRE_CPU(a, "operator+"); REQUIRE_CPU(b, "operator+");
     auto [R,C] = bshape(a.rows(),a.cols(),b.rows(),b.cols());
     Tensor y(R,C);
-    for(int i=0;i<R;++i){
-        int ia=pick(i,a.rows()), ib=pick(i,b.rows());
-        for(int j=0;j<C;++j){
-            int ja=pick(j,a.cols()), jb=pick(j,b.cols());
+    for(int64_t i=0;i<R;++i){
+        int64_t ia=pick(i,a.rows()), ib=pick(i,b.rows());
+        for(int64_t j=0;j<C;++j){
+            int64_t ja=pick(j,a.cols()), jb=pick(j,b.cols());
             y(i,j)=a(ia,ja)+b(ib,jb);
         }
     }
@@ -163,10 +166,10 @@ Tensor operator-(const Tensor& a, const Tensor& b) {
     REQUIRE_CPU(a, "operator-"); REQUIRE_CPU(b, "operator-");
     auto [R,C] = bshape(a.rows(),a.cols(),b.rows(),b.cols());
     Tensor y(R,C);
-    for(int i=0;i<R;++i){
-        int ia=pick(i,a.rows()), ib=pick(i,b.rows());
-        for(int j=0;j<C;++j){
-            int ja=pick(j,a.cols()), jb=pick(j,b.cols());
+    for(int64_t i=0;i<R;++i){
+        int64_t ia=pick(i,a.rows()), ib=pick(i,b.rows());
+        for(int64_t j=0;j<C;++j){
+            int64_t ja=pick(j,a.cols()), jb=pick(j,b.cols());
             y(i,j)=a(ia,ja)-b(ib,jb);
         }
     }
@@ -177,10 +180,10 @@ Tensor operator*(const Tensor& a, const Tensor& b) {
     REQUIRE_CPU(a, "operator*"); REQUIRE_CPU(b, "operator*");
     auto [R,C] = bshape(a.rows(),a.cols(),b.rows(),b.cols());
     Tensor y(R,C);
-    for(int i=0;i<R;++i){
-        int ia=pick(i,a.rows()), ib=pick(i,b.rows());
-        for(int j=0;j<C;++j){
-            int ja=pick(j,a.cols()), jb=pick(j,b.cols());
+    for(int64_t i=0;i<R;++i){
+        int64_t ia=pick(i,a.rows()), ib=pick(i,b.rows());
+        for(int64_t j=0;j<C;++j){
+            int64_t ja=pick(j,a.cols()), jb=pick(j,b.cols());
             y(i,j)=a(ia,ja)*b(ib,jb);
         }
     }
@@ -229,8 +232,8 @@ Tensor Tensor::relu_mask(const Tensor& x) {
 Tensor Tensor::transpose(const Tensor& x) {
     REQUIRE_CPU(x, "transpose");
     Tensor y(x.cols(), x.rows(), x.device());
-    for(int i=0; i < x.rows(); ++i) {
-        for(int j=0; j < x.cols(); ++j) {
+    for(int64_t i=0; i < x.rows(); ++i) {
+        for(int64_t j=0; j < x.cols(); ++j) {
             y(j, i) = x(i, j);
         }
     }
@@ -263,8 +266,8 @@ Tensor Tensor::reduce_to(const Tensor& G, const Tensor& like) {
     if (G.shape() == like.shape()) return G;
     Tensor out = Tensor::zeros_like(like);
     if (like.rows() == 1 && like.cols() == 1) { out(0,0) = G.sum_scalar(); return out; }
-    if (like.rows() == 1) { for(int j=0;j<G.cols();++j) for(int i=0;i<G.rows();++i) out(0,j) += G(i,j); return out; }
-    if (like.cols() == 1) { for(int i=0;i<G.rows();++i) for(int j=0;j<G.cols();++j) out(i,0) += G(i,j); return out; }
+    if (like.rows() == 1) { for(int64_t j=0;j<G.cols();++j) for(int64_t i=0;i<G.rows();++i) out(0,j) += G(i,j); return out; }
+    if (like.cols() == 1) { for(int64_t i=0;i<G.rows();++i) for(int64_t j=0;j<G.cols();++j) out(i,0) += G(i,j); return out; }
     return G;
 }
 
@@ -366,10 +369,10 @@ Tensor operator/(const Tensor& a, const Tensor& b) {
     REQUIRE_CPU(a, "operator/"); REQUIRE_CPU(b, "operator/");
     auto [R,C] = bshape(a.rows(),a.cols(),b.rows(),b.cols());
     Tensor y(R,C);
-    for(int i=0;i<R;++i){
-        int ia=pick(i,a.rows()), ib=pick(i,b.rows());
-        for(int j=0;j<C;++j){
-            int ja=pick(j,a.cols()), jb=pick(j,b.cols());
+    for(int64_t i=0;i<R;++i){
+        int64_t ia=pick(i,a.rows()), ib=pick(i,b.rows());
+        for(int64_t j=0;j<C;++j){
+            int64_t ja=pick(j,a.cols()), jb=pick(j,b.cols());
             y(i,j)=a(ia,ja) / b(ib,jb);
         }
     }
@@ -379,8 +382,8 @@ Tensor operator/(const Tensor& a, const Tensor& b) {
 Tensor Tensor::row_sum(const Tensor& X) {
     REQUIRE_CPU(X, "row_sum");
     Tensor y = Tensor::zeros(X.rows(), 1);
-    for(int i=0; i<X.rows(); ++i) {
-        for(int j=0; j<X.cols(); ++j) {
+    for(int64_t i=0; i<X.rows(); ++i) {
+        for(int64_t j=0; j<X.cols(); ++j) {
             y(i,0) += X(i,j);
         }
     }
@@ -390,9 +393,9 @@ Tensor Tensor::row_sum(const Tensor& X) {
 Tensor Tensor::row_max(const Tensor& X) {
     REQUIRE_CPU(X, "row_max");
     Tensor y = Tensor::zeros(X.rows(), 1);
-    for(int i=0; i<X.rows(); ++i) {
+    for(int64_t i=0; i<X.rows(); ++i) {
         float max_val = -INFINITY;
-        for(int j=0; j<X.cols(); ++j) {
+        for(int64_t j=0; j<X.cols(); ++j) {
             if (X(i,j) > max_val) max_val = X(i,j);
         }
         y(i,0) = max_val;
@@ -433,10 +436,10 @@ Tensor Tensor::matmul(const Tensor &A, const Tensor &B){
     Tensor Y = Tensor::zeros(A.rows(), B.cols(), A.device());
 
     if (A.is_cpu()) {
-        for(int i=0;i<A.rows();++i){
-            for(int k=0;k<A.cols();++k){
+        for(int64_t i=0;i<A.rows();++i){
+            for(int64_t k=0;k<A.cols();++k){
                 float aik=A(i,k);
-                for(int j=0;j<B.cols();++j){
+                for(int64_t j=0;j<B.cols();++j){
                     Y(i,j) += aik * B(k,j);
                 }
             }
@@ -447,13 +450,25 @@ Tensor Tensor::matmul(const Tensor &A, const Tensor &B){
     return Y;
 }
 
+Tensor Tensor::matmul(const Tensor &A, const Tensor &B, bool trans_a, bool trans_b, float alpha){
+    const int64_t M = trans_a ? A.cols() : A.rows(), K = trans_a ? A.rows() : A.cols();
+    const int64_t K2 = trans_b ? B.cols() : B.rows(), N = trans_b ? B.rows() : B.cols();
+    if(K != K2) throw std::runtime_error("matmul: inner dim mismatch");
+    if(A.device() != B.device()) throw std::runtime_error("matmul: device mismatch");
+    if (!A.is_cpu()) throw std::runtime_error("Tensor::matmul for CUDA should be called via nodeops dispatch, not directly.");
+
+    Tensor Y(M, N, A.device());
+    ag::kernels::gemm(trans_a, trans_b, M, N, K, alpha, A.data(), A.cols(), B.data(), B.cols(), 0.f, Y.data(), N);
+    return Y;
+}
+
 std::ostream& operator<<(std::ostream& os, const Tensor& t) {
     if (t.is_cuda()) {
         os << "Tensor(" << t.rows() << "x" << t.cols() << ", device=CUDA)";
     } else {
         os << "Tensor (" << t.rows() << "x" << t.cols() << ", device=CPU):\n";
-        for (int i = 0; i < std::min(t.rows(), 10); ++i) {
-            for (int j = 0; j < std::min(t.cols(), 10); ++j) {
+        for(int64_t i=0; i < std::min<int64_t>(t.rows(), 10); ++i) {
+            for(int64_t j=0; j < std::min<int64_t>(t.cols(), 10); ++j) {
                 os << std::setw(10) << std::setprecision(4) << t(i, j) << " ";
             }
             if (t.cols() > 10) os << "...";
@@ -3,6 +3,7 @@
 // =========================================
 #include "ad/debug.hpp"
 #include "ad/graph.hpp"
+#include "ad/context.hpp"
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -30,12 +31,14 @@ thread_local std::vector<ag::debug::NodeCreatedCb> tl_node_created_cbs;
 std::string shape_str(const Tensor& t) {
     auto [r,c] = t.shape();
     std::ostringstream os; os << r << "x" << c;
+    if (t.is_meta()) os << " meta";
     return os.str();
 }
 
 void print_tensor_impl(const Tensor& T) {
-    int R = std::min(T.rows(), g_max_r);
-    int C = std::min(T.cols(), g_max_c);
+    if (T.is_meta()) return; // shape only, nothing to print
+    int R = (int)std::min<int64_t>(T.rows(), g_max_r);
+    int C = (int)std::min<int64_t>(T.cols(), g_max_c);
     std::cout << std::fixed << std::setprecision(g_prec);
     for (int i=0;i<R;++i) {
         for (int j=0;j<C;++j)
@@ -68,14 +71,18 @@ void on_node_created(const std::shared_ptr<Node>& n){
     #if 0
     if (!g_trace) return;
     #endif
-    std::ostringstream label;
-    label << "[" << op_name(n->op) << "]"
-          << (n->requires_grad ? " (grad)" : "      ")
-          << "  value " << shape_str(n->value)
-          << "  @" << n.get();
-    if (n->debug_name && n->debug_name[0] != '\0')
-        label << "  name=\"" << n->debug_name << "\"";
-    print_tensor(label.str(), n->value);
+    // Printing goes through the shared std::cout lock; request threads turn
+    // it off via their ExecutionContext so the op path stays lock-free.
+    if (current_context().log_nodes) {
+        std::ostringstream label;
+        label << "[" << op_name(n->op) << "]"
+              << (n->requires_grad ? " (grad)" : "      ")
+              << "  value " << shape_str(n->value)
+              << "  @" << n.get();
+        if (n->debug_name && n->debug_name[0] != '\0')
+            label << "  name=\"" << n->debug_name << "\"";
+        print_tensor(label.str(), n->value);
+    }
 
         // Invoke the active callback (top of stack) if present.
     if (!tl_node_created_cbs.empty()) {
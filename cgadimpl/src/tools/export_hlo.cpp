@@ -29,10 +29,10 @@ static std::string ty_scalar() {
 static std::string maybe_broadcast(std::ostream& out,
                                    const std::string& vname,
                                    const Tensor& vT,
-                                   int R, int C,
+                                   int64_t R, int64_t C,
                                    int& temp_id)
 {
-    int r=vT.rows(), c=vT.cols();
+    int64_t r=vT.rows(), c=vT.cols();
     if (r==R && c==C) return vname;
 
     // Build broadcast_dimensions for rank-2 sources to rank-2 targets.
@@ -324,7 +324,7 @@ void dump_stablehlo(const Value& root, const std::string& filepath)
             case Op::SoftmaxRow: {
                 Node* Z = n->inputs[0].get();
                 std::string zn = name.count(Z) ? name[Z] : (name[Z]=newv());
-                int B = Z->value.rows(), C = Z->value.cols();
+                int64_t B = Z->value.rows(), C = Z->value.cols();
                 // m = row_max(z)
                 std::string ninf = cst_scalar(-std::numeric_limits<float>::infinity());
                 std::string m = newv();
@@ -369,7 +369,7 @@ void dump_stablehlo(const Value& root, const std::string& filepath)
             case Op::LogSumExpRow: {
                 Node* Z = n->inputs[0].get();
                 std::string zn = name.count(Z) ? name[Z] : (name[Z]=newv());
-                int B = Z->value.rows();
+                int64_t B = Z->value.rows();
                 // m = row_max(z)
                 std::string ninf = cst_scalar(-std::numeric_limits<float>::infinity());
                 std::string m = newv();
@@ -411,7 +411,7 @@ void dump_stablehlo(const Value& root, const std::string& filepath)
                 // CE = -mean( sum( Y * (Z - lse(Z)) , axis=1) )
                 Node* Z = n->inputs[0].get();
                 Node* Y = n->inputs[1].get();
-                int B = Z->value.rows();
+                int64_t B = Z->value.rows();
                 std::string zn = name.count(Z) ? name[Z] : (name[Z]=newv());
                 std::string yn = name.count(Y) ? name[Y] : (name[Y]=newv());
 
@@ -37,9 +37,12 @@ void Tracer::on_node_created(const NodePtr& n) {
     add_if_new(n);
 }
 
+// No lock here: node-created callbacks are thread-local (debug.cpp), so
+// only the thread that called start() ever feeds this tracer. mu_ only
+// guards the query/clear side, which must not overlap an active capture
+// from another thread.
 void Tracer::add_if_new(const NodePtr& n) {
     if (!n) return;
-    std::lock_guard<std::mutex> lk(mu_);
     Node* raw = n.get();
     if (seen_raw_.insert(raw).second) {
         order_.push_back(n);
@@ -61,9 +64,15 @@ std::vector<NodePtr> Tracer::captured_nodes() const {
 void Tracer::mark_output(const NodePtr& n) {
     if (!n) return;
     std::lock_guard<std::mutex> lk(mu_);
+    add_if_new(n);   // not every op reports its node; a marked one must count
     outputs_raw_.insert(n.get());
 }
 
+bool Tracer::has_marked_outputs() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return !outputs_raw_.empty();
+}
+
 std::vector<NodePtr> Tracer::outputs() const {
     std::lock_guard<std::mutex> lk(mu_);
     std::vector<NodePtr> outs;
@@ -0,0 +1,90 @@
+// bench_jit.cpp
+// Eager forward vs. compiled replay of the same MLP + CE loss. The plan's
+// steps are bound to the CPU plugin kernels at compile time, so replay runs
+// the same SIMD kernels as eager but without building nodes, allocating
+// tensors or dispatching on the op per step. Replay should win comfortably.
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+#include "ad/kernels_api.hpp"
+
+using namespace ag;
+using clock_type = std::chrono::steady_clock;
+
+template <class F>
+static double median_ms(int iters, F f) {
+  for (int i = 0; i < 3; ++i) f();
+  std::vector<double> t;
+  for (int i = 0; i < iters; ++i) {
+    auto t0 = clock_type::now();
+    f();
+    t.push_back(std::chrono::duration<double, std::milli>(clock_type::now() - t0).count());
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+int main(int argc, char** argv) {
+  const int iters = (argc > 1) ? std::atoi(argv[1]) : 50;
+  const int B = 32, In = 128, H = 128, Out = 10;
+  ExecutionContext ctx;
+  ctx.log_nodes = false;
+  ContextScope scope(ctx);
+
+  Tensor Xt = Tensor::randn(B, In, 1);
+  Tensor Yt = Tensor::zeros(B, Out);
+  for (int i = 0; i < B; ++i) Yt(i, i % Out) = 1.f;
+  std::vector<Tensor> Pt = {Tensor::randn(In, H, 2) * 0.05f, Tensor::randn(1, H, 3) * 0.05f,
+                            Tensor::randn(H, H, 4) * 0.05f,  Tensor::randn(1, H, 5) * 0.05f,
+                            Tensor::randn(H, Out, 6) * 0.05f, Tensor::randn(1, Out, 7) * 0.05f};
+
+  auto forward = [&](const Value& X, const Value& Y, const std::vector<Value>& p) {
+    Value h1 = gelu(matmul(X, p[0]) + p[1]);
+    Value h2 = silu(matmul(h1, p[2]) + p[3]);
+    return cross_entropy_with_logits(matmul(h2, p[4]) + p[5], Y);
+  };
+  auto leaves = [&](std::vector<Value>& p) {
+    p.clear();
+    for (size_t k = 0; k < Pt.size(); ++k) p.push_back(param(Pt[k], "p"));
+  };
+
+  std::vector<Value> params;
+  leaves(params);
+  Value X = constant(Xt, "X"), Y = constant(Yt, "Y");
+  Value loss = forward(X, Y, params);
+  auto comp = jit::compile(loss, {X, Y}, params);
+  auto st = comp.stats();
+
+  std::vector<Tensor*> in = {&Xt, &Yt}, par;
+  for (auto& t : Pt) par.push_back(&t);
+  Tensor out;
+  [[maybe_unused]] const bool ok = comp.run(in, par, out);
+  assert(ok);
+  const float eager = loss.val()(0, 0);
+
+  float sink = 0.f;
+  double eager_ms = median_ms(iters, [&] {
+    std::vector<Value> p;
+    leaves(p);
+    sink += forward(constant(Xt, "X"), constant(Yt, "Y"), p).val()(0, 0);
+  });
+  double jit_ms = median_ms(iters, [&] { comp.run(in, par, out); sink += out(0, 0); });
+
+  std::printf("plan: %d steps, %d fused groups, %d plugin kernels\n",
+              st.steps, st.fused_groups, st.plugin_kernels);
+  std::printf("loss eager=%.6f compiled=%.6f\n", eager, out(0, 0));
+  std::printf("%-10s %10.3f ms\n%-10s %10.3f ms  (%.2fx)\n", "eager", eager_ms, "compiled", jit_ms,
+              eager_ms / jit_ms);
+
+  assert(std::abs(out(0, 0) - eager) < 1e-3f * std::max(1.f, std::abs(eager)));
+  if (kernels::cpu().matmul) assert(st.plugin_kernels > 0);
+  assert(jit_ms < eager_ms);
+  return std::isfinite(sink) ? 0 : 1;
+}
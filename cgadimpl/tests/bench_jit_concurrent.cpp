@@ -0,0 +1,118 @@
+// bench_jit_concurrent.cpp
+// Many request threads sharing one compiled plan. Each thread owns a
+// jit::Workspace, so runs take no lock and, once warm, never allocate;
+// outputs must match a single-threaded run bit for bit. Throughput is
+// reported for 1..T threads, next to the default run() path (cached
+// workspace, thread-local fallback), which contends on the cache and
+// allocates whenever a thread first falls back. Correctness is checked
+// by test_jit_workspace; this only reports.
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+
+using namespace ag;
+using clock_type = std::chrono::steady_clock;
+
+static std::atomic<long> g_allocs{0};
+void* operator new(std::size_t n) {
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static bool same(const Tensor& a, const Tensor& b) {
+  return a.shape() == b.shape() && std::memcmp(a.data(), b.data(), a.numel() * sizeof(float)) == 0;
+}
+
+struct Result {
+  double runs_per_s;
+  long allocs;
+  bool identical;
+};
+
+// `threads` threads each run `c` `iters` times after a warm-up run;
+// allocations are counted between the start and end barriers.
+static Result hammer(const jit::Compiled& c, int threads, int iters, bool own_ws, std::vector<Tensor*> in,
+                     std::vector<Tensor*> par, const Tensor& ref) {
+  std::atomic<int> ready{0}, finished{0};
+  std::atomic<bool> go{false}, identical{true};
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; ++t)
+    pool.emplace_back([&] {
+      jit::Workspace ws;
+      Tensor out;
+      auto run = [&] { return own_ws ? c.run(ws, in, par, out) : c.run(in, par, out); };
+      [[maybe_unused]] const bool ok = run();
+      assert(ok);
+      ready.fetch_add(1);
+      while (!go.load()) std::this_thread::yield();
+      for (int i = 0; i < iters; ++i) run();
+      finished.fetch_add(1);
+      if (!same(out, ref)) identical = false;
+    });
+  while (ready.load() < threads) std::this_thread::yield();
+  const long a0 = g_allocs.load();
+  const auto t0 = clock_type::now();
+  go = true;
+  while (finished.load() < threads) std::this_thread::yield();
+  const double s = std::chrono::duration<double>(clock_type::now() - t0).count();
+  const long a1 = g_allocs.load();
+  for (auto& th : pool) th.join();
+  return {threads * iters / s, a1 - a0, identical.load()};
+}
+
+int main(int argc, char** argv) {
+  const int iters = (argc > 1) ? std::atoi(argv[1]) : 200;
+  const int hw = int(std::thread::hardware_concurrency());
+  const int max_threads = std::max(2, std::min(hw, 8));
+  ExecutionContext ctx;
+  ctx.log_nodes = false;
+  ContextScope scope(ctx);
+  // Scalar kernels: the plugin's OpenMP loops would oversubscribe cores
+  // once every request thread runs them.
+  ctx.cpu = kernels::Cpu{};
+
+  const int B = 16, In = 64, H = 128, Out = 16;
+  Value X = constant(Tensor::randn(B, In, 1), "X");
+  std::vector<Value> p = {param(Tensor::randn(In, H, 2) * 0.1f, "W1"), param(Tensor::randn(1, H, 3) * 0.1f, "b1"),
+                          param(Tensor::randn(H, Out, 4) * 0.1f, "W2"), param(Tensor::randn(1, Out, 5) * 0.1f, "b2")};
+  Value y = softmax_row(matmul(gelu(matmul(X, p[0]) + p[1]), p[2]) + p[3]);
+  auto c = jit::compile(y, {X}, p);
+
+  Tensor Xt = X.val();
+  std::vector<Tensor> pt;
+  for (auto& v : p) pt.push_back(v.val());
+  std::vector<Tensor*> in = {&Xt}, par;
+  for (auto& t : pt) par.push_back(&t);
+  Tensor ref;
+  [[maybe_unused]] const bool ok = c.run(in, par, ref);
+  assert(ok);
+
+  std::printf("%-8s %16s %16s\n", "threads", "workspace run/s", "default run/s");
+  double one = 0.0, best = 0.0;
+  for (int t = 1; t <= max_threads; t *= 2) {
+    const Result w = hammer(c, t, iters, true, in, par, ref);
+    const Result d = hammer(c, t, iters, false, in, par, ref);
+    std::printf("%-8d %16.0f %16.0f   (allocations: %ld / %ld)%s\n", t, w.runs_per_s, d.runs_per_s, w.allocs,
+                d.allocs, w.identical && d.identical ? "" : "  OUTPUT MISMATCH");
+    if (t == 1) one = w.runs_per_s;
+    best = std::max(best, w.runs_per_s);
+  }
+  std::printf("scaling: %.2fx over one thread (%d hw threads)\n", best / one, hw);
+  return 0;
+}
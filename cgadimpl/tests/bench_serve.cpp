@@ -0,0 +1,108 @@
+// bench_serve.cpp
+// Load generator for jit::Server. Closed-loop clients each send one-row
+// requests back to back; p50/p99 latency and throughput are reported for
+//   batch-1 serial   every request runs alone through a max_batch 1 server
+//   batch-1 threads  every client runs the batch-1 plan itself (own Workspace)
+//   dynamic batching requests coalesce up to max_batch / max_delay
+// How many rows share a batch depends on arrival timing, so it is printed
+// only; test_jit_serve checks coalescing deterministically.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+#include "ad/serve.hpp"
+
+using namespace ag;
+using clock_type = std::chrono::steady_clock;
+
+struct Load {
+    double p50_us, p99_us, per_sec;
+};
+
+// `clients` threads call `request(client)` until `seconds` have passed.
+static Load drive(int clients, double seconds, const std::function<void(int)>& request) {
+    std::vector<std::vector<double>> lat(clients);
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> ts;
+    const auto t0 = clock_type::now();
+    for (int c = 0; c < clients; ++c)
+        ts.emplace_back([&, c] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                const auto a = clock_type::now();
+                request(c);
+                lat[c].push_back(std::chrono::duration<double, std::micro>(clock_type::now() - a).count());
+            }
+        });
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop = true;
+    for (auto& t : ts) t.join();
+    const double wall = std::chrono::duration<double>(clock_type::now() - t0).count();
+    std::vector<double> all;
+    for (auto& l : lat) all.insert(all.end(), l.begin(), l.end());
+    std::sort(all.begin(), all.end());
+    return {all[all.size() / 2], all[all.size() * 99 / 100], double(all.size()) / wall};
+}
+
+static void report(const char* name, const Load& l) {
+    std::printf("  %-18s p50 %8.1f us | p99 %8.1f us | %9.0f req/s\n", name, l.p50_us, l.p99_us, l.per_sec);
+}
+
+int main() {
+    std::printf("===== JIT Server Load Benchmark =====\n");
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    const int In = 256, H = 512, Out = 10, clients = 32;
+    const double seconds = 0.5;
+
+    std::vector<Tensor> params = {Tensor::randn(In, H, 1) * 0.05f, Tensor::zeros(1, H),
+                                  Tensor::randn(H, H, 2) * 0.05f,  Tensor::zeros(1, H),
+                                  Tensor::randn(H, Out, 3) * 0.05f, Tensor::zeros(1, Out)};
+    auto model = [](const std::vector<Value>& in, const std::vector<Value>& p) {
+        Value h = relu(matmul(in[0], p[0]) + p[1]);
+        h = relu(matmul(h, p[2]) + p[3]);
+        return matmul(h, p[4]) + p[5];
+    };
+    std::vector<Tensor> xs;
+    for (int c = 0; c < clients; ++c) xs.push_back(Tensor::randn(1, In, 100 + c));
+
+    std::printf("%d clients, one-row requests, MLP %d-%d-%d-%d\n", clients, In, H, H, Out);
+    {
+        jit::ServerOptions o;
+        o.max_batch = 1;
+        jit::Server srv(model, params, {In}, o);
+        report("batch-1 serial", drive(clients, seconds, [&](int c) { srv.submit(xs[c]).get(); }));
+    }
+    {
+        std::vector<Value> in_v = {constant(xs[0], "x")}, par_v;
+        for (auto& t : params) par_v.push_back(param(t, "p"));
+        jit::Compiled plan = jit::compile(model(in_v, par_v), in_v, par_v);
+        std::vector<Tensor*> pp;
+        for (auto& t : params) pp.push_back(&t);
+        std::vector<jit::Workspace> ws(clients);
+        std::vector<Tensor> out(clients);
+        report("batch-1 threads", drive(clients, seconds, [&](int c) {
+            Tensor* x = &xs[c];
+            plan.run(ws[c], {x}, pp, out[c]);
+        }));
+    }
+    for (int64_t max_batch : {8, 32}) {
+        jit::ServerOptions o;
+        o.max_batch = max_batch;
+        o.max_delay = std::chrono::microseconds(200);
+        jit::Server srv(model, params, {In}, o);
+        char name[32];
+        std::snprintf(name, sizeof name, "dynamic (max %d)", int(max_batch));
+        report(name, drive(clients, seconds, [&](int c) { srv.submit(xs[c]).get(); }));
+        const auto s = srv.stats();
+        std::printf("  %20s %.1f rows/batch, %zu of %zu batches full\n", "",
+                    double(s.rows) / double(s.batches), s.full, s.batches);
+    }
+    return 0;
+}
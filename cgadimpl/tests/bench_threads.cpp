@@ -0,0 +1,59 @@
+// bench_threads.cpp
+// Stress benchmark for per-thread ExecutionContexts: every thread builds and
+// differentiates its own small MLP graph in a loop. With no shared locks on
+// the op path, throughput should scale ~linearly with threads up to the
+// number of cores. Run with OMP_NUM_THREADS=1 so the plugin's own OpenMP
+// teams do not oversubscribe the machine.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+
+using namespace ag;
+
+static void worker(int iters, unsigned seed, std::atomic<long>& done) {
+  ExecutionContext ctx;
+  ctx.log_nodes = false;
+  ContextScope scope(ctx);
+
+  Tensor Xt = Tensor::randn(16, 32, seed);
+  Tensor W1t = Tensor::randn(32, 64, seed + 1);
+  Tensor W2t = Tensor::randn(64, 8, seed + 2);
+  for (int i = 0; i < iters; ++i) {
+    Value x  = constant(Xt, "x");
+    Value W1 = param(W1t, "W1");
+    Value W2 = param(W2t, "W2");
+    Value y  = sum(relu(matmul(relu(matmul(x, W1)), W2)));
+    backward(y);
+  }
+  done.fetch_add(iters, std::memory_order_relaxed);
+}
+
+int main(int argc, char** argv) {
+  const int iters = (argc > 1) ? std::atoi(argv[1]) : 200;
+  unsigned hw = std::thread::hardware_concurrency();
+  if (hw == 0) hw = 1;
+  const unsigned max_threads = (argc > 2) ? (unsigned)std::atoi(argv[2]) : hw;
+  if (!std::getenv("OMP_NUM_THREADS"))
+    std::printf("note: OMP_NUM_THREADS unset; plugin kernels may oversubscribe cores\n");
+
+  std::printf("%8s %14s %12s %10s\n", "threads", "graphs/s", "speedup", "eff");
+  double base = 0.0;
+  for (unsigned t = 1; t <= max_threads; t *= 2) {
+    std::atomic<long> done{0};
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned k = 0; k < t; ++k) pool.emplace_back(worker, iters, 100u + k, std::ref(done));
+    for (auto& th : pool) th.join();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double rate = done.load() / s;
+    if (t == 1) base = rate;
+    std::printf("%8u %14.1f %11.2fx %9.0f%%\n", t, rate, rate / base, 100.0 * rate / (base * t));
+  }
+  return 0;
+}
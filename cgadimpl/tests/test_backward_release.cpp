@@ -0,0 +1,189 @@
+// test_backward_release.cpp
+// backward() frees the values, tapes and gradients of intermediate nodes
+// as soon as it is done with them (unless retain_graph is set). Checks the
+// gradients are unchanged, what is kept (leaves, the root, nodes a handle
+// refers to), and reports live heap bytes through backward and across a
+// training loop that holds the previous graph while building the next.
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+
+using namespace ag;
+
+// ---- live heap bytes (size kept in a header before each block) ----
+static size_t g_live = 0, g_peak = 0;
+static bool g_sample = false;
+static std::vector<size_t>* g_curve = nullptr;   // live bytes at each allocation / free while sampling
+
+static void sample() {
+    if (g_sample && g_curve) {
+        g_sample = false;   // the push_back below allocates too
+        g_curve->push_back(g_live);
+        g_sample = true;
+    }
+}
+
+void* operator new(std::size_t n) {
+    void* p = std::malloc(n + 16);
+    if (!p) throw std::bad_alloc();
+    *static_cast<std::size_t*>(p) = n;
+    g_live += n;
+    g_peak = std::max(g_peak, g_live);
+    sample();
+    return static_cast<char*>(p) + 16;
+}
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    char* b = static_cast<char*>(p) - 16;
+    g_live -= *reinterpret_cast<std::size_t*>(b);
+    std::free(b);
+    sample();
+}
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete[](void* p) noexcept { operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+
+const int B = 128, D = 128, L = 16;
+
+struct Model {
+    std::vector<Value> W, b;
+    Model() {
+        for (int l = 0; l < L; ++l) {
+            W.push_back(param(Tensor::randn(D, D, 10 + l) * (1.f / std::sqrt(float(D))), "W"));
+            b.push_back(param(Tensor::randn(1, D, 50 + l) * 0.1f, "b"));
+        }
+    }
+    // Returns the loss; *mid (if given) receives the output of layer L/2.
+    Value operator()(const Tensor& x, Value* mid = nullptr) const {
+        Value h = constant(x, "x");
+        for (int l = 0; l < L; ++l) {
+            h = tanh(matmul(h, W[l]) + b[l]);
+            if (mid && l == L / 2) *mid = h;
+        }
+        return sum(h * h);
+    }
+    std::vector<Tensor> grads() const {
+        std::vector<Tensor> g;
+        for (int l = 0; l < L; ++l) g.push_back(W[l].node->grad * 1.f), g.push_back(b[l].node->grad * 1.f);
+        return g;
+    }
+    void zero() const {
+        for (int l = 0; l < L; ++l) W[l].node->grad = Tensor::zeros(D, D), b[l].node->grad = Tensor::zeros(1, D);
+    }
+};
+
+static float max_diff(const std::vector<Tensor>& a, const std::vector<Tensor>& c) {
+    float d = 0.f;
+    for (size_t k = 0; k < a.size(); ++k)
+        for (size_t i = 0; i < a[k].numel(); ++i) d = std::max(d, std::abs(a[k].data()[i] - c[k].data()[i]));
+    return d;
+}
+
+static double mb(size_t b) { return double(b) / (1024.0 * 1024.0); }
+
+int main() {
+    std::printf("===== Backward Release Test =====\n");
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    Model m;
+    const Tensor x = Tensor::randn(B, D, 1);
+
+    // 1) Same gradients either way; what is kept.
+    std::vector<Tensor> g_keep, g_free;
+    {
+        m.zero();
+        Value loss = m(x);
+        backward(loss, nullptr, /*retain_graph=*/true);
+        g_keep = m.grads();
+    }
+    {
+        m.zero();
+        Value mid;
+        Value loss = m(x, &mid);
+        Node* pre = loss.node->inputs[0].get();   // h * h: no handle
+        backward(loss);
+        g_free = m.grads();
+        assert(pre->value.numel() == 0 && pre->grad.numel() == 0);
+        assert(loss.val().numel() == 1);                              // root is held
+        assert(mid.val().numel() == size_t(B * D) && mid.node->grad.numel() == size_t(B * D));
+        assert(m.W[0].val().numel() == size_t(D * D));                // leaves keep values
+        bool threw = false;                                           // released graph
+        try { backward(loss); } catch (const std::runtime_error& e) {
+            threw = std::string(e.what()).find("retain_graph") != std::string::npos;
+        }
+        assert(threw);
+    }
+    assert(max_diff(g_keep, g_free) == 0.f);
+
+    // With retain_graph the same graph can be differentiated again.
+    {
+        m.zero();
+        Value loss = m(x);
+        backward(loss, nullptr, true);
+        zero_grad(loss);
+        backward(loss);
+        assert(max_diff(m.grads(), g_keep) == 0.f);
+    }
+    std::printf("[grads] identical with and without retain_graph\n");
+
+    // 2) Live bytes through one backward, and across a training loop in
+    //    which `loss` still holds the last step's graph while the next
+    //    forward runs.
+    for (int retain = 1; retain >= 0; --retain) {
+        std::vector<size_t> curve;
+        curve.reserve(1 << 16);
+        size_t start, end;
+        {
+            m.zero();
+            Value loss = m(x);
+            start = g_live;
+            g_curve = &curve;
+            g_sample = true;
+            backward(loss, nullptr, retain);
+            g_sample = false;
+            g_curve = nullptr;
+            end = g_live;
+        }
+        auto at = [&](double f) { return curve.empty() ? 0 : curve[size_t(f * double(curve.size() - 1))]; };
+        std::printf("[%s] backward: start %.2f MB | 25%% %.2f | 50%% %.2f | 75%% %.2f | end %.2f MB\n",
+                    retain ? "retain " : "release", mb(start), mb(at(0.25)), mb(at(0.5)), mb(at(0.75)), mb(end));
+
+        const size_t base = g_live;
+        g_peak = g_live;
+        {
+            Value loss;
+            for (int step = 0; step < 3; ++step) {
+                m.zero();
+                loss = m(x);   // the previous graph is freed only here
+                backward(loss, nullptr, retain);
+            }
+        }
+        const size_t loop_peak = g_peak - base;
+        std::printf("[%s] training loop peak %.2f MB above baseline\n", retain ? "retain " : "release", mb(loop_peak));
+
+        // What the graph still held after backward, over the baseline.
+        const size_t held = end - base;
+        static size_t keep_held, keep_loop;
+        if (retain) {
+            keep_held = held;
+            keep_loop = loop_peak;
+        } else {
+            assert(at(0.5) < start && held * 4 < keep_held);
+            assert(loop_peak * 4 < keep_loop * 3);
+        }
+    }
+
+    std::printf("✅ Backward release test passed.\n");
+    return 0;
+}
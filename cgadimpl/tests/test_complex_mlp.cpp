@@ -14,8 +14,8 @@ static void print_tensor(const std::string& label,
                          int max_r = 6, int max_c = 8,
                          int width = 10, int precision = 4) {
     std::cout << label << " [" << T.rows() << "x" << T.cols() << "]\n";
-    const int R = std::min(T.rows(), max_r);
-    const int C = std::min(T.cols(), max_c);
+    const int R = (int)std::min<int64_t>(T.rows(), max_r);
+    const int C = (int)std::min<int64_t>(T.cols(), max_c);
     for (int i = 0; i < R; ++i) {
         for (int j = 0; j < C; ++j) {
             std::cout << std::setw(width) << std::fixed
@@ -0,0 +1,203 @@
+// test_gemm.cpp
+// kernels::gemm (C = alpha * op(A) @ op(B) + beta * C) for every transpose
+// pair, with strided operands and sizes crossing the plugin's packing
+// blocks, against a scalar reference, through the plugin's gemm and the
+// portable loop. Then the matmul / fmab / linear VJPs, which accumulate
+// into the parents' grads through it, against the explicit
+// transpose-and-add formulas. Timings: the four transpose pairs, one
+// matmul VJP, and attention's q @ k^T with and without a transposed copy.
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
+
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+#include "ad/detail/autodiff_ops.hpp"
+#include "ad/kernels_api.hpp"
+
+using namespace ag;
+
+static float max_abs_diff(const Tensor& a, const Tensor& b) {
+    assert(a.shape() == b.shape());
+    float m = 0.f;
+    for (size_t i = 0; i < a.numel(); ++i) m = std::max(m, std::abs(a.data()[i] - b.data()[i]));
+    return m;
+}
+
+// op(X)(i, k) of a row-major matrix with row stride ld.
+static float at(const std::vector<float>& X, int64_t ld, bool trans, int64_t i, int64_t k) {
+    return trans ? X[size_t(k * ld + i)] : X[size_t(i * ld + k)];
+}
+
+static bool check_gemm(const char* what, int64_t M, int64_t N, int64_t K) {
+    const int64_t pad = 3;
+    for (int ta = 0; ta < 2; ++ta)
+        for (int tb = 0; tb < 2; ++tb)
+            for (float beta : {0.f, 1.f, -2.f}) {
+                const float alpha = 0.5f;
+                const int64_t ar = ta ? K : M, ac = ta ? M : K, lda = ac + pad;
+                const int64_t br = tb ? N : K, bc = tb ? K : N, ldb = bc + pad;
+                const int64_t ldc = N + pad;
+                const Tensor a = Tensor::randn(ar, lda, 1), b = Tensor::randn(br, ldb, 2), c0 = Tensor::randn(M, ldc, 3);
+                std::vector<float> A(a.data(), a.data() + a.numel()), B(b.data(), b.data() + b.numel());
+                std::vector<float> C(c0.data(), c0.data() + c0.numel()), R = C;
+                if (beta == 0.f)   // must not be read
+                    for (int64_t i = 0; i < M; ++i) C[size_t(i * ldc)] = std::numeric_limits<float>::quiet_NaN();
+
+                for (int64_t i = 0; i < M; ++i)
+                    for (int64_t j = 0; j < N; ++j) {
+                        double s = 0.0;
+                        for (int64_t k = 0; k < K; ++k) s += double(at(A, lda, ta, i, k)) * at(B, ldb, tb, k, j);
+                        float& r = R[size_t(i * ldc + j)];
+                        r = float(alpha * s + (beta == 0.f ? 0.0 : double(beta) * r));
+                    }
+                kernels::gemm(ta, tb, M, N, K, alpha, A.data(), lda, B.data(), ldb, beta, C.data(), ldc);
+                for (int64_t i = 0; i < M; ++i)
+                    for (int64_t j = 0; j < ldc; ++j) {
+                        const float got = C[size_t(i * ldc + j)], want = R[size_t(i * ldc + j)];
+                        const bool pad_col = j >= N;   // outside C: untouched
+                        if (pad_col ? got != c0.data()[i * ldc + j] : !(std::abs(got - want) < 1e-4f * (1.f + std::abs(want)))) {
+                            std::fprintf(stderr, "%s: gemm %c%c %dx%dx%d beta %g wrong at (%d,%d): %g vs %g\n", what,
+                                         ta ? 'T' : 'N', tb ? 'T' : 'N', int(M), int(N), int(K), beta,
+                                         int(i), int(j), got, want);
+                            return false;
+                        }
+                    }
+            }
+    std::printf("[gemm] %s %dx%dx%d: NN/NT/TN/TT, alpha/beta, strides ok\n", what, int(M), int(N), int(K));
+    return true;
+}
+
+static bool check_gemm(const char* what) {
+    // Small, then past the plugin's MC (96) / KC (256) / NC (2048) blocks.
+    return check_gemm(what, 13, 21, 17) && check_gemm(what, 100, 37, 300) && check_gemm(what, 7, 2100, 9);
+}
+
+// Grads of sum(y * r) for the parameters, accumulated onto `seed` grads.
+static std::vector<Tensor> grads(const Value& y, const std::vector<Value>& ps, const Tensor& r) {
+    Value loss = sum(y * constant(r, "r"));
+    zero_grad(loss);
+    for (auto& p : ps) p.node->grad = p.val() * 0.25f;   // accumulated onto
+    backward(loss);
+    std::vector<Tensor> g;
+    for (auto& p : ps) g.push_back(p.node->grad * 1.f);
+    return g;
+}
+
+static bool check_vjps(const char* what) {
+    const int B = 9, In = 11, Out = 7;
+    Value x = param(Tensor::randn(B, In, 4), "x");
+    Value w = param(Tensor::randn(In, Out, 5), "w");
+    Value wt = param(Tensor::randn(Out, In, 6), "wt");   // [Out, In] for linear
+    Value c = param(Tensor::randn(1, Out, 7), "c");
+    const Tensor r = Tensor::randn(B, Out, 8);
+
+    // Expected: the formulas with explicit transposes, plus the seed.
+    const Tensor X = x.val(), Wv = w.val(), Wt = wt.val();
+    auto gx = [&](const Tensor& W_kn) { return Tensor::matmul(r, Tensor::transpose(W_kn)) + X * 0.25f; };
+    const Tensor gw  = Tensor::matmul(Tensor::transpose(X), r) + Wv * 0.25f;
+    const Tensor gwt = Tensor::matmul(Tensor::transpose(r), X) + Wt * 0.25f;
+    const Tensor gc  = Tensor::reduce_to(r, c.val()) + c.val() * 0.25f;
+
+    float d = 0.f;
+    auto g = grads(matmul(x, w), {x, w}, r);
+    d = std::max({d, max_abs_diff(g[0], gx(Wv)), max_abs_diff(g[1], gw)});
+    g = grads(fmab(x, w, c), {x, w, c}, r);
+    d = std::max({d, max_abs_diff(g[0], gx(Wv)), max_abs_diff(g[1], gw), max_abs_diff(g[2], gc)});
+    g = grads(linear(x, wt, c), {x, wt, c}, r);
+    d = std::max({d, max_abs_diff(g[0], gx(Tensor::transpose(Wt))), max_abs_diff(g[1], gwt), max_abs_diff(g[2], gc)});
+    if (d > 1e-4f) {
+        std::fprintf(stderr, "%s: matmul/fmab/linear VJP diff %g\n", what, d);
+        return false;
+    }
+    std::printf("[vjp]  %s: matmul, fmab, linear accumulate correctly\n", what);
+    return true;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// One matmul VJP through gemm vs the product-transpose-add it replaced.
+static void time_vjp(const char* what, int n, int reps) {
+    Value a = param(Tensor::randn(n, n, 1), "a"), b = param(Tensor::randn(n, n, 2), "b");
+    const Tensor gy = Tensor::randn(n, n, 3);
+    Value y = matmul(a, b);
+    VjpFn vjp = vjp_lookup(Op::MatMul);
+    double t_new = 1e30, t_old = 1e30;
+    for (int k = 0; k < reps; ++k) {
+        auto t0 = std::chrono::steady_clock::now();
+        vjp(y.node.get(), gy);
+        t_new = std::min(t_new, ms_since(t0));
+        t0 = std::chrono::steady_clock::now();
+        a.node->grad.add_(Tensor::matmul(gy, Tensor::transpose(b.val())));
+        b.node->grad.add_(Tensor::matmul(Tensor::transpose(a.val()), gy));
+        t_old = std::min(t_old, ms_since(t0));
+    }
+    std::printf("[time] %s %dx%d matmul VJP: gemm into grads %.2f ms | matmul + transpose + add_ %.2f ms\n",
+                what, n, n, t_new, t_old);
+}
+
+static void time_pairs(const char* what, int64_t n, int reps) {
+    const Tensor a = Tensor::randn(n, n, 1), b = Tensor::randn(n, n, 2);
+    Tensor c(n, n);
+    const char* names[] = {"NN", "NT", "TN", "TT"};
+    std::printf("[time] %s %dx%dx%d GFLOP/s:", what, int(n), int(n), int(n));
+    for (int t = 0; t < 4; ++t) {
+        double best = 1e30;
+        for (int k = 0; k < reps; ++k) {
+            const auto t0 = std::chrono::steady_clock::now();
+            kernels::gemm(t & 2, t & 1, n, n, n, 1.f, a.data(), n, b.data(), n, 0.f, c.data(), n);
+            best = std::min(best, ms_since(t0));
+        }
+        std::printf("  %s %.1f", names[t], 2.0 * n * n * n / (best * 1e6));
+    }
+    std::printf("\n");
+}
+
+// Attention scores q @ k^T * scale: read in place vs transposed copy.
+static void time_scores(int64_t T, int64_t d, int reps) {
+    const Tensor q = Tensor::randn(T, d, 1), k = Tensor::randn(T, d, 2);
+    const float scale = 1.f / std::sqrt(float(d));
+    double t_new = 1e30, t_old = 1e30;
+    Tensor s_new, s_old;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        s_new = Tensor::matmul(q, k, false, true, scale);
+        t_new = std::min(t_new, ms_since(t0));
+        t0 = std::chrono::steady_clock::now();
+        s_old = Tensor::matmul(q, Tensor::transpose(k) * scale);
+        t_old = std::min(t_old, ms_since(t0));
+    }
+    assert(max_abs_diff(s_new, s_old) < 1e-3f);
+    std::printf("[time] q @ k^T (T=%d, d=%d): in place %.2f ms | transpose copy + matmul %.2f ms\n",
+                int(T), int(d), t_new, t_old);
+}
+
+int main() {
+    std::printf("===== GEMM Test =====\n");
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+
+    const bool plugin = kernels::cpu().gemm != nullptr;
+    if (plugin) {
+        if (!check_gemm("plugin") || !check_vjps("plugin")) return 1;
+        time_vjp("plugin", 256, 3);
+        time_pairs("plugin", 512, 3);
+        time_scores(512, 64, 3);
+    } else {
+        std::printf("(no CPU plugin with gemm loaded)\n");
+    }
+    ctx.cpu = kernels::Cpu{};
+    if (!check_gemm("portable") || !check_vjps("portable")) return 1;
+    time_vjp("portable", 256, 3);
+    time_pairs("portable", 256, 2);
+
+    std::printf("✅ GEMM test passed.\n");
+    return 0;
+}
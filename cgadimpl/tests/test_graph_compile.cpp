@@ -74,7 +74,7 @@ int main() {
     Value loss = cross_entropy_with_logits(logits, Y); // scalar [1,1]
     // print_value("Y (one-hot)", Y);
     // print_value("loss", loss);
-    backward(loss); // eager backward to populate grads for sanity check
+    backward(loss, nullptr, /*retain_graph=*/true); // eager backward to populate grads for sanity check; compiled below
     // ---------- Backprop ----------
 
     // Tell the compiler which leaves will be passed in at runtime:
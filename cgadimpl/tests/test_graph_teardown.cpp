@@ -0,0 +1,75 @@
+#include <iostream>
+#include <chrono>
+#include <cassert>
+#include <cmath>
+#include "ad/ag_all.hpp"
+#include "ad/careful_deletion.hpp"
+
+using namespace ag;
+
+// Builds a straight chain x_{i+1} = x_i + c of `depth` nodes.
+// The recursive ~Node used to overflow the stack well below 1e6.
+static Value build_chain(int depth) {
+    Value c = constant(Tensor::ones(1, 1), "c");
+    Value x = param(Tensor::ones(1, 1), "x");
+    for (int i = 0; i < depth; ++i) x = add(x, c);
+    return x;
+}
+
+static double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+int main() {
+    std::cout << "===== Graph Teardown Test =====\n";
+    const int depth = 1000000;
+
+    // 1) Inline (iterative) teardown.
+    {
+        Value y = build_chain(depth);
+        assert(std::abs(y.val()(0, 0) - (depth + 1)) < 1.0f);
+        auto order = topo_from(y.node.get()); // iterative too
+        assert(order.size() == size_t(depth) + 2);
+
+        size_t before = memory::reclaimed_node_count();
+        auto t0 = std::chrono::steady_clock::now();
+        y = Value();
+        double ms = ms_since(t0);
+        size_t freed = memory::reclaimed_node_count() - before;
+        std::cout << "[inline] freed " << freed << " nodes in " << ms << " ms\n";
+        assert(freed >= size_t(depth));
+    }
+
+    // 2) Background reclaim: release returns immediately, flush waits.
+    {
+        memory::set_background_reclaim(true);
+        memory::set_reclaim_batch_size(1024);
+        Value y = build_chain(depth);
+
+        size_t before = memory::reclaimed_node_count();
+        auto t0 = std::chrono::steady_clock::now();
+        y = Value();
+        double release_ms = ms_since(t0);
+        memory::flush_reclaim();
+        double total_ms = ms_since(t0);
+        size_t freed = memory::reclaimed_node_count() - before;
+        std::cout << "[background] release " << release_ms << " ms, drained "
+                  << freed << " nodes after " << total_ms << " ms\n";
+        assert(freed >= size_t(depth));
+        memory::set_background_reclaim(false);
+    }
+
+    // 3) Shared parents must survive while still referenced.
+    {
+        Value a = param(Tensor::ones(2, 2), "a");
+        Value b = relu(a);
+        {
+            Value c = add(b, b);
+            Value d = add(c, a);
+        }
+        assert(b.node && b.node->inputs.size() == 1 && b.node->inputs[0] == a.node);
+    }
+
+    std::cout << "✅ Graph teardown test passed.\n";
+    return 0;
+}
@@ -140,7 +140,7 @@ void test_combined_system() {
     Value y = sum(mul(relu(z), relu(z)));
 
     zero_grad(y);
-    backward(y);
+    backward(y, nullptr, /*retain_graph=*/true);   // y is backpropagated again below
 
     Tensor grad_a1 = a.grad(), grad_b1 = b.grad(), grad_c1 = c.grad();
 
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+
+using namespace ag;
+using clock_type = std::chrono::steady_clock;
+
+// Largest difference relative to max(1, |b|).
+static float rel_diff(const Tensor& a, const Tensor& b) {
+    assert(a.shape() == b.shape());
+    float m = 0.f;
+    for (int64_t i = 0; i < a.rows(); ++i)
+        for (int64_t j = 0; j < a.cols(); ++j)
+            m = std::max(m, std::abs(a(i, j) - b(i, j)) / std::max(1.f, std::abs(b(i, j))));
+    return m;
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream f(path);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    return ss.str();
+}
+
+static void remove_model(const std::string& stem) {
+    std::remove((stem + ".cpp").c_str());
+    std::remove((stem + ".so").c_str());
+}
+
+struct Ptrs {
+    std::vector<Tensor> t;
+    std::vector<Tensor*> p;
+    explicit Ptrs(const std::vector<Value>& vs) {
+        for (auto& v : vs) t.push_back(v.val());
+        for (auto& x : t) p.push_back(&x);
+    }
+};
+
+// Builds `c` ahead of time and checks the AOT model against the
+// interpreter (output and, when compiled with them, gradients).
+static jit::Compiled check(const char* stem, const jit::Compiled& c, const std::vector<Value>& inputs,
+                           const std::vector<Value>& params, bool grads, float tol = 1e-6f) {
+    auto a = c.build_aot(stem);
+    Ptrs in(inputs), par(params);
+    std::vector<Tensor> g1(params.size()), g2(params.size());
+    std::vector<Tensor*> gp1, gp2;
+    for (size_t k = 0; k < params.size(); ++k) { gp1.push_back(&g1[k]); gp2.push_back(&g2[k]); }
+    Tensor o1, o2;
+    [[maybe_unused]] bool ok = grads ? c.run(in.p, par.p, o1, gp1) : c.run(in.p, par.p, o1);
+    ok = (grads ? a.run(in.p, par.p, o2, gp2) : a.run(in.p, par.p, o2)) && ok;
+    assert(ok);
+    float d = rel_diff(o2, o1);
+    for (size_t k = 0; grads && k < params.size(); ++k) d = std::max(d, rel_diff(g2[k], g1[k]));
+    const std::string src = read_file(std::string(stem) + ".cpp");
+    size_t calls = 0;
+    for (size_t at = src.find("step(ctx"); at != std::string::npos; at = src.find("step(ctx", at + 1)) ++calls;
+    std::cout << "[" << stem << "] " << c.stats().steps << " steps, " << calls
+              << " left to the interpreter | max rel diff " << d << std::endl;
+    assert(d < tol);
+    if (!grads) assert(calls == 0);
+    return a;
+}
+
+template <class F>
+static double median_us(int iters, F f) {
+    for (int i = 0; i < 10; ++i) f();
+    std::vector<double> t;
+    for (int i = 0; i < iters; ++i) {
+        auto t0 = clock_type::now();
+        f();
+        t.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - t0).count());
+    }
+    std::sort(t.begin(), t.end());
+    return t[t.size() / 2];
+}
+
+int main() {
+    std::cout << "===== JIT Ahead-of-Time Codegen Test =====\n";
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    const float s = 0.2f;
+
+    // 1) MLP forward: matmuls, broadcast bias + activation chains, softmax.
+    const int B = 8, In = 12, H = 16, Out = 6;
+    Value X = constant(Tensor::randn(B, In, 1), "X");
+    std::vector<Value> p = {param(Tensor::randn(In, H, 2) * s, "W1"), param(Tensor::randn(1, H, 3) * s, "b1"),
+                            param(Tensor::randn(H, Out, 4) * s, "W2"), param(Tensor::randn(B, 1, 5) * s, "c")};
+    Value h = leaky_relu(gelu(matmul(X, p[0]) + p[1]), 0.1f);
+    Value mlp = softmax_row(matmul(h, p[2]) - p[3]);
+    // Fused plugin activations (GELU's rational tanh) are approximations;
+    // generated loops evaluate the exact formula.
+    check("aot_mlp", jit::compile(mlp, {X}, p), {X}, p, false, 5e-3f);
+
+    // From here on, without the plugin: interpreter and generated code
+    // then evaluate the same formulas in the same order.
+    ctx.cpu = kernels::Cpu{};
+    check("aot_mlp_scalar", jit::compile(mlp, {X}, p), {X}, p, false);
+
+    // 2) Every fused reduction tail, plus unfused (plain) reductions.
+    {
+        Tensor Yt = Tensor::zeros(B, H);
+        for (int i = 0; i < B; ++i) Yt(i, (3 * i) % H) = 1.f;
+        Value Y = constant(Yt, "Y");
+        Value t = sigmoid(X * X) * 0.5f;   // [B, In]
+        Value z = silu(matmul(X, p[0]) * p[1]);
+        Value y = sum(tanh(t)) + mean_all(exp(t)) + sum(rowsum(softplus(t))) + sum(rowmax(relu(t + -0.1f)))
+                + mean_all(logsumexp_row(log(t + 1.f))) + cross_entropy_with_logits(z + 0.f, Y)
+                + sum(softmax_row(z * 2.f) * z);
+        check("aot_tails", jit::compile(y, {X}, p), {X}, p, false);
+        jit::CompileOptions o;
+        o.fuse_elementwise = false;
+        check("aot_plain", jit::compile(y, {X}, p, o), {X}, p, false);
+    }
+
+    // 3) Forward + backward: gradients match; backward steps call back.
+    {
+        Tensor Yt = Tensor::zeros(B, Out);
+        for (int i = 0; i < B; ++i) Yt(i, i % Out) = 1.f;
+        Value Y = constant(Yt, "Y");
+        Value loss = cross_entropy_with_logits(matmul(h, p[2]) + p[3], Y);
+        jit::CompileOptions o;
+        o.with_grads = true;
+        check("aot_grad", jit::compile(loss, {X, Y}, p, o), {X, Y}, p, true);
+    }
+
+    // 4) A tiny fixed-shape model, where interpreter overhead dominates.
+    {
+        Value x = constant(Tensor::randn(4, 8, 6), "x");
+        Value w = param(Tensor::randn(8, 8, 7) * s, "w"), b = param(Tensor::randn(1, 8, 8) * s, "b");
+        Value y = x;
+        for (int l = 0; l < 6; ++l) y = tanh(matmul(y, w) + b);
+        auto c = jit::compile(sum(y), {x}, {w, b});
+        auto a = check("aot_tiny", c, {x}, {w, b}, false);
+        Ptrs in({x}), par({w, b});
+        Tensor out;
+        const double ti = median_us(2000, [&] { c.run(in.p, par.p, out); });
+        const double ta = median_us(2000, [&] { a.run(in.p, par.p, out); });
+        std::printf("tiny model: interpreter %.2f us, aot %.2f us (%.2fx)\n", ti, ta, ti / ta);
+        assert(ta < ti);
+
+        // The model belongs to its plan.
+        bool threw = false;
+        try { jit::compile(mlp, {X}, p).load_aot("./aot_tiny.so"); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+
+        // Paths reach the compiler as arguments, never through a shell;
+        // a compiler that cannot be run is an error.
+        check("aot_it's $(tiny)", c, {x}, {w, b}, false);
+        threw = false;
+        try { c.build_aot("aot_nocc", "./no-such-compiler"); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+    }
+
+    for (const char* stem : {"aot_mlp", "aot_mlp_scalar", "aot_tails", "aot_plain", "aot_grad", "aot_tiny",
+                             "aot_it's $(tiny)", "aot_nocc"})
+        remove_model(stem);
+    std::cout << "✅ JIT ahead-of-time codegen test passed.\n";
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+#include "test_util.hpp"
+
+using namespace ag;
+
+int main() {
+    std::cout << "===== JIT Plan Cache Test =====\n";
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    const int In = 12, H = 16, Out = 5;
+
+    // Per-sample classifier: row i of the output only reads row i of X.
+    Tensor W1 = Tensor::randn(In, H, 1) * 0.2f, b1 = Tensor::randn(1, H, 2) * 0.2f;
+    Tensor W2 = Tensor::randn(H, Out, 3) * 0.2f, b2 = Tensor::randn(1, Out, 4) * 0.2f;
+    auto model = [](const std::vector<Value>& in, const std::vector<Value>& p) {
+        return softmax_row(matmul(gelu(matmul(in[0], p[0]) + p[1]), p[2]) + p[3]);
+    };
+    std::vector<Tensor*> par = {&W1, &b1, &W2, &b2};
+    auto eager = [&](const Tensor& X) {
+        return model({constant(X, "X")}, {param(W1, "W1"), param(b1, "b1"), param(W2, "W2"), param(b2, "b2")}).val();
+    };
+    const std::vector<int64_t> batches = {3, 4, 5, 7, 8, 12, 16, 3, 6, 9};
+
+    // 1) Exact shapes: one plan per distinct batch, bounded by capacity.
+    {
+        jit::CacheOptions o;
+        o.capacity = 4;
+        jit::PlanCache cache(model, o);
+        for (int64_t n : batches) {
+            Tensor X = Tensor::randn(n, In, 10 + unsigned(n)), out;
+            [[maybe_unused]] const bool ok = cache.run({&X}, par, out);
+            assert(ok);
+            assert(out.shape() == std::make_pair(n, int64_t(Out)));
+            assert(max_abs_diff(out, eager(X)) < 1e-5f);
+        }
+        auto s = cache.stats();
+        std::cout << "exact:  " << s.misses << " compiles, " << s.hits << " hits, " << s.evictions
+                  << " evictions, " << s.plans << " plans\n";
+        // 3 was evicted by the time it came back (capacity 4).
+        assert(s.misses == 10 && s.hits == 0 && s.plans == 4 && s.evictions == 6);
+    }
+
+    // 2) Power-of-two buckets: 3,4 -> 4; 5..8 -> 8; 9..16 -> 16.
+    {
+        jit::CacheOptions o;
+        o.pad_batch = true;
+        jit::PlanCache cache(model, o);
+        assert(cache.bucket(1) == 1 && cache.bucket(5) == 8 && cache.bucket(16) == 16);
+        Tensor out;
+        for (int64_t n : batches) {
+            Tensor X = Tensor::randn(n, In, 30 + unsigned(n));
+            [[maybe_unused]] const bool ok = cache.run({&X}, par, out);
+            assert(ok);
+            assert(out.shape() == std::make_pair(n, int64_t(Out)));
+            assert(max_abs_diff(out, eager(X)) < 1e-5f);
+        }
+        auto s = cache.stats();
+        std::cout << "pow2:   " << s.misses << " compiles, " << s.hits << " hits, " << s.plans << " plans\n";
+        assert(s.misses == 3 && s.hits == 7 && s.evictions == 0);
+    }
+
+    // 3) Configured buckets; beyond the last one the exact size is used.
+    {
+        jit::CacheOptions o;
+        o.pad_batch = true;
+        o.buckets = {6, 12};
+        jit::PlanCache cache(model, o);
+        assert(cache.bucket(5) == 6 && cache.bucket(7) == 12 && cache.bucket(16) == 16);
+        Tensor out;
+        for (int64_t n : batches) {
+            Tensor X = Tensor::randn(n, In, 50 + unsigned(n));
+            [[maybe_unused]] const bool ok = cache.run({&X}, par, out);
+            assert(ok);
+            assert(max_abs_diff(out, eager(X)) < 1e-5f);
+        }
+        auto s = cache.stats();
+        std::cout << "custom: " << s.misses << " compiles, " << s.hits << " hits\n";
+        assert(s.misses == 3);   // 6, 12, 16
+    }
+
+    // 4) Training with a varying batch: gradients use exact shapes.
+    {
+        auto loss_of = [](const std::vector<Value>& in, const std::vector<Value>& p) {
+            return cross_entropy_with_logits(matmul(relu(matmul(in[0], p[0]) + p[1]), p[2]) + p[3], in[1]);
+        };
+        jit::CacheOptions o;
+        o.pad_batch = true;
+        o.compile.with_grads = true;
+        jit::PlanCache cache(loss_of, o);
+        std::vector<Tensor> g(par.size());
+        std::vector<Tensor*> gp;
+        for (auto& t : g) gp.push_back(&t);
+        for (int64_t n : {6, 7, 6}) {
+            Tensor X = Tensor::randn(n, In, 70 + unsigned(n)), Y = Tensor::zeros(n, Out), out;
+            for (int64_t i = 0; i < n; ++i) Y(i, i % Out) = 1.f;
+            [[maybe_unused]] const bool ok = cache.run({&X, &Y}, par, out, gp);
+            assert(ok);
+
+            std::vector<Value> p = {param(W1, "W1"), param(b1, "b1"), param(W2, "W2"), param(b2, "b2")};
+            Value l = loss_of({constant(X, "X"), constant(Y, "Y")}, p);
+            backward(l);
+            float d = max_abs_diff(out, l.val());
+            for (size_t k = 0; k < p.size(); ++k) d = std::max(d, max_abs_diff(g[k], p[k].node->grad));
+            assert(d < 1e-4f);
+        }
+        assert(cache.stats().misses == 2 && cache.stats().hits == 1);
+
+        // A forward run would pad the batch into the scalar loss: refused.
+        Tensor X = Tensor::randn(6, In, 90), Y = Tensor::zeros(6, Out), out;
+        bool threw = false;
+        try { cache.run({&X, &Y}, par, out); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+    }
+
+    std::cout << "✅ JIT plan cache test passed.\n";
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "test_util.hpp"
+
+using namespace ag;
+
+static Tensor one_hot(int B, int C) {
+    Tensor Y = Tensor::zeros(B, C);
+    for (int i = 0; i < B; ++i) Y(i, (i * 7) % C) = 1.f;
+    return Y;
+}
+
+// Compiles `out` fused and unfused, checks both agree with each other and
+// with eager, and returns the fused stats. GEMM epilogue fusion is off in
+// both, so bias/activation chains are left to elementwise fusion.
+static jit::PlanStats check(const char* name, const Value& out,
+                            const std::vector<Value>& inputs, const std::vector<Value>& params) {
+    jit::CompileOptions on, off{false, true, false};
+    on.fuse_linear = off.fuse_linear = false;
+    auto fused = jit::compile(out, inputs, params, on);
+    auto plain = jit::compile(out, inputs, params, off);
+
+    std::vector<Tensor> in_t, par_t;
+    for (auto& v : inputs) in_t.push_back(v.val());
+    for (auto& v : params) par_t.push_back(v.val());
+    std::vector<Tensor*> in_p, par_p;
+    for (auto& t : in_t) in_p.push_back(&t);
+    for (auto& t : par_t) par_p.push_back(&t);
+
+    Tensor a, b;
+    [[maybe_unused]] bool ok = fused.run(in_p, par_p, a);
+    assert(ok);
+    ok = plain.run(in_p, par_p, b);
+    assert(ok);
+
+    auto fs = fused.stats(), ps = plain.stats();
+    const float d_plain = max_abs_diff(a, b), d_eager = max_abs_diff(a, out.val());
+    std::cout << "[" << name << "] steps " << ps.steps << " -> " << fs.steps
+              << " (" << fs.fused_groups << " groups of " << fs.fused_steps << " ops)"
+              << " | bytes moved " << ps.bytes_moved << " -> " << fs.bytes_moved
+              << " | arena " << ps.arena_bytes << " -> " << fs.arena_bytes
+              << " | |fused-unfused|=" << d_plain << " |fused-eager|=" << d_eager << std::endl;
+    assert(d_plain < 1e-5f);
+    assert(d_eager < 1e-3f);
+    assert(fs.fused_groups > 0 && fs.steps < ps.steps);
+    assert(fs.bytes_moved < ps.bytes_moved);
+    return fs;
+}
+
+int main() {
+    std::cout << "===== JIT Elementwise Fusion Test =====\n";
+    const float s = 0.1f;
+
+    // 1) MLP + CE: bias/activation chains after each matmul, and the
+    //    bias add of the last layer folds into the CE reduction.
+    {
+        const int B = 32, In = 64, H = 128, Out = 10;
+        Value X  = constant(Tensor::randn(B, In, 1), "X");
+        Value Y  = constant(one_hot(B, Out), "Y");
+        Value W1 = param(Tensor::randn(In, H, 2) * s, "W1"), b1 = param(Tensor::randn(1, H, 3) * s, "b1");
+        Value W2 = param(Tensor::randn(H, H, 4) * s, "W2"),  b2 = param(Tensor::randn(1, H, 5) * s, "b2");
+        Value W3 = param(Tensor::randn(H, Out, 6) * s, "W3"), b3 = param(Tensor::randn(1, Out, 7) * s, "b3");
+        Value h1 = relu(matmul(X, W1) + b1);
+        Value h2 = leaky_relu(silu(matmul(h1, W2) + b2), 0.1f);
+        Value loss = cross_entropy_with_logits(matmul(h2, W3) + b3, Y);
+        auto st = check("mlp", loss, {X, Y}, {W1, b1, W2, b2, W3, b3});
+        assert(st.fused_groups == 3);
+    }
+
+    // 2) Wide rows (> one column tile) with row- and column-broadcast
+    //    operands, reduced to a scalar.
+    {
+        const int R = 8, C = 2500;
+        Value x = constant(Tensor::randn(R, C, 11), "x");
+        Value w = param(Tensor::randn(1, C, 12) * s, "w");
+        Value b = param(Tensor::randn(R, 1, 13) * s, "b");
+        Value y = mean_all(sigmoid(x * w + b) * x);
+        check("wide-mean", y, {x}, {w, b});
+    }
+
+    // 3) Row-wise tails, and a chain whose result is the plan output.
+    {
+        const int R = 16, C = 300;
+        Value x = constant(Tensor::randn(R, C, 21), "x");
+        Value b = param(Tensor::randn(1, C, 22) * s, "b");
+        check("softmax", softmax_row(tanh(x) + b), {x}, {b});
+        check("lse",     logsumexp_row(x - b), {x}, {b});
+        check("rowmax",  rowmax(relu(x) * x), {x}, {});
+        check("chain",   relu(x + b) * x - b, {x}, {b});
+    }
+
+    // 4) A chain value read twice stays materialised; only the tail after
+    //    it fuses.
+    {
+        Value x = constant(Tensor::randn(4, 6, 31), "x");
+        Value t = relu(x) * x;
+        auto st = check("shared", sum(relu(t) + t), {x}, {});
+        assert(st.fused_groups == 2 && st.steps == 2);
+    }
+
+    std::cout << "✅ JIT elementwise fusion test passed.\n";
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+
+using namespace ag;
+
+// Count heap allocations so we can check that a training step replays
+// without building a graph or allocating.
+static std::atomic<long> g_allocs{0};
+void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static Tensor one_hot(int B, int C) {
+    Tensor Y = Tensor::zeros(B, C);
+    for (int i = 0; i < B; ++i) Y(i, (i * 5) % C) = 1.f;
+    return Y;
+}
+
+// Largest difference relative to max(1, |b|).
+static float rel_diff(const Tensor& a, const Tensor& b) {
+    assert(a.shape() == b.shape());
+    float m = 0.f;
+    for (int64_t i = 0; i < a.rows(); ++i)
+        for (int64_t j = 0; j < a.cols(); ++j)
+            m = std::max(m, std::abs(a(i, j) - b(i, j)) / std::max(1.f, std::abs(b(i, j))));
+    return m;
+}
+
+struct Ptrs {
+    std::vector<Tensor> t;
+    std::vector<Tensor*> p;
+    explicit Ptrs(const std::vector<Value>& vs) {
+        for (auto& v : vs) t.push_back(v.val());
+        for (auto& x : t) p.push_back(&x);
+    }
+};
+
+// Compiles `loss` with grads (fused and unfused) and checks the loss and
+// every param gradient against eager backward().
+static void check(const char* name, const Value& loss,
+                  const std::vector<Value>& inputs, const std::vector<Value>& params) {
+    zero_grad(loss);
+    backward(loss, nullptr, /*retain_graph=*/true);   // compiled below
+
+    for (bool fuse : {true, false}) {
+        jit::CompileOptions o;
+        o.with_grads = true;
+        o.fuse_elementwise = fuse;
+        auto c = jit::compile(loss, inputs, params, o);
+        Ptrs in(inputs), par(params);
+        std::vector<Tensor> g(params.size());
+        std::vector<Tensor*> gp;
+        for (auto& t : g) gp.push_back(&t);
+        Tensor out;
+        [[maybe_unused]] const bool ok = c.run(in.p, par.p, out, gp);
+        assert(ok);
+
+        float worst = rel_diff(out, loss.val());
+        for (size_t k = 0; k < params.size(); ++k) worst = std::max(worst, rel_diff(g[k], params[k].node->grad));
+        auto st = c.stats();
+        std::cout << "[" << name << (fuse ? ", fused" : "") << "] " << st.steps << " steps, "
+                  << st.buffers << " buffers, arena " << st.arena_bytes << "B | max rel diff vs eager "
+                  << worst << std::endl;
+        assert(worst < 1e-3f);
+    }
+}
+
+int main() {
+    std::cout << "===== JIT Backward Plan Test =====\n";
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    const float s = 0.1f;
+
+    // 1) MLP + CE: matmul/bias-broadcast/activation VJPs.
+    const int B = 16, In = 24, H = 32, Out = 10;
+    Tensor Xt = Tensor::randn(B, In, 1), Yt = one_hot(B, Out);
+    std::vector<Tensor> Pt = {Tensor::randn(In, H, 2) * s, Tensor::randn(1, H, 3) * s,
+                              Tensor::randn(H, H, 4) * s,  Tensor::randn(1, H, 5) * s,
+                              Tensor::randn(H, Out, 6) * s, Tensor::randn(1, Out, 7) * s};
+    auto forward = [](const Value& X, const Value& Y, const std::vector<Value>& p) {
+        Value h1 = relu(matmul(X, p[0]) + p[1]);
+        Value h2 = leaky_relu(gelu(matmul(h1, p[2]) + p[3]), 0.1f);
+        return cross_entropy_with_logits(matmul(silu(h2), p[4]) + p[5], Y);
+    };
+    {
+        std::vector<Value> p;
+        for (auto& t : Pt) p.push_back(param(t, "p"));
+        Value X = constant(Xt, "X"), Y = constant(Yt, "Y");
+        check("mlp", forward(X, Y, p), {X, Y}, p);
+    }
+
+    // 2) Row reductions, a value read by several ops, a transpose, and a
+    //    param the loss does not depend on (its gradient is zero).
+    {
+        const int R = 6, C = 9;
+        Value x = constant(Tensor::randn(R, C, 11), "x");
+        Value w = param(Tensor::randn(1, C, 12) * s, "w");
+        Value c = param(Tensor::randn(R, 1, 13) * s, "c");
+        Value u = param(Tensor::randn(R, C, 14) * s, "u");
+        Value unused = param(Tensor::randn(2, 2, 15), "unused");
+        Value t = sigmoid(x * w - c) * x + u;
+        Value loss = sum(softmax_row(t) * t) + mean_all(logsumexp_row(t - c)) + sum(rowmax(exp(t)))
+                   + mean_all(rowsum(matmul(transpose(u), t))) + sum(log(softplus(t)) * u);
+        check("mixed", loss, {x}, {w, c, u, unused});
+    }
+
+    // 3) A fixed-shape SGD loop: compiled replay tracks eager training, and
+    //    a steady-state step allocates nothing.
+    {
+        std::vector<Value> p0;
+        for (auto& t : Pt) p0.push_back(param(t, "p"));
+        Value X = constant(Xt, "X"), Y = constant(Yt, "Y");
+        jit::CompileOptions o;
+        o.with_grads = true;
+        auto c = jit::compile(forward(X, Y, p0), {X, Y}, p0, o);
+
+        std::vector<Tensor> wj, we = Pt, g(Pt.size());
+        for (auto& t : Pt) wj.push_back(t * 1.f);   // own storage; updated in place below
+        std::vector<Tensor*> in = {&Xt, &Yt}, par, gp;
+        for (auto& t : wj) par.push_back(&t);
+        for (auto& t : g) gp.push_back(&t);
+        Tensor out;
+        const float lr = 0.5f;
+        float first = 0.f, last_jit = 0.f, last_eager = 0.f;
+        long allocs = 0;
+        for (int it = 0; it < 20; ++it) {
+            const long before = g_allocs.load();
+            [[maybe_unused]] const bool ok = c.run(in, par, out, gp);
+            assert(ok);
+            for (size_t k = 0; k < wj.size(); ++k) {
+                float* w = wj[k].data();
+                const float* d = g[k].data();
+                for (size_t i = 0; i < wj[k].numel(); ++i) w[i] -= lr * d[i];
+            }
+            if (it > 0) allocs += g_allocs.load() - before;
+            if (it == 0) first = out(0, 0);
+            last_jit = out(0, 0);
+
+            std::vector<Value> pe;
+            for (auto& t : we) pe.push_back(param(t, "p"));
+            Value le = forward(X, Y, pe);
+            backward(le);
+            for (size_t k = 0; k < we.size(); ++k) we[k] = we[k] - pe[k].node->grad * lr;
+            last_eager = le.val()(0, 0);
+        }
+        float drift = 0.f;
+        for (size_t k = 0; k < wj.size(); ++k) drift = std::max(drift, rel_diff(wj[k], we[k]));
+        std::cout << "sgd: loss " << first << " -> " << last_jit << " (eager " << last_eager
+                  << "), param drift " << drift << ", heap allocations in 19 steps: " << allocs << std::endl;
+        assert(last_jit < first);
+        assert(std::abs(last_jit - last_eager) < 1e-3f);
+        assert(drift < 1e-3f);
+        assert(allocs == 0);
+    }
+
+    // 4) Asking for gradients from a forward-only plan is an error.
+    {
+        Value w = param(Tensor::randn(2, 3, 21), "w");
+        auto c = jit::compile(sum(w * w), {}, {w});
+        Tensor wt = w.val(), out, g;
+        bool threw = false;
+        try { c.run({}, {&wt}, out, {&g}); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+    }
+
+    std::cout << "✅ JIT backward plan test passed.\n";
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+#include "ad/tracer.hpp"
+#include "test_util.hpp"
+
+using namespace ag;
+
+int main() {
+    std::cout << "===== JIT Multi-Output Test =====\n";
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    const int B = 8, In = 12, H = 16, C = 5;
+
+    Tensor Yt = Tensor::zeros(B, C);
+    for (int i = 0; i < B; ++i) Yt(i, i % C) = 1.f;
+    Value X  = constant(Tensor::randn(B, In, 1), "X");
+    Value Y  = constant(Yt, "Y");
+    Value W1 = param(Tensor::randn(In, H, 2) * 0.1f, "W1");
+    Value b1 = param(Tensor::randn(1, H, 3) * 0.1f, "b1");
+    Value Wc = param(Tensor::randn(H, C, 4) * 0.1f, "Wc");
+    Value Wr = param(Tensor::randn(H, 1, 5) * 0.1f, "Wr");
+    std::vector<Value> params = {W1, b1, Wc, Wr};
+
+    std::vector<Tensor> pt;
+    for (auto& v : params) pt.push_back(v.val());
+    Tensor Xt = X.val();
+    std::vector<Tensor*> in = {&Xt, &Yt}, pp;
+    for (auto& t : pt) pp.push_back(&t);
+
+    // 1) A shared trunk with two heads: one plan, trunk computed once.
+    {
+        Value trunk  = gelu(matmul(X, W1) + b1);
+        Value logits = matmul(trunk, Wc);
+        Value score  = sigmoid(matmul(trunk, Wr));
+
+        jit::CompileOptions o;
+        o.fuse_elementwise = false;   // step counts compare one to one
+        auto both = jit::compile({logits, score}, {X, Y}, params, o);
+        auto c1   = jit::compile(logits, {X, Y}, params, o);
+        auto c2   = jit::compile(score, {X, Y}, params, o);
+
+        Tensor a, b, a1, b1t;
+        [[maybe_unused]] bool ok = both.run(in, pp, {&a, &b});
+        ok = c1.run(in, pp, a1) && ok;
+        ok = c2.run(in, pp, b1t) && ok;
+        assert(ok);
+        assert(max_abs_diff(a, a1) == 0.f && max_abs_diff(b, b1t) == 0.f);
+        assert(max_abs_diff(a, logits.val()) < 1e-5f && max_abs_diff(b, score.val()) < 1e-5f);
+
+        Tensor first;   // the single-output overload returns output 0
+        ok = both.run(in, pp, first);
+        assert(ok && max_abs_diff(first, a) == 0.f);
+
+        const auto sb = both.stats();
+        std::cout << "[heads] " << sb.steps << " steps vs " << c1.stats().steps << " + "
+                  << c2.stats().steps << " compiled apart\n";
+        assert(sb.outputs == 2);
+        assert(sb.steps < c1.stats().steps + c2.stats().steps);
+
+        bool threw = false;
+        try { both.run(in, pp, std::vector<Tensor*>{&a}); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+        threw = false;
+        try { jit::compile({logits, X}, {X, Y}, params); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+
+        // Round-trips through a plan file with both outputs.
+        const char* path = "test_jit_multi.plan";
+        both.save(path);
+        auto loaded = jit::Compiled::load(path);
+        std::remove(path);
+        Tensor la, lb;
+        ok = loaded.run(in, pp, {&la, &lb});
+        assert(ok);
+        assert(max_abs_diff(la, a) == 0.f && max_abs_diff(lb, b) == 0.f);
+        assert(loaded.stats().outputs == 2);
+    }
+
+    // 2) A Tracer capture: the loss and a metric nothing else consumes come
+    //    out as the two outputs, with gradients of their sum.
+    {
+        auto tracer = trace::make_tracer();
+        Value loss, aux;
+        {
+            trace::CaptureGuard guard(tracer);
+            Value trunk = gelu(matmul(X, W1) + b1);
+            loss = cross_entropy_with_logits(matmul(trunk, Wc), Y);
+            aux  = mean_all(matmul(trunk, Wr) * matmul(trunk, Wr)) * 0.1f;
+        }
+        jit::CompileOptions o;
+        o.with_grads = true;
+        auto c = jit::compile(*tracer, {X, Y}, params, o);
+        assert(c.stats().outputs == 2);
+
+        std::vector<Tensor> g(params.size());
+        std::vector<Tensor*> gp;
+        for (auto& t : g) gp.push_back(&t);
+        Tensor l, m;
+        [[maybe_unused]] const bool ok = c.run(in, pp, {&l, &m}, gp);
+        assert(ok);
+        assert(max_abs_diff(l, loss.val()) < 1e-5f && max_abs_diff(m, aux.val()) < 1e-5f);
+
+        Value total = loss + aux;
+        zero_grad(total);
+        backward(total);
+        float d = 0.f;
+        for (size_t k = 0; k < params.size(); ++k) d = std::max(d, max_abs_diff(g[k], params[k].node->grad));
+        std::cout << "[tracer] " << c.stats().steps << " steps | max grad diff vs eager " << d << "\n";
+        assert(d < 1e-4f);
+    }
+
+    // 3) Marked outputs are kept even when one depends on another:
+    //    features and a loss computed from them.
+    {
+        auto tracer = trace::make_tracer();
+        Value feats, loss;
+        {
+            trace::CaptureGuard guard(tracer);
+            feats = gelu(matmul(X, W1) + b1);
+            loss  = cross_entropy_with_logits(matmul(feats, Wc), Y);
+        }
+        tracer->mark_output(feats.node);
+        tracer->mark_output(loss.node);
+        auto c = jit::compile(*tracer, {X, Y}, params);
+        assert(c.stats().outputs == 2);
+
+        // Outputs come in capture order; gelu does not report its node, so
+        // feats joined the capture when it was marked, after the loss.
+        Tensor f, l;
+        [[maybe_unused]] const bool ok = c.run(in, pp, {&l, &f});
+        assert(ok);
+        assert(max_abs_diff(f, feats.val()) < 1e-5f && max_abs_diff(l, loss.val()) < 1e-5f);
+        std::cout << "[marked] features " << f.rows() << "x" << f.cols() << " and loss both returned\n";
+    }
+
+    std::cout << "✅ JIT multi-output test passed.\n";
+    return 0;
+}
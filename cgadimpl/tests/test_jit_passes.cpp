@@ -0,0 +1,104 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+#include "test_util.hpp"
+
+using namespace ag;
+
+static jit::CompileOptions no_passes() {
+    jit::CompileOptions o;
+    o.fold_constants = o.eliminate_common = o.eliminate_dead = o.pretranspose = false;
+    return o;
+}
+
+// Runs `c` on the current values of inputs/params and checks the output
+// (and gradients, when compiled with them) against eager.
+static jit::PlanStats check(const char* name, const jit::Compiled& c, const Value& y,
+                            const std::vector<Value>& inputs, const std::vector<Value>& params,
+                            bool grads) {
+    std::vector<Tensor> it, pt, g(params.size());
+    for (auto& v : inputs) it.push_back(v.val());
+    for (auto& v : params) pt.push_back(v.val());
+    std::vector<Tensor*> ip, pp, gp;
+    for (auto& t : it) ip.push_back(&t);
+    for (auto& t : pt) pp.push_back(&t);
+    for (auto& t : g) gp.push_back(&t);
+    Tensor out;
+    [[maybe_unused]] const bool ok = grads ? c.run(ip, pp, out, gp) : c.run(ip, pp, out);
+    assert(ok);
+    float d = max_abs_diff(out, y.val());
+    if (grads) {
+        zero_grad(y);
+        backward(y, nullptr, /*retain_graph=*/true);   // y is checked more than once
+        for (size_t k = 0; k < params.size(); ++k) d = std::max(d, max_abs_diff(g[k], params[k].node->grad));
+    }
+    auto st = c.stats();
+    std::cout << "[" << name << "] " << st.steps << " steps (folded " << st.folded << ", merged "
+              << st.merged << ", removed " << st.removed << ") | max diff vs eager " << d << std::endl;
+    assert(d < 1e-4f);
+    return st;
+}
+
+int main() {
+    std::cout << "===== JIT Graph Passes Test =====\n";
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    const int B = 8, In = 12, H = 16;
+
+    // 1) A constant weight read through transpose(), plus a constant-only
+    //    subexpression: both run at compile time.
+    {
+        Value X  = constant(Tensor::randn(B, In, 1), "X");
+        Value Wc = constant(Tensor::randn(H, In, 2) * 0.1f, "Wc");   // not an input: a literal
+        Value bc = constant(Tensor::randn(1, H, 3) * 0.1f, "bc");
+        Value y  = sum(relu(matmul(X, transpose(Wc)) + exp(bc) * bc));
+
+        // Unfused, so step counts compare one to one.
+        jit::CompileOptions o;
+        o.fuse_elementwise = false;
+        jit::CompileOptions raw = no_passes(), only_t = no_passes();
+        raw.fuse_elementwise = only_t.fuse_elementwise = false;
+        only_t.pretranspose = only_t.eliminate_dead = true;
+        auto all  = jit::compile(y, {X}, {}, o);
+        auto none = jit::compile(y, {X}, {}, raw);
+        auto pre  = jit::compile(y, {X}, {}, only_t);
+        auto sa = check("fold", all, y, {X}, {}, false);
+        auto sn = check("no passes", none, y, {X}, {}, false);
+        auto sp = check("pretranspose", pre, y, {X}, {}, false);
+        assert(sa.folded == 3 && sa.removed == 3 && sa.steps == sn.steps - 3);
+        assert(sp.folded == 1 && sp.steps == sn.steps - 1);
+    }
+
+    // 2) The same subexpression built twice (and commuted) is computed once,
+    //    forward and backward.
+    {
+        Value X = constant(Tensor::randn(B, In, 4), "X");
+        Value W = param(Tensor::randn(In, H, 5) * 0.1f, "W");
+        Value b = param(Tensor::randn(1, H, 6) * 0.1f, "b");
+        Value y = mean_all(leaky_relu(matmul(X, W) + b, 0.2f) * leaky_relu(b + matmul(X, W), 0.2f));
+
+        jit::CompileOptions o;
+        o.with_grads = true;
+        auto cse = jit::compile(y, {X}, {W, b}, o);
+        jit::CompileOptions p = no_passes();
+        p.with_grads = true;
+        auto raw = jit::compile(y, {X}, {W, b}, p);
+        auto sc = check("cse", cse, y, {X}, {W, b}, true);
+        auto sr = check("cse off", raw, y, {X}, {W, b}, true);
+        assert(sc.merged >= 3 && sc.steps < sr.steps);
+
+        // Without DCE the merged steps stay in the plan, but nothing reads them.
+        jit::CompileOptions k = o;
+        k.eliminate_dead = false;
+        auto kept = jit::compile(y, {X}, {W, b}, k);
+        auto sk = check("cse, no dce", kept, y, {X}, {W, b}, true);
+        assert(sk.removed == 0 && sk.steps > sc.steps);
+    }
+
+    std::cout << "✅ JIT graph passes test passed.\n";
+    return 0;
+}
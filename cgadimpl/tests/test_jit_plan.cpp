@@ -0,0 +1,106 @@
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include "ad/ag_all.hpp"
+
+using namespace ag;
+
+// Count heap allocations so we can check that replay is allocation-free.
+static std::atomic<long> g_allocs{0};
+void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+struct Model {
+    Value W1, b1, W2, b2, W3, b3;
+    Value forward(const Value& X, const Value& Y) const {
+        Value h1 = relu(matmul(X, W1) + b1);
+        Value h2 = leaky_relu(silu(matmul(h1, W2) + b2), 0.1f);
+        Value logits = matmul(h2, W3) + b3;
+        return cross_entropy_with_logits(logits, Y);
+    }
+};
+
+static Tensor one_hot(int B, int C, int shift) {
+    Tensor Y = Tensor::zeros(B, C);
+    for (int i = 0; i < B; ++i) Y(i, (i * 3 + shift) % C) = 1.f;
+    return Y;
+}
+
+int main() {
+    std::cout << "===== JIT Buffer Planning Test =====\n";
+    const int B = 32, In = 64, H = 128, Out = 10;
+    const float s = 0.1f;
+    Model m{param(Tensor::randn(In, H, 1) * s, "W1"), param(Tensor::randn(1, H, 2) * s, "b1"),
+            param(Tensor::randn(H, H, 3) * s, "W2"),  param(Tensor::randn(1, H, 4) * s, "b2"),
+            param(Tensor::randn(H, Out, 5) * s, "W3"), param(Tensor::randn(1, Out, 6) * s, "b3")};
+
+    Value X = constant(Tensor::randn(B, In, 7), "X");
+    Value Y = constant(one_hot(B, Out, 0), "Y");
+    Value loss = m.forward(X, Y);
+
+    std::vector<Value> params = {m.W1, m.b1, m.W2, m.b2, m.W3, m.b3};
+    // Fusion off: this test is about the buffer planner on its own.
+    auto comp = jit::compile(loss, {X, Y}, params, jit::CompileOptions{false, true, false});
+    auto naive = jit::compile(loss, {X, Y}, params, jit::CompileOptions{false, false, false});
+
+    auto st = comp.stats();
+    std::cout << "steps=" << st.steps << " slots=" << st.slots << " buffers=" << st.buffers
+              << " in_place=" << st.in_place << " arena=" << st.arena_bytes
+              << "B naive=" << st.naive_bytes << "B" << std::endl;
+    assert(st.buffers < st.slots);
+    assert(st.in_place > 0);
+    assert(st.arena_bytes < st.naive_bytes);
+    assert(naive.stats().buffers == naive.stats().slots);
+
+    std::vector<Tensor*> par_ptrs;
+    for (auto& p : params) par_ptrs.push_back(&p.node->value);
+
+    // 1) Same answer as eager, with and without buffer reuse.
+    Tensor Xt = X.val(), Yt = Y.val();
+    Tensor out, out_naive;
+    // run() stays outside assert so Release (NDEBUG) builds still execute it.
+    [[maybe_unused]] bool ok = comp.run({&Xt, &Yt}, par_ptrs, out);
+    assert(ok);
+    ok = naive.run({&Xt, &Yt}, par_ptrs, out_naive);
+    assert(ok);
+    float eager = loss.val()(0, 0);
+    std::cout << "loss eager=" << eager << " compiled=" << out(0, 0) << std::endl;
+    assert(std::abs(out(0, 0) - eager) < 1e-3f * std::max(1.f, std::abs(eager)));
+    assert(std::abs(out(0, 0) - out_naive(0, 0)) < 1e-5f);
+
+    // 2) New data through the same plan matches a fresh eager graph.
+    Tensor X2 = Tensor::randn(B, In, 99), Y2 = one_hot(B, Out, 5);
+    float eager2 = m.forward(constant(X2), constant(Y2)).val()(0, 0);
+
+    std::vector<Tensor*> in2 = {&X2, &Y2};
+    comp.run(in2, par_ptrs, out);                  // warm up
+    long before = g_allocs.load();
+    for (int i = 0; i < 10; ++i) {
+        ok = comp.run(in2, par_ptrs, out);
+        assert(ok);
+    }
+    long allocs = g_allocs.load() - before;
+    std::cout << "loss eager=" << eager2 << " compiled=" << out(0, 0)
+              << " | heap allocations in 10 runs: " << allocs << std::endl;
+    assert(std::abs(out(0, 0) - eager2) < 1e-3f * std::max(1.f, std::abs(eager2)));
+    assert(allocs == 0);
+
+    // 3) Shape guard still rejects a different batch.
+    Tensor Xbad = Tensor::randn(B + 1, In, 1);
+    ok = comp.run({&Xbad, &Yt}, par_ptrs, out);
+    assert(!ok);
+
+    std::cout << "✅ JIT buffer planning test passed.\n";
+    return 0;
+}
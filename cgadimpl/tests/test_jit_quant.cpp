@@ -0,0 +1,167 @@
+// test_jit_quant.cpp
+// Post-training int8 quantisation of a jit plan: calibrate on sample
+// batches, quantize, then compare accuracy and speed against the fp32
+// plan on the test_mlp model (and a wider one for timing).
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+
+using namespace ag;
+using clock_type = std::chrono::steady_clock;
+
+template <class F>
+static double median_us(int iters, F f) {
+    for (int i = 0; i < 5; ++i) f();
+    std::vector<double> t;
+    for (int i = 0; i < iters; ++i) {
+        auto t0 = clock_type::now();
+        f();
+        t.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - t0).count());
+    }
+    std::sort(t.begin(), t.end());
+    return t[t.size() / 2];
+}
+
+struct Accuracy {
+    float rel_err;   // max |int8 - fp32| / max |fp32|
+    float top1;      // rows whose argmax agrees
+};
+
+static Accuracy compare(const Tensor& q, const Tensor& f) {
+    float d = 0.f, m = 0.f;
+    int agree = 0;
+    for (int64_t i = 0; i < f.rows(); ++i) {
+        int64_t aq = 0, af = 0;
+        for (int64_t j = 0; j < f.cols(); ++j) {
+            d = std::max(d, std::abs(q(i, j) - f(i, j)));
+            m = std::max(m, std::abs(f(i, j)));
+            if (q(i, j) > q(i, aq)) aq = j;
+            if (f(i, j) > f(i, af)) af = j;
+        }
+        agree += aq == af;
+    }
+    return {d / m, float(agree) / float(f.rows())};
+}
+
+// relu MLP with test_mlp's layout: X[B,dims[0]] -> ... -> logits[B,dims.back()].
+struct Mlp {
+    std::vector<Value> params;
+    Value X;
+    Value logits;
+    Mlp(int B, const std::vector<int>& dims, float scale) {
+        X = constant(Tensor::randn(B, dims[0], 1), "X");
+        Value h = X;
+        for (size_t l = 0; l + 1 < dims.size(); ++l) {
+            Value W = param(Tensor::randn(dims[l], dims[l + 1], 10 + int(l)) * scale, "W");
+            Value b = param(Tensor::randn(1, dims[l + 1], 20 + int(l)) * 0.1f, "b");
+            params.push_back(W);
+            params.push_back(b);
+            h = matmul(h, W) + b;
+            if (l + 2 < dims.size()) h = relu(h);
+        }
+        logits = h;
+    }
+};
+
+int main() {
+    std::cout << "===== JIT Int8 Quantisation Test =====\n";
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    const int B = 64;
+
+    for (int wide = 0; wide < 2; ++wide) {
+        const std::vector<int> dims = wide ? std::vector<int>{256, 512, 512, 256, 10}
+                                           : std::vector<int>{8, 32, 32, 16, 10};   // test_mlp
+        Mlp m(B, dims, wide ? 0.05f : 0.5f);
+        std::vector<Tensor> pt;
+        for (auto& v : m.params) pt.push_back(v.val());
+        std::vector<Tensor*> pp;
+        for (auto& t : pt) pp.push_back(&t);
+
+        auto fp32 = jit::compile(m.logits, {m.X}, m.params);
+        bool threw = false;
+        try { fp32.quantize(pp); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);   // nothing calibrated yet
+
+        // Calibrate on sample batches drawn like the data.
+        fp32.calibrate(true);
+        Tensor out;
+        for (int s = 0; s < 8; ++s) {
+            Tensor xs = Tensor::randn(B, dims[0], 100 + s);
+            std::vector<Tensor*> in = {&xs};
+            [[maybe_unused]] const bool ok = fp32.run(in, pp, out);
+            assert(ok);
+        }
+        fp32.calibrate(false);
+
+        Tensor xt = Tensor::randn(B, dims[0], 7);   // held out
+        std::vector<Tensor*> in = {&xt};
+        Tensor yf;
+        [[maybe_unused]] bool ok = fp32.run(in, pp, yf);
+        assert(ok);
+        const char* name = wide ? "wide" : "test_mlp";
+        for (int per_channel = 1; per_channel >= 0; --per_channel) {
+            jit::QuantOptions qo;
+            qo.per_channel = per_channel;
+            auto q = fp32.quantize(pp, qo);
+            const auto st = q.stats();
+            assert(st.quantized == int(dims.size()) - 1);
+            assert(st.int8_links == st.quantized - 1);
+            Tensor yq;
+            ok = q.run(in, pp, yq);
+            assert(ok);
+            const Accuracy acc = compare(yq, yf);
+            std::printf("[%s] %s: rel err %.4f | top-1 agreement %.3f\n", name,
+                        per_channel ? "per-channel" : "per-tensor", acc.rel_err, acc.top1);
+            assert(acc.rel_err < 0.05f && acc.top1 >= 0.9f);
+            if (!per_channel) continue;
+
+            // The int8 kernel is portable core code; report it against the
+            // fp32 plan both with the CPU plugin and on core kernels alone.
+            const kernels::Cpu plugin = ctx.cpu;
+            const uint64_t gen = ctx.cpu_generation;
+            ctx.cpu = kernels::Cpu{};
+            auto core = jit::compile(m.logits, {m.X}, m.params);
+            ctx.cpu = plugin;
+            ctx.cpu_generation = gen;
+            const int iters = wide ? 30 : 500;
+            Tensor yc;
+            const double tf = median_us(iters, [&] { fp32.run(in, pp, yf); });
+            const double tc = median_us(iters, [&] { core.run(in, pp, yc); });
+            const double tq = median_us(iters, [&] { q.run(in, pp, yq); });
+            std::printf("[%s] fp32 plugin %.1f us | fp32 core %.1f us | int8 %.1f us "
+                        "(%.2fx vs core)\n", name, tf, tc, tq, tc / tq);
+
+            // Quantised plans round-trip through a plan file.
+            const char* path = "test_jit_quant.plan";
+            q.save(path);
+            auto loaded = jit::Compiled::load(path);
+            std::remove(path);
+            Tensor yl;
+            ok = loaded.run(in, pp, yl);
+            assert(ok && loaded.stats().quantized == st.quantized);
+            for (size_t i = 0; i < yl.numel(); ++i) assert(yl.data()[i] == yq.data()[i]);
+        }
+    }
+
+    // Plans with gradients are not quantised.
+    {
+        Mlp m(4, {8, 16, 10}, 0.5f);
+        jit::CompileOptions o;
+        o.with_grads = true;
+        auto c = jit::compile(sum(m.logits), {m.X}, m.params, o);
+        bool threw = false;
+        try { c.quantize({}); } catch (const std::runtime_error&) { threw = true; }
+        assert(threw);
+    }
+
+    std::cout << "✅ JIT int8 quantisation test passed.\n";
+    return 0;
+}
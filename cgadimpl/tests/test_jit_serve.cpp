@@ -0,0 +1,129 @@
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+#include "ad/serve.hpp"
+#include "test_util.hpp"
+
+using namespace ag;
+using clock_type = std::chrono::steady_clock;
+
+template <class F>
+static bool throws(F f) {
+    try { f(); } catch (const std::runtime_error&) { return true; }
+    return false;
+}
+
+int main() {
+    std::cout << "===== JIT Server Test =====\n";
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    const int In = 12, H = 16, Out = 5;
+
+    // Per-sample classifier with a second (per-row) input.
+    Tensor W1 = Tensor::randn(In, H, 1) * 0.2f, b1 = Tensor::randn(1, H, 2) * 0.2f;
+    Tensor W2 = Tensor::randn(H, Out, 3) * 0.2f;
+    auto model = [](const std::vector<Value>& in, const std::vector<Value>& p) {
+        return softmax_row(matmul(gelu(matmul(in[0], p[0]) + p[1]), p[2]) + in[1]);
+    };
+    auto eager = [&](const Tensor& X, const Tensor& Z) {
+        return model({constant(X, "X"), constant(Z, "Z")},
+                     {param(W1, "W1"), param(b1, "b1"), param(W2, "W2")}).val();
+    };
+
+    // 1) Concurrent clients, requests of 1..4 rows: each gets its own rows
+    //    back, and requests share batches.
+    {
+        jit::ServerOptions o;
+        o.max_batch = 16;
+        o.max_delay = std::chrono::milliseconds(2);
+        o.workers = 2;
+        jit::Server srv(model, {W1, b1, W2}, {In, Out}, o);
+        assert(srv.bucket(1) == 1 && srv.bucket(3) == 4 && srv.bucket(9) == 16 && srv.bucket(16) == 16);
+
+        const int clients = 8, per_client = 20;
+        std::vector<std::vector<Tensor>> X(clients), Z(clients), ref(clients);
+        size_t rows = 0;
+        for (int c = 0; c < clients; ++c)
+            for (int r = 0; r < per_client; ++r) {
+                const int64_t n = 1 + (c + r) % 4;
+                X[c].push_back(Tensor::randn(n, In, 100 + unsigned(c * per_client + r)));
+                Z[c].push_back(Tensor::randn(n, Out, 900 + unsigned(c * per_client + r)));
+                ref[c].push_back(eager(X[c].back(), Z[c].back()));
+                rows += size_t(n);
+            }
+        std::vector<float> err(clients, 0.f);
+        std::vector<std::thread> ts;
+        for (int c = 0; c < clients; ++c)
+            ts.emplace_back([&, c] {
+                // Keep a few requests in flight per client.
+                std::vector<std::future<Tensor>> fs;
+                for (int r = 0; r < per_client; ++r) fs.push_back(srv.submit({X[c][r], Z[c][r]}));
+                for (int r = 0; r < per_client; ++r)
+                    err[c] = std::max(err[c], max_abs_diff(fs[r].get(), ref[c][r]));
+            });
+        for (auto& t : ts) t.join();
+        for (float e : err) assert(e < 1e-5f);
+
+        const auto s = srv.stats();
+        std::cout << "[clients] " << s.requests << " requests in " << s.batches << " batches, "
+                  << s.rows << " rows (" << s.padded << " with padding), " << s.full << " full\n";
+        assert(s.requests == size_t(clients * per_client) && s.rows == rows);
+        assert(s.batches < s.requests && s.padded >= s.rows);
+    }
+
+    // 2) A lone request runs once max_delay has passed; a batch that fills
+    //    up runs without waiting out the delay.
+    {
+        jit::ServerOptions o;
+        o.max_batch = 8;
+        o.max_delay = std::chrono::milliseconds(1);
+        jit::Server lone(model, {W1, b1, W2}, {In, Out}, o);
+        Tensor X = Tensor::randn(3, In, 5), Z = Tensor::randn(3, Out, 6);
+        const Tensor y = lone.submit({X, Z}).get();
+        assert(max_abs_diff(y, eager(X, Z)) < 1e-5f);
+        assert(lone.stats().batches == 1 && lone.stats().full == 0 && lone.stats().padded == 4);
+
+        o.max_delay = std::chrono::seconds(10);
+        jit::Server filled(model, {W1, b1, W2}, {In, Out}, o);
+        const auto t0 = clock_type::now();
+        std::vector<std::future<Tensor>> fs;
+        for (int r = 0; r < 4; ++r) fs.push_back(filled.submit({Tensor::randn(2, In, 7 + r), Tensor::randn(2, Out, 8 + r)}));
+        for (auto& f : fs) {
+            const Tensor y = f.get();
+            assert(y.shape() == std::make_pair(int64_t(2), int64_t(Out)));
+        }
+        assert(clock_type::now() - t0 < std::chrono::seconds(5));
+        assert(filled.stats().batches == 1 && filled.stats().full == 1);
+    }
+
+    // 3) Misuse is reported at submit() or construction.
+    {
+        jit::ServerOptions o;
+        o.max_batch = 4;
+        jit::Server srv(model, {W1, b1, W2}, {In, Out}, o);
+        assert(throws([&] { srv.submit(Tensor::randn(2, In, 1)); }));                            // one input
+        assert(throws([&] { srv.submit({Tensor::randn(5, In, 1), Tensor::randn(5, Out, 1)}); })); // > max_batch
+        assert(throws([&] { srv.submit({Tensor::randn(2, In, 1), Tensor::randn(3, Out, 1)}); })); // rows differ
+        assert(throws([&] { srv.submit({Tensor::randn(2, In + 1, 1), Tensor::randn(2, Out, 1)}); }));
+        auto pending = srv.submit({Tensor::randn(2, In, 1), Tensor::randn(2, Out, 1)});
+        srv.shutdown();   // drains what is queued
+        const Tensor drained = pending.get();
+        assert(drained.rows() == 2);
+        assert(throws([&] { srv.submit({Tensor::randn(2, In, 1), Tensor::randn(2, Out, 1)}); }));
+
+        auto pooled = [](const std::vector<Value>& in, const std::vector<Value>& p) {
+            return sum(matmul(in[0], p[0]));
+        };
+        assert(throws([&] { jit::Server bad(pooled, {W1}, {In}); }));
+    }
+
+    std::cout << "✅ JIT server test passed.\n";
+    return 0;
+}
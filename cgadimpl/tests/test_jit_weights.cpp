@@ -0,0 +1,97 @@
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+#include "test_util.hpp"
+
+using namespace ag;
+
+static void print(const char* what, const jit::WeightStats& s) {
+    std::printf("[%s] %zu weights, %zu bytes resident | %zu references, %zu bytes if private\n",
+                what, s.weights, s.resident_bytes, s.references, s.referenced_bytes);
+}
+
+const int In = 24, H = 48, Out = 6;
+
+// Weights baked into the plan as literals; transpose(W2t) is folded at
+// compile time, so every plan makes its own [H, Out] copy of it.
+static jit::Compiled build(int64_t batch, unsigned seed, Tensor* x_out = nullptr) {
+    Value X = constant(Tensor::randn(batch, In, 7), "X");
+    Value W1 = constant(Tensor::randn(In, H, seed) * 0.2f, "W1");
+    Value b1 = constant(Tensor::randn(1, H, seed + 1) * 0.2f, "b1");
+    Value W2t = constant(Tensor::randn(Out, H, seed + 2) * 0.2f, "W2t");
+    Value y = softmax_row(matmul(relu(matmul(X, W1) + b1), transpose(W2t)));
+    if (x_out) *x_out = X.val();
+    return jit::compile(y, {X}, {});
+}
+
+int main() {
+    std::cout << "===== JIT Shared Weights Test =====\n";
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    assert(jit::weight_stats().weights == 0);
+
+    std::vector<jit::Compiled> plans;
+    std::vector<Tensor> xs;
+    std::size_t referenced = 0;
+    auto add = [&](jit::Compiled c, const Tensor& x) {
+        referenced += c.stats().literal_bytes;
+        plans.push_back(std::move(c));
+        xs.push_back(x);
+    };
+
+    // 1) Batch-bucketed plans, each traced from freshly made (equal)
+    //    weight tensors: one resident copy of W1, b1 and folded W2.
+    for (int64_t b : {1, 2, 4, 8}) {
+        Tensor x;
+        jit::Compiled c = build(b, 11, &x);
+        add(std::move(c), x);
+    }
+    const std::size_t model_bytes = plans[0].stats().literal_bytes;
+    assert(model_bytes == (In * H + H + H * Out) * sizeof(float));
+    auto s = jit::weight_stats();
+    print("buckets", s);
+    assert(s.weights == 3 && s.resident_bytes == model_bytes);
+    assert(s.references == 3 * plans.size() && s.referenced_bytes == referenced);
+
+    // 2) Replicas loaded from a plan file join the same copies.
+    const char* path = "test_jit_weights.plan";
+    plans[3].save(path);
+    for (int r = 0; r < 3; ++r) add(jit::Compiled::load(path), xs[3]);
+    std::remove(path);
+    s = jit::weight_stats();
+    print("replicas", s);
+    assert(s.weights == 3 && s.resident_bytes == model_bytes && s.referenced_bytes == referenced);
+    assert(s.referenced_bytes == 7 * model_bytes);
+
+    // Sharing changes nothing about the results.
+    for (size_t k = 0; k < plans.size(); ++k) {
+        Tensor out, ref;
+        std::vector<Tensor*> in = {&xs[k]};
+        [[maybe_unused]] bool ok = plans[k].run(in, {}, out);
+        ok = build(xs[k].rows(), 11).run(in, {}, ref) && ok;
+        assert(ok);
+        assert(max_abs_diff(out, ref) == 0.f);
+    }
+
+    // 3) Other weights are stored separately; dropping plans releases
+    //    what only they used.
+    {
+        jit::Compiled other = build(4, 99);
+        s = jit::weight_stats();
+        assert(s.weights == 6 && s.resident_bytes == 2 * model_bytes);
+    }
+    s = jit::weight_stats();
+    assert(s.weights == 3 && s.resident_bytes == model_bytes);
+    plans.clear();
+    s = jit::weight_stats();
+    print("released", s);
+    assert(s.weights == 0 && s.resident_bytes == 0 && s.references == 0);
+
+    std::cout << "✅ JIT shared weights test passed.\n";
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+#include <vector>
+#include "ad/ag_all.hpp"
+#include "ad/context.hpp"
+
+using namespace ag;
+
+// Count heap allocations so we can check that warm workspace runs are
+// allocation-free.
+static std::atomic<long> g_allocs{0};
+void* operator new(std::size_t n) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static bool same(const Tensor& a, const Tensor& b) {
+    return a.shape() == b.shape() && std::memcmp(a.data(), b.data(), a.numel() * sizeof(float)) == 0;
+}
+
+struct Result {
+    long allocs;
+    bool identical;
+};
+
+// `threads` threads share `c`, each warming up once and then running it
+// `iters` times, on its own Workspace or on the default run() path.
+// Allocations are counted between the start and end barriers.
+static Result replay(const jit::Compiled& c, int threads, int iters, bool own_ws,
+                     const std::vector<Tensor*>& in, const std::vector<Tensor*>& par, const Tensor& ref) {
+    std::atomic<int> ready{0}, finished{0};
+    std::atomic<bool> go{false}, identical{true};
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t)
+        pool.emplace_back([&] {
+            jit::Workspace ws;
+            Tensor out;
+            auto run = [&] { return own_ws ? c.run(ws, in, par, out) : c.run(in, par, out); };
+            if (!run()) identical = false;
+            ready.fetch_add(1);
+            while (!go.load()) std::this_thread::yield();
+            for (int i = 0; i < iters; ++i)
+                if (!run()) identical = false;
+            if (!same(out, ref)) identical = false;
+            finished.fetch_add(1);
+        });
+    while (ready.load() < threads) std::this_thread::yield();
+    const long a0 = g_allocs.load();
+    go = true;
+    while (finished.load() < threads) std::this_thread::yield();
+    const long a1 = g_allocs.load();
+    for (auto& th : pool) th.join();
+    return {a1 - a0, identical.load()};
+}
+
+int main() {
+    std::cout << "===== JIT Workspace Test =====\n";
+    ExecutionContext ctx;
+    ctx.log_nodes = false;
+    ContextScope scope(ctx);
+    ctx.cpu = kernels::Cpu{};
+
+    const int B = 16, In = 32, H = 64, Out = 8;
+    Value X = constant(Tensor::randn(B, In, 1), "X");
+    std::vector<Value> p = {param(Tensor::randn(In, H, 2) * 0.1f, "W1"), param(Tensor::randn(1, H, 3) * 0.1f, "b1"),
+                            param(Tensor::randn(H, Out, 4) * 0.1f, "W2"), param(Tensor::randn(1, Out, 5) * 0.1f, "b2")};
+    Value y = softmax_row(matmul(gelu(matmul(X, p[0]) + p[1]), p[2]) + p[3]);
+    auto c = jit::compile(y, {X}, p);
+
+    Tensor Xt = X.val();
+    std::vector<Tensor> pt;
+    for (auto& v : p) pt.push_back(v.val());
+    std::vector<Tensor*> in = {&Xt}, par;
+    for (auto& t : pt) par.push_back(&t);
+    Tensor ref;
+    [[maybe_unused]] const bool ok = c.run(in, par, ref);
+    assert(ok);
+
+    // Threads on their own workspaces match a single-threaded run bit for
+    // bit and, once warm, never allocate; the default path still matches.
+    for (int threads : {1, 4}) {
+        const Result w = replay(c, threads, 20, true, in, par, ref);
+        const Result d = replay(c, threads, 20, false, in, par, ref);
+        std::cout << threads << " threads: workspace allocations=" << w.allocs
+                  << " default allocations=" << d.allocs << std::endl;
+        assert(w.identical && d.identical);
+        assert(w.allocs == 0);
+    }
+
+    // One workspace serves several plans, one run at a time.
+    {
+        auto c2 = jit::compile(relu(matmul(X, p[0]) + p[1]), {X}, {p[0], p[1]});
+        Tensor ref2, o1, o2;
+        [[maybe_unused]] bool ok2 = c2.run(in, {par[0], par[1]}, ref2);
+        assert(ok2);
+        jit::Workspace ws;
+        ok2 = c.run(ws, in, par, o1);
+        assert(ok2);
+        ok2 = c2.run(ws, in, {par[0], par[1]}, o2);
+        assert(ok2);
+        assert(same(o1, ref) && same(o2, ref2));
+    }
+
+    std::cout << "✅ JIT workspace test passed.\n";
+    return 0;
+}
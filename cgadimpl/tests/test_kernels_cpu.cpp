@@ -49,7 +49,7 @@ void test_cpu_matmul() {
     ag::Tensor b = ag::Tensor::randn(16, 8, 789);
 
     ag::Tensor c_ref = ag::Tensor::matmul(a, b);
-    ag::Tensor c_out(8, 8);
+    ag::Tensor c_out = ag::Tensor::zeros(8, 8);   // matmul accumulates into C
 
     K.matmul(a.data(), b.data(), c_out.data(), 8, 16, 8);
 
@@ -0,0 +1,84 @@
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include <array>
+#include "ad/ag_all.hpp"
+#include "ad/meta.hpp"
+
+using namespace ag;
+
+static bool throws(void (*fn)()) {
+    try { fn(); } catch (const std::runtime_error&) { return true; }
+    return false;
+}
+
+int main() {
+    std::cout << "===== Meta (shape-only) Mode Test =====\n";
+
+    // 1) Rule table straight from ops.def.
+    assert(op_shape_rule(Op::Add) == ShapeRule::Broadcast);
+    assert(op_shape_rule(Op::MatMul) == ShapeRule::MatMul);
+    assert(op_shape_rule(Op::RowSum) == ShapeRule::RowReduce);
+    assert(infer_shape(Op::MatMul, {{8, 3}, {3, 5}}) == Shape2(8, 5));
+    assert(infer_shape(Op::Add, {{8, 5}, {1, 5}}) == Shape2(8, 5));
+    assert(infer_shape(Op::Linear, {{8, 3}, {5, 3}, {1, 5}}) == Shape2(8, 5));
+    assert(infer_shape(Op::Transpose, {{8, 3}}) == Shape2(3, 8));
+    assert(infer_shape(Op::LogSumExpRow, {{8, 3}}) == Shape2(8, 1));
+    assert(infer_shape(Op::MSELoss, {{8, 3}, {8, 3}}) == Shape2(1, 1));
+    assert(infer_shape(Op::Attention, {{6, 4}, {4, 2}, {4, 2}, {4, 7}}) == Shape2(6, 7));
+    assert(throws([] { infer_shape(Op::MatMul, {{8, 3}, {4, 5}}); }));
+    assert(throws([] { infer_shape(Op::Add, {{8, 3}, {2, 3}}); }));
+
+    // Traits are plain constexpr tables.
+    static_assert(op_kind(Op::MatMul) == OpKind::Contraction, "matmul kind");
+    static_assert(op_fusible(Op::Relu) && !op_fusible(Op::SoftmaxRow), "fusible column");
+    static_assert(bwd_needs_output(Op::Exp) && !bwd_needs_input(Op::Add), "saves column");
+    static_assert(op_cost(Op::MatMul, std::array<Shape2, 2>{{{4, 3}, {3, 5}}}.data(), 2, {4, 5}).flops == 2 * 4 * 3 * 5,
+                  "contraction flops");
+
+    // 2) A big MLP traced without allocating: 4096x4096 weights would be
+    //    64 MB each if they were materialised.
+    const int64_t B = 512, D = 4096, C = 10;
+    Value x  = constant(Tensor::meta(B, D), "x");
+    Value y  = constant(Tensor::meta(B, C), "y");
+    Value W1 = param(Tensor::meta(D, D), "W1");
+    Value b1 = param(Tensor::meta(1, D), "b1");
+    Value W2 = param(Tensor::meta(D, C), "W2");
+    Value h  = relu(add(matmul(x, W1), b1));
+    Value logits = matmul(h, W2);
+    Value loss = cross_entropy_with_logits(logits, y);
+
+    assert(h.val().is_meta() && h.val().data() == nullptr);
+    assert(h.shape() == Shape2(B, D));
+    assert(logits.shape() == Shape2(B, C));
+    assert(loss.shape() == Shape2(1, 1));
+    assert(loss.node->requires_grad);
+    assert(meta::is_meta_graph(loss));
+
+    auto fp = meta::footprint(loss);
+    std::cout << "nodes=" << fp.nodes << " params=" << fp.param_bytes
+              << " activations=" << fp.activation_bytes << " grads=" << fp.grad_bytes << "\n";
+    assert(fp.nodes == 10 && fp.leaves == 5);
+    assert(fp.param_bytes == size_t(D * D + D + D * C) * sizeof(float));
+    assert(fp.activation_bytes == size_t(3 * B * D + B * C + 1) * sizeof(float));
+    // Costs come from the ops.def traits: 2 GEMMs, add, relu, CE over logits.
+    assert(fp.flops == 2 * B * D * D + B * D + B * D + 2 * B * D * C + 7 * B * C);
+
+    // 3) Mismatches are reported while building, not at run time.
+    bool caught = false;
+    try { matmul(logits, W1); } catch (const std::runtime_error& e) {
+        caught = true;
+        std::cout << "caught: " << e.what() << "\n";
+    }
+    assert(caught);
+
+    // 4) Meta shapes agree with the eager result on real data.
+    Value xr = constant(Tensor::randn(4, 6), "xr");
+    Value wr = param(Tensor::randn(6, 3), "wr");
+    Value er = softmax_row(transpose(matmul(xr, wr)));
+    Value em = softmax_row(transpose(matmul(constant(Tensor::meta(4, 6)), param(Tensor::meta(6, 3)))));
+    assert(er.shape() == em.shape() && !er.val().is_meta() && em.val().is_meta());
+
+    std::cout << "✅ Meta mode test passed.\n";
+    return 0;
+}
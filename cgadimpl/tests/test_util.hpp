@@ -0,0 +1,17 @@
+#pragma once
+// tests/test_util.hpp
+// Small helpers shared by the jit and fusion tests.
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include "tensor.hpp"
+
+// Largest elementwise |a - b|; the shapes must match.
+inline float max_abs_diff(const ag::Tensor& a, const ag::Tensor& b) {
+    assert(a.shape() == b.shape());
+    float m = 0.f;
+    for (int64_t i = 0; i < a.rows(); ++i)
+        for (int64_t j = 0; j < a.cols(); ++j) m = std::max(m, std::abs(a(i, j) - b(i, j)));
+    return m;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <chrono>
@@ -32,7 +33,7 @@ private:
 };
 
 // GFLOPS calculation
-double calculate_gflops(int M, int K, int N, double ms) {
+double calculate_gflops(int64_t M, int64_t K, int64_t N, double ms) {
     if (ms == 0) return 0.0;
     // Each output element requires K multiplications and K-1 additions, approx 2*K ops
     double ops = 2.0 * M * N * K;
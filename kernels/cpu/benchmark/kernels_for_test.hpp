@@ -1,9 +1,10 @@
 #pragma once
+#include <cstdint>
 
 // This header provides the declarations for all kernel implementations
 // that we want to benchmark.
 
 extern "C" {
-    void matmul_impl_naive(const float* A, const float* B, float* C, int M, int K, int N);
-    void matmul_impl_optimized(const float* A, const float* B, float* C, int M, int K, int N);
+    void matmul_impl_naive(const float* A, const float* B, float* C, int64_t M, int64_t K, int64_t N);
+    void matmul_impl_optimized(const float* A, const float* B, float* C, int64_t M, int64_t K, int64_t N);
 }
\ No newline at end of file
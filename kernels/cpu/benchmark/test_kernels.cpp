@@ -14,7 +14,7 @@
 // // // so this test file knows they exist. The linker will connect them later.
 // // extern "C" {
 // //     void relu_impl(const float* x, float* y, int64_t n);
-// //     void matmul_impl(const float* A, const float* B, float* C, int M, int K, int N);
+// //     void matmul_impl(const float* A, const float* B, float* C, int64_t M, int64_t K, int64_t N);
 // // }
 
 // // // Helper function to generate random data
@@ -111,7 +111,7 @@
 // *** IMPORTANT: These names must EXACTLY match the function names in the .cpp file ***
 extern "C" {
     void relu_impl_optimized(const float* x, float* y, int64_t n); // <-- CHANGED
-    void matmul_impl_optimized(const float* A, const float* B, float* C, int M, int K, int N); // <-- CHANGED
+    void matmul_impl_optimized(const float* A, const float* B, float* C, int64_t M, int64_t K, int64_t N); // <-- CHANGED
 }
 
 // Helper function to generate random data
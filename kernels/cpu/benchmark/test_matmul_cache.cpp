@@ -2,8 +2,8 @@
 #include <Eigen/Dense>
 
 extern "C" {
-    void matmul_impl_naive(const float*, const float*, float*, int, int, int);
-    void matmul_impl_optimized(const float*, const float*, float*, int, int, int);
+    void matmul_impl_naive(const float*, const float*, float*, int64_t, int64_t, int64_t);
+    void matmul_impl_optimized(const float*, const float*, float*, int64_t, int64_t, int64_t);
 }
 
 void benchmark_k(int K) {
@@ -0,0 +1,65 @@
+#include "benchmark_utils.hpp"
+#include <cstdlib>
+#include <new>
+#include <cmath>
+
+extern "C" {
+    void matmul_impl_optimized(const float*, const float*, float*, int64_t, int64_t, int64_t);
+    void relu_impl_optimized(const float* x, float* y, int64_t n);
+}
+
+// Exercises the 64-bit indexing path: the output C has more than 2^31
+// elements, so any int32 index math in the kernel would wrap and write
+// out of bounds. K is kept tiny so the run is memory-bound, not FLOP-bound.
+//
+// Needs ~9 GB of RAM for the default size. Pass a smaller M as argv[1] to
+// run the same code on a machine with less memory.
+int main(int argc, char** argv) {
+    std::cout << "===== MatMul >2^31 Element Benchmark =====" << std::endl;
+    const int64_t N = 32768;
+    const int64_t K = 4;
+    const int64_t M = argc > 1 ? std::atoll(argv[1]) : (int64_t(1) << 31) / N + 64;
+    const int64_t numel = M * N;
+    std::cout << "--- Size: " << M << "x" << K << "x" << N
+              << " (C has " << numel << " elements, 2^31 = " << (int64_t(1) << 31) << ") ---" << std::endl;
+
+    std::vector<float> A, B, C;
+    try {
+        A.resize(M * K); B.resize(K * N); C.assign(numel, 0.0f);
+    } catch (const std::bad_alloc&) {
+        std::cout << "SKIPPED: not enough memory for " << (numel * sizeof(float)) / (1 << 20) << " MB" << std::endl;
+        return 0;
+    }
+    fill_random(A);
+    fill_random(B);
+
+    Timer timer;
+    timer.start();
+    matmul_impl_optimized(A.data(), B.data(), C.data(), M, K, N);
+    double mm_ms = timer.stop();
+
+    timer.start();
+    relu_impl_optimized(C.data(), C.data(), numel);
+    double relu_ms = timer.stop();
+
+    // Spot-check rows on both sides of the 2^31 boundary.
+    int bad = 0;
+    for (int64_t i : {int64_t(0), M / 2, M - 1}) {
+        for (int64_t j : {int64_t(0), N / 3, N - 1}) {
+            float ref = 0.0f;
+            for (int64_t k = 0; k < K; ++k) ref += A[i * K + k] * B[k * N + j];
+            ref = ref > 0.0f ? ref : 0.0f;
+            if (std::abs(ref - C[i * N + j]) > 1e-4f) ++bad;
+        }
+    }
+
+    double gbytes = (numel * sizeof(float)) / 1e9;
+    std::cout << std::left << std::setw(12) << "MatMul" << ": " << std::fixed << std::setprecision(3)
+              << std::setw(10) << mm_ms << " ms | " << std::setprecision(2)
+              << calculate_gflops(M, K, N, mm_ms) << " GFLOPS" << std::endl;
+    std::cout << std::left << std::setw(12) << "ReLU" << ": " << std::fixed << std::setprecision(3)
+              << std::setw(10) << relu_ms << " ms | " << std::setprecision(2)
+              << (2.0 * gbytes) / (relu_ms / 1000.0) << " GB/s" << std::endl;
+    std::cout << (bad ? "FAILED" : "OK") << " (" << bad << " mismatches)" << std::endl;
+    return bad ? 1 : 0;
+}
@@ -2,7 +2,7 @@
 #include <omp.h> // For omp_set_num_threads
 
 extern "C" {
-    void matmul_impl_optimized(const float*, const float*, float*, int, int, int);
+    void matmul_impl_optimized(const float*, const float*, float*, int64_t, int64_t, int64_t);
 }
 
 int main() {
@@ -3,8 +3,8 @@
 
 // Forward declare our kernel implementations
 extern "C" {
-    void matmul_impl_naive(const float*, const float*, float*, int, int, int);
-    void matmul_impl_optimized(const float*, const float*, float*, int, int, int);
+    void matmul_impl_naive(const float*, const float*, float*, int64_t, int64_t, int64_t);
+    void matmul_impl_optimized(const float*, const float*, float*, int64_t, int64_t, int64_t);
 }
 
 void benchmark_size(int M, int K, int N, int runs) {
@@ -89,11 +89,11 @@ void leakyrelu_impl_optimized(const float* x, float* y, int64_t n, float alpha)
 // }
 
 
-void matmul_impl_naive(const float* A, const float* B, float* C, int M, int K, int N) {
-    for (int i = 0; i < M; ++i) {
-        for (int j = 0; j < N; ++j) {
+void matmul_impl_naive(const float* A, const float* B, float* C, int64_t M, int64_t K, int64_t N) {
+    for (int64_t i = 0; i < M; ++i) {
+        for (int64_t j = 0; j < N; ++j) {
             float acc = 0.0f;
-            for (int k = 0; k < K; ++k) {
+            for (int64_t k = 0; k < K; ++k) {
                 acc += A[i * K + k] * B[k * N + j];
             }
             C[i * N + j] = acc;
@@ -146,50 +146,13 @@ void gelu_impl_optimized(const float* x, float* y, int64_t n) {
 }
 
 /**
- * Optimized MatMul using AVX2, FMA, OpenMP, and cache blocking.
- * C(MxN) = A(MxK) * B(KxN)
+ * MatMul on the packed GEMM (gemm_impl_optimized, below).
+ * C(MxN) += A(MxK) * B(KxN): callers zero C first, or pre-fill a bias.
  */
 void matmul_impl_optimized(const float* A, const float* B, float* C,
-                           int M, int K, int N)
+                           int64_t M, int64_t K, int64_t N)
 {
-    const int BLOCK_M = 64;
-    const int BLOCK_N = 64;
-    const int BLOCK_K = 32;
-    const int SIMD_WIDTH = 8; // AVX processes 8 floats
-
-    // Assume C is zero-initialized by caller
-    #pragma omp parallel for collapse(2)
-    for (int ii = 0; ii < M; ii += BLOCK_M) {
-        for (int jj = 0; jj < N; jj += BLOCK_N) {
-            for (int kk = 0; kk < K; kk += BLOCK_K) {
-                int i_end = std::min(ii + BLOCK_M, M);
-                int j_end = std::min(jj + BLOCK_N, N);
-                int k_end = std::min(kk + BLOCK_K, K);
-
-                for (int i = ii; i < i_end; i++) {
-                    int j = jj;
-                    // SIMD loop
-                    for (; j <= j_end - SIMD_WIDTH; j += SIMD_WIDTH) {
-                        __m256 c_vec = _mm256_loadu_ps(&C[i * N + j]);
-                        for (int k = kk; k < k_end; k++) {
-                            __m256 a_vec = _mm256_set1_ps(A[i * K + k]);
-                            __m256 b_vec = _mm256_loadu_ps(&B[k * N + j]);
-                            c_vec = _mm256_fmadd_ps(a_vec, b_vec, c_vec);
-                        }
-                        _mm256_storeu_ps(&C[i * N + j], c_vec);
-                    }
-                    // Remainder loop
-                    for (; j < j_end; j++) {
-                        float sum = C[i * N + j]; // Accumulate existing value
-                        for (int k = kk; k < k_end; k++) {
-                            sum += A[i * K + k] * B[k * N + j];
-                        }
-                        C[i * N + j] = sum;
-                    }
-                }
-            }
-        }
-    }
+    gemm_impl_optimized(0, 0, M, N, K, 1.f, A, K, B, N, 1.f, C, N);
 }
 
 static inline __m256 log256_approx(__m256 x) {
@@ -612,65 +575,16 @@ void pow_impl_optimized(const float* x, float* y, int64_t n, float exponent) {
     }
 }
 void linear_impl_optimized(const float* X, const float* W, const float* b, float* Y,
-                           int B, int In, int Out) {
+                           int64_t B, int64_t In, int64_t Out) {
     assert(X != nullptr && W != nullptr && Y != nullptr);
     if (B <= 0 || In <= 0 || Out <= 0) return;
 
-    // Tunable tile sizes (good starting points)
-    constexpr int TILE_B = 16;  // tile over batch
-    constexpr int TILE_O = 64;  // tile over output (columns)
-    constexpr int TILE_I = 64;  // tile over input (k)
-
-    const int VEC = 8; // AVX2 vector width
-
-    // Initialize output with bias if provided, otherwise zero
-    #pragma omp parallel for schedule(static)
-    for (int bi = 0; bi < B; ++bi) {
-        float* Yrow = Y + (size_t)bi * Out;
-        if (b) {
-            for (int j = 0; j < Out; ++j) Yrow[j] = b[j];
-        } else {
-            for (int j = 0; j < Out; ++j) Yrow[j] = 0.0f;
-        }
+    // Y = b (broadcast over rows), then Y += X @ W on the packed GEMM.
+    if (b) {
+        #pragma omp parallel for schedule(static)
+        for (int64_t bi = 0; bi < B; ++bi) std::memcpy(Y + (size_t)bi * Out, b, sizeof(float) * (size_t)Out);
     }
-
-    // Blocked matmul-like accumulation: for each block of batch x out, accumulate over In
-    #pragma omp parallel for collapse(2) schedule(dynamic)
-    for (int b0 = 0; b0 < B; b0 += TILE_B) {
-        for (int o0 = 0; o0 < Out; o0 += TILE_O) {
-            int b1 = std::min(b0 + TILE_B, B);
-            int o1 = std::min(o0 + TILE_O, Out);
-
-            for (int k0 = 0; k0 < In; k0 += TILE_I) {
-                int k1 = std::min(k0 + TILE_I, In);
-
-                // Process the tile (b0..b1) x (o0..o1), accumulating over k0..k1
-                for (int bi = b0; bi < b1; ++bi) {
-                    const float* Xrow = X + (size_t)bi * In;
-                    float* Yrow = Y + (size_t)bi * Out;
-
-                    for (int k = k0; k < k1; ++k) {
-                        // broadcast X[bi,k]
-                        __m256 a_vec = _mm256_set1_ps(Xrow[k]);
-                        const float* Wrow = W + (size_t)k * Out; // W[k, 0..Out-1]
-
-                        int oj = o0;
-                        // vectorized loop over outputs
-                        for (; oj + VEC <= o1; oj += VEC) {
-                            __m256 w_vec = _mm256_loadu_ps(Wrow + oj);
-                            __m256 y_vec = _mm256_loadu_ps(Yrow + oj);
-                            y_vec = _mm256_fmadd_ps(a_vec, w_vec, y_vec); // y += a * w
-                            _mm256_storeu_ps(Yrow + oj, y_vec);
-                        }
-                        // scalar tail
-                        for (; oj < o1; ++oj) {
-                            Yrow[oj] += Xrow[k] * Wrow[oj];
-                        }
-                    } // k
-                } // bi
-            } // k0
-        } // o0
-    } // b0
+    gemm_impl_optimized(0, 0, B, Out, In, 1.f, X, In, W, Out, b ? 1.f : 0.f, Y, Out);
 }
 
 // ===================================================================================== backward operations ==================================
@@ -902,199 +816,57 @@ void sqrt_bwd_impl_optimized_from_y(const float* y, const float* dY, float* dX,
         }
     }
 }
-// Compute dA = dC @ B^T
-// A: [M,K], B: [K,N], dC: [M,N]
-
-void matmul_bwd_dA_impl_optimized(const float* dC, const float* B, float* dA, int M, int K, int N) {
-    // This function needs to compute dA(M,K) = dC(M,N) @ B^T(N,K).
-    
-    // 1. Allocate temporary memory for B transposed (B_t will have shape N,K)
-    std::vector<float> B_t_vec( (size_t)N * K );
-    float* B_t = B_t_vec.data();
-
-    // 2. Transpose B into B_t. B is (K,N), B_t is (N,K).
-    // This is a simple, parallelized transpose loop.
-    #pragma omp parallel for collapse(2)
-    for (int i = 0; i < K; ++i) {
-        for (int j = 0; j < N; ++j) {
-            B_t[j * K + i] = B[i * N + j];
-        }
-    }
+// The backward products read B^T / A^T / X^T / W^T straight through the
+// GEMM's transpose flags; nothing is transposed into a temporary.
 
-    // 3. Now we can call the existing optimized matmul.
-    // The shapes are: dA(M,K) = dC(M,N) @ B_t(N,K)
-    matmul_impl_optimized(dC, B_t, dA, M, N, K);
-    
-    // The temporary memory for B_t is automatically freed when B_t_vec goes out of scope.
+// dA += dC @ B^T   A: [M,K], B: [K,N], dC: [M,N]
+void matmul_bwd_dA_impl_optimized(const float* dC, const float* B, float* dA, int64_t M, int64_t K, int64_t N) {
+    gemm_impl_optimized(0, 1, M, K, N, 1.f, dC, N, B, N, 1.f, dA, K);
 }
 
-// Compute dB = A^T @ dC
-// A: [M,K], dC: [M,N] -> A^T: [K,M] @ [M,N] = [K,N]
-void matmul_bwd_dB_impl_optimized(const float* A, const float* dC, float* dB, int M, int K, int N) {
-    // This function needs to compute dB(K,N) = A^T(K,M) @ dC(M,N).
-
-    // 1. Allocate temporary memory for A transposed (A_t will have shape K,M)
-    std::vector<float> A_t_vec( (size_t)K * M );
-    float* A_t = A_t_vec.data();
-
-    // 2. Transpose A into A_t. A is (M,K), A_t is (K,M).
-    #pragma omp parallel for collapse(2)
-    for (int i = 0; i < M; ++i) {
-        for (int j = 0; j < K; ++j) {
-            A_t[j * M + i] = A[i * K + j];
-        }
-    }
-
-    // 3. Now we can call the existing optimized matmul.
-    // The shapes are: dB(K,N) = A_t(K,M) @ dC(M,N)
-    matmul_impl_optimized(A_t, dC, dB, K, M, N);
-
-    // The temporary memory for A_t is automatically freed.
+// dB += A^T @ dC   A: [M,K], dC: [M,N] -> [K,N]
+void matmul_bwd_dB_impl_optimized(const float* A, const float* dC, float* dB, int64_t M, int64_t K, int64_t N) {
+    gemm_impl_optimized(1, 0, K, N, M, 1.f, A, K, dC, N, 1.f, dB, N);
 }
 
-
-// Compute dW = X^T @ dY   (In x Out)  ; X (B x In), dY (B x Out)
+// dW = X^T @ dY   (In x Out)  ; X (B x In), dY (B x Out)
 void linear_dW_impl_optimized(const float* X, const float* dY, float* dW,
-                              int B, int In, int Out) {
+                              int64_t B, int64_t In, int64_t Out) {
     assert(X && dY && dW);
     if (B <= 0 || In <= 0 || Out <= 0) return;
-
-    const int TILE_I = 32;   // tile over In (rows of dW)
-    const int TILE_O = 64;   // tile over Out (cols of dW)
-    const int TILE_B = 64;   // accumulate blocks of batch
-    const int VEC = 8;
-    
-    // Zero dW
-    std::fill(dW, dW + (size_t)In * Out, 0.0f);
-
-    // For each block of (i0..i1) x (o0..o1) compute partial sums
-    #pragma omp parallel for collapse(2) schedule(dynamic)
-    for (int i0 = 0; i0 < In; i0 += TILE_I) {
-        for (int o0 = 0; o0 < Out; o0 += TILE_O) {
-            int i1 = std::min(i0 + TILE_I, In);
-            int o1 = std::min(o0 + TILE_O, Out);
-
-            // Use a local buffer to accumulate over B blocks to reduce contention
-            std::vector<float> local((size_t)(i1 - i0) * (o1 - o0));
-            std::fill(local.begin(), local.end(), 0.0f);
-
-            for (int b0 = 0; b0 < B; b0 += TILE_B) {
-                int b1 = std::min(b0 + TILE_B, B);
-
-                for (int b = b0; b < b1; ++b) {
-                    const float* Xrow = X + (size_t)b * In;
-                    const float* DYrow = dY + (size_t)b * Out;
-
-                    // accumulate into local[(i-i0)*(o1-o0) + (o-o0)]
-                    for (int i = i0; i < i1; ++i) {
-                        __m256 x_bcast = _mm256_set1_ps(Xrow[i]);
-                        int o = o0;
-                        // vector loop
-                        for (; o + VEC <= o1; o += VEC) {
-                            __m256 dy_vec = _mm256_loadu_ps(DYrow + o);
-                            __m256 acc = _mm256_loadu_ps(&local[(i - i0) * (o1 - o0) + (o - o0)]);
-                            acc = _mm256_fmadd_ps(x_bcast, dy_vec, acc);
-                            _mm256_storeu_ps(&local[(i - i0) * (o1 - o0) + (o - o0)], acc);
-                        }
-                        for (; o < o1; ++o) {
-                            local[(i - i0) * (o1 - o0) + (o - o0)] += Xrow[i] * DYrow[o];
-                        }
-                    }
-                } // b block
-            } // b0
-
-            // write local into global dW
-            for (int i = i0; i < i1; ++i) {
-                float* dWrow = dW + (size_t)i * Out;
-                int o = o0;
-                // vector copy
-                for (; o + VEC <= o1; o += VEC) {
-                    __m256 v = _mm256_loadu_ps(&local[(i - i0) * (o1 - o0) + (o - o0)]);
-                    __m256 orig = _mm256_loadu_ps(dWrow + o);
-                    orig = _mm256_add_ps(orig, v);
-                    _mm256_storeu_ps(dWrow + o, orig);
-                }
-                for (; o < o1; ++o) dWrow[o] += local[(i - i0) * (o1 - o0) + (o - o0)];
-            }
-        }
-    }
+    gemm_impl_optimized(1, 0, In, Out, B, 1.f, X, In, dY, Out, 0.f, dW, Out);
 }
 
-// Compute dX = dY @ W^T   (B x In) ; dY (B x Out), W (In x Out)
+// dX = dY @ W^T   (B x In) ; dY (B x Out), W (In x Out)
 void linear_dX_impl_optimized(const float* dY, const float* W, float* dX,
-                              int B, int In, int Out) {
+                              int64_t B, int64_t In, int64_t Out) {
     assert(dY && W && dX);
     if (B <= 0 || In <= 0 || Out <= 0) return;
-
-    const int TILE_B = 32;
-    const int TILE_I = 32;
-    const int TILE_O = 64;
-    const int VEC = 8;
-
-    // Zero dX
-    #pragma omp parallel for schedule(static)
-    for (int b = 0; b < B; ++b) {
-        float* dxrow = dX + (size_t)b * In;
-        for (int i = 0; i < In; ++i) dxrow[i] = 0.0f;
-    }
-
-    // We compute for each b and i: dX[b,i] += sum_o dY[b,o] * W[i,o]
-    #pragma omp parallel for collapse(2) schedule(dynamic)
-    for (int b0 = 0; b0 < B; b0 += TILE_B) {
-        for (int i0 = 0; i0 < In; i0 += TILE_I) {
-            int b1 = std::min(b0 + TILE_B, B);
-            int i1 = std::min(i0 + TILE_I, In);
-
-            for (int o0 = 0; o0 < Out; o0 += TILE_O) {
-                int o1 = std::min(o0 + TILE_O, Out);
-
-                for (int b = b0; b < b1; ++b) {
-                    const float* dyrow = dY + (size_t)b * Out;
-                    float* dxrow = dX + (size_t)b * In;
-
-                    for (int i = i0; i < i1; ++i) {
-                        // compute dot(dyrow[o0..o1), W[i*Out + o0..o1))
-                        __m256 acc = _mm256_setzero_ps();
-                        int o = o0;
-                        for (; o + VEC <= o1; o += VEC) {
-                            __m256 dy_vec = _mm256_loadu_ps(dyrow + o);
-                            __m256 w_vec  = _mm256_loadu_ps(W + (size_t)i * Out + o);
-                            acc = _mm256_fmadd_ps(dy_vec, w_vec, acc);
-                        }
-                        float tmp[VEC];
-                        _mm256_storeu_ps(tmp, acc);
-                        float sum = tmp[0]+tmp[1]+tmp[2]+tmp[3]+tmp[4]+tmp[5]+tmp[6]+tmp[7];
-                        for (; o < o1; ++o) sum += dyrow[o] * W[i * Out + o];
-                        dxrow[i] += sum;
-                    }
-                } // b
-            } // o0
-        } // i0
-    } // b0
+    gemm_impl_optimized(0, 1, B, In, Out, 1.f, dY, Out, W, Out, 0.f, dX, In);
 }
 
 // Compute db = sum_rows(dY)  (1 x Out)
-void linear_db_impl_optimized(const float* dY, float* db, int B, int Out) {
+void linear_db_impl_optimized(const float* dY, float* db, int64_t B, int64_t Out) {
     assert(dY && db);
     if (B <= 0 || Out <= 0) return;
 
-    const int VEC = 8;
+    const int64_t VEC = 8;
     // zero
     std::fill(db, db + Out, 0.0f);
 
     // Accumulate in parallel with per-thread local buffer to avoid atomic adds
-    int num_threads = omp_get_max_threads();
+    int64_t num_threads = omp_get_max_threads();
     std::vector<std::vector<float>> local(num_threads, std::vector<float>(Out, 0.0f));
 
     #pragma omp parallel
     {
-        int tid = omp_get_thread_num();
+        int64_t tid = omp_get_thread_num();
         auto &loc = local[tid];
 
         #pragma omp for schedule(static)
-        for (int b = 0; b < B; ++b) {
+        for (int64_t b = 0; b < B; ++b) {
             const float* dyrow = dY + (size_t)b * Out;
-            int o = 0;
+            int64_t o = 0;
             for (; o + VEC <= Out; o += VEC) {
                 __m256 v = _mm256_loadu_ps(dyrow + o);
                 __m256 cur = _mm256_loadu_ps(&loc[o]);
@@ -1106,16 +878,226 @@ void linear_db_impl_optimized(const float* dY, float* db, int B, int Out) {
     } // parallel
 
     // reduce locals into db
-    for (int t = 0; t < num_threads; ++t) {
-        for (int o = 0; o < Out; ++o) db[o] += local[t][o];
+    for (int64_t t = 0; t < num_threads; ++t) {
+        for (int64_t o = 0; o < Out; ++o) db[o] += local[t][o];
+    }
+}
+
+/**
+ * General GEMM (ABI v3): C = alpha * op(A) @ op(B) + beta * C, row-major
+ * with leading dimensions, for all four transpose pairs.
+ *
+ * GotoBLAS-style blocking around one 6x16 AVX2 micro-kernel. For each
+ * KC-deep slice of K, a KCxNC block of op(B) is packed into NR-wide
+ * panels (shared by the team), and each thread packs MCxKC blocks of
+ * op(A), scaled by alpha, into MR-tall panels. The transposes are
+ * absorbed by the packing routines, so the micro-kernel only ever sees
+ * contiguous panels; beta is applied on the first K slice.
+ */
+static const int64_t GEMM_MR = 6;
+static const int64_t GEMM_NR = 16;
+static const int64_t GEMM_MC = 96;     // A block: MC x KC floats stay in L2
+static const int64_t GEMM_KC = 256;    // B micro-panel: KC x NR floats stay in L1
+static const int64_t GEMM_NC = 2048;   // B block: KC x NC floats in L3
+
+// op(A)[i0.., p0..] -> MR-row panels, p-major inside a panel, zero-padded.
+static void gemm_pack_a(int trans_a, const float* A, int64_t lda, int64_t i0, int64_t mc,
+                        int64_t p0, int64_t kc, float alpha, float* Ap) {
+    for (int64_t ir = 0; ir < mc; ir += GEMM_MR) {
+        const int64_t mr = std::min(GEMM_MR, mc - ir);
+        float* dst = Ap + ir * kc;
+        for (int64_t p = 0; p < kc; ++p) {
+            int64_t r = 0;
+            if (trans_a) {
+                const float* src = A + (p0 + p) * lda + i0 + ir;
+                for (; r < mr; ++r) dst[p * GEMM_MR + r] = alpha * src[r];
+            } else {
+                const float* src = A + (i0 + ir) * lda + p0 + p;
+                for (; r < mr; ++r) dst[p * GEMM_MR + r] = alpha * src[r * lda];
+            }
+            for (; r < GEMM_MR; ++r) dst[p * GEMM_MR + r] = 0.f;
+        }
+    }
+}
+
+// op(B)[p0.., j0 + jr..] -> one NR-column panel, p-major, zero-padded.
+static void gemm_pack_b_panel(int trans_b, const float* B, int64_t ldb, int64_t p0, int64_t kc,
+                              int64_t j, int64_t nr, float* dst) {
+    if (trans_b) {
+        int64_t c = 0;
+        for (; c < nr; ++c) {
+            const float* src = B + (j + c) * ldb + p0;
+            for (int64_t p = 0; p < kc; ++p) dst[p * GEMM_NR + c] = src[p];
+        }
+        for (; c < GEMM_NR; ++c)
+            for (int64_t p = 0; p < kc; ++p) dst[p * GEMM_NR + c] = 0.f;
+    } else {
+        for (int64_t p = 0; p < kc; ++p) {
+            const float* src = B + (p0 + p) * ldb + j;
+            float* d = dst + p * GEMM_NR;
+            int64_t c = 0;
+            for (; c < nr; ++c) d[c] = src[c];
+            for (; c < GEMM_NR; ++c) d[c] = 0.f;
+        }
+    }
+}
+
+// c[0..6) x [0..16) = a-panel @ b-panel + beta * c  (beta == 0: c not read)
+static inline void gemm_micro_6x16(int64_t kc, const float* a, const float* b,
+                                   float* c, int64_t ldc, float beta) {
+    __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+    __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+    __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+    __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+    __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+    __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+    for (int64_t p = 0; p < kc; ++p) {
+        const __m256 b0 = _mm256_loadu_ps(b), b1 = _mm256_loadu_ps(b + 8);
+        __m256 av;
+        av = _mm256_broadcast_ss(a + 0); c00 = _mm256_fmadd_ps(av, b0, c00); c01 = _mm256_fmadd_ps(av, b1, c01);
+        av = _mm256_broadcast_ss(a + 1); c10 = _mm256_fmadd_ps(av, b0, c10); c11 = _mm256_fmadd_ps(av, b1, c11);
+        av = _mm256_broadcast_ss(a + 2); c20 = _mm256_fmadd_ps(av, b0, c20); c21 = _mm256_fmadd_ps(av, b1, c21);
+        av = _mm256_broadcast_ss(a + 3); c30 = _mm256_fmadd_ps(av, b0, c30); c31 = _mm256_fmadd_ps(av, b1, c31);
+        av = _mm256_broadcast_ss(a + 4); c40 = _mm256_fmadd_ps(av, b0, c40); c41 = _mm256_fmadd_ps(av, b1, c41);
+        av = _mm256_broadcast_ss(a + 5); c50 = _mm256_fmadd_ps(av, b0, c50); c51 = _mm256_fmadd_ps(av, b1, c51);
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+    const __m256 vb = _mm256_set1_ps(beta);
+    auto store = [&](float* row, __m256 v0, __m256 v1) {
+        if (beta != 0.f) {
+            v0 = _mm256_fmadd_ps(vb, _mm256_loadu_ps(row), v0);
+            v1 = _mm256_fmadd_ps(vb, _mm256_loadu_ps(row + 8), v1);
+        }
+        _mm256_storeu_ps(row, v0);
+        _mm256_storeu_ps(row + 8, v1);
+    };
+    store(c + 0 * ldc, c00, c01);
+    store(c + 1 * ldc, c10, c11);
+    store(c + 2 * ldc, c20, c21);
+    store(c + 3 * ldc, c30, c31);
+    store(c + 4 * ldc, c40, c41);
+    store(c + 5 * ldc, c50, c51);
+}
+
+void gemm_impl_optimized(int trans_a, int trans_b, int64_t M, int64_t N, int64_t K,
+                         float alpha, const float* A, int64_t lda,
+                         const float* B, int64_t ldb,
+                         float beta, float* C, int64_t ldc)
+{
+    if (M <= 0 || N <= 0) return;
+    if (K <= 0 || alpha == 0.f) {
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < M; ++i) {
+            float* c = C + i * ldc;
+            if (beta == 0.f)      std::fill(c, c + N, 0.f);
+            else if (beta != 1.f) for (int64_t j = 0; j < N; ++j) c[j] *= beta;
+        }
+        return;
+    }
+
+    // Per calling thread: the packed B block, shared by its OpenMP team.
+    thread_local std::vector<float> Bp;
+    for (int64_t jc = 0; jc < N; jc += GEMM_NC) {
+        const int64_t nc = std::min(GEMM_NC, N - jc);
+        const int64_t n_panels = (nc + GEMM_NR - 1) / GEMM_NR;
+        for (int64_t pc = 0; pc < K; pc += GEMM_KC) {
+            const int64_t kc = std::min(GEMM_KC, K - pc);
+            const float beta_k = pc == 0 ? beta : 1.f;
+            if (Bp.size() < size_t(n_panels * GEMM_NR * kc)) Bp.resize(size_t(n_panels * GEMM_NR * kc));
+            float* bp = Bp.data();
+
+            #pragma omp parallel
+            {
+                #pragma omp for schedule(static)
+                for (int64_t jp = 0; jp < n_panels; ++jp) {
+                    const int64_t j = jp * GEMM_NR;
+                    gemm_pack_b_panel(trans_b, B, ldb, pc, kc, jc + j, std::min(GEMM_NR, nc - j), bp + j * kc);
+                }
+
+                thread_local std::vector<float> Ap;
+                if (Ap.size() < size_t(GEMM_MC * GEMM_KC)) Ap.resize(size_t(GEMM_MC * GEMM_KC));
+                alignas(32) float tile[GEMM_MR * GEMM_NR];
+
+                #pragma omp for schedule(dynamic)
+                for (int64_t ic = 0; ic < M; ic += GEMM_MC) {
+                    const int64_t mc = std::min(GEMM_MC, M - ic);
+                    gemm_pack_a(trans_a, A, lda, ic, mc, pc, kc, alpha, Ap.data());
+                    for (int64_t jr = 0; jr < nc; jr += GEMM_NR) {
+                        const int64_t nr = std::min(GEMM_NR, nc - jr);
+                        const float* b = bp + jr * kc;
+                        for (int64_t ir = 0; ir < mc; ir += GEMM_MR) {
+                            const int64_t mr = std::min(GEMM_MR, mc - ir);
+                            const float* a = Ap.data() + ir * kc;
+                            float* c = C + (ic + ir) * ldc + jc + jr;
+                            if (mr == GEMM_MR && nr == GEMM_NR) {
+                                gemm_micro_6x16(kc, a, b, c, ldc, beta_k);
+                                continue;
+                            }
+                            // Edge tile: full tile into a buffer, valid part merged.
+                            gemm_micro_6x16(kc, a, b, tile, GEMM_NR, 0.f);
+                            for (int64_t r = 0; r < mr; ++r)
+                                for (int64_t q = 0; q < nr; ++q) {
+                                    float& dst = c[r * ldc + q];
+                                    dst = tile[r * GEMM_NR + q] + (beta_k == 0.f ? 0.f : beta_k * dst);
+                                }
+                        }
+                    }
+                }
+            }
+        }
     }
 }
 
+// ---------------- legacy 32-bit shims (ABI v1) ----------------
+static void matmul_v1(const float* A, const float* B, float* C, int M, int K, int N) {
+    matmul_impl_optimized(A, B, C, M, K, N);
+}
+static void linear_v1(const float* X, const float* W, const float* b, float* Y, int B, int In, int Out) {
+    linear_impl_optimized(X, W, b, Y, B, In, Out);
+}
+static void matmul_bwd_dA_v1(const float* dC, const float* B, float* dA, int M, int K, int N) {
+    matmul_bwd_dA_impl_optimized(dC, B, dA, M, K, N);
+}
+static void matmul_bwd_dB_v1(const float* A, const float* dC, float* dB, int M, int K, int N) {
+    matmul_bwd_dB_impl_optimized(A, dC, dB, M, K, N);
+}
+static void linear_dW_v1(const float* X, const float* dY, float* dW, int B, int In, int Out) {
+    linear_dW_impl_optimized(X, dY, dW, B, In, Out);
+}
+static void linear_dX_v1(const float* dY, const float* W, float* dX, int B, int In, int Out) {
+    linear_dX_impl_optimized(dY, W, dX, B, In, Out);
+}
+static void linear_db_v1(const float* dY, float* db, int B, int Out) {
+    linear_db_impl_optimized(dY, db, B, Out);
+}
+
 // ---------------- required export ----------------
 // This part exports the new optimized functions.
-AG_EXPORT int ag_get_cpu_kernels_v1(struct ag_cpu_v1* out){
+AG_EXPORT int ag_get_cpu_kernels_v3(struct ag_cpu_v3* out){
   if (!out) return -1;
-    out->abi_version = AG_KERNELS_ABI_V1;
+    ag_cpu_v2 t{};
+    ag_get_cpu_kernels_v2(&t);
+    out->abi_version = AG_KERNELS_ABI_V3;
+    out->relu = t.relu;       out->matmul = t.matmul;   out->gelu = t.gelu;
+    out->leakyrelu = t.leakyrelu; out->sigmoid = t.sigmoid; out->tanh = t.tanh;
+    out->softplus = t.softplus; out->exp = t.exp;       out->log = t.log;
+    out->sqrt = t.sqrt;       out->pow = t.pow;         out->linear = t.linear;
+    out->relu_bwd = t.relu_bwd;           out->leakyrelu_bwd = t.leakyrelu_bwd;
+    out->sigmoid_bwd_from_s = t.sigmoid_bwd_from_s; out->tanh_bwd_from_t = t.tanh_bwd_from_t;
+    out->gelu_bwd = t.gelu_bwd;           out->softplus_bwd = t.softplus_bwd;
+    out->exp_bwd_from_y = t.exp_bwd_from_y; out->log_bwd = t.log_bwd;
+    out->sqrt_bwd_from_y = t.sqrt_bwd_from_y;
+    out->matmul_bwd_dA = t.matmul_bwd_dA; out->matmul_bwd_dB = t.matmul_bwd_dB;
+    out->linear_dW = t.linear_dW;         out->linear_dX = t.linear_dX;
+    out->linear_db = t.linear_db;
+    out->gemm = &gemm_impl_optimized;
+  return 0;
+}
+
+AG_EXPORT int ag_get_cpu_kernels_v2(struct ag_cpu_v2* out){
+  if (!out) return -1;
+    out->abi_version = AG_KERNELS_ABI_V2;
     out->relu   = &relu_impl_optimized;
     out->matmul = &matmul_impl_optimized;
     out->gelu = &gelu_impl_optimized;
@@ -1146,4 +1128,29 @@ AG_EXPORT int ag_get_cpu_kernels_v1(struct ag_cpu_v1* out){
   return 0;
 }
 
+// Kept for hosts built against the v1 header.
+AG_EXPORT int ag_get_cpu_kernels_v1(struct ag_cpu_v1* out){
+  if (!out) return -1;
+    ag_cpu_v2 t{};
+    ag_get_cpu_kernels_v2(&t);
+    out->abi_version = AG_KERNELS_ABI_V1;
+    out->relu = t.relu;   out->gelu = t.gelu;         out->leakyrelu = t.leakyrelu;
+    out->sigmoid = t.sigmoid; out->tanh = t.tanh;     out->softplus = t.softplus;
+    out->exp = t.exp;     out->log = t.log;           out->sqrt = t.sqrt;
+    out->pow = t.pow;
+    out->matmul = &matmul_v1;
+    out->linear = &linear_v1;
+    out->relu_bwd = t.relu_bwd;           out->leakyrelu_bwd = t.leakyrelu_bwd;
+    out->sigmoid_bwd_from_s = t.sigmoid_bwd_from_s; out->tanh_bwd_from_t = t.tanh_bwd_from_t;
+    out->gelu_bwd = t.gelu_bwd;           out->softplus_bwd = t.softplus_bwd;
+    out->exp_bwd_from_y = t.exp_bwd_from_y; out->log_bwd = t.log_bwd;
+    out->sqrt_bwd_from_y = t.sqrt_bwd_from_y;
+    out->matmul_bwd_dA = &matmul_bwd_dA_v1;
+    out->matmul_bwd_dB = &matmul_bwd_dB_v1;
+    out->linear_dW = &linear_dW_v1;
+    out->linear_dX = &linear_dX_v1;
+    out->linear_db = &linear_db_v1;
+  return 0;
+}
+
 } // extern "C"
\ No newline at end of file